@@ -0,0 +1,176 @@
+// codec_bench.cpp - Benchmark codec JPEG paralel per jumlah thread:
+// encoder segmen restart dan decoder yang memakai restart marker (original kamera)
+// Pemakaian: bin/codec-bench [foto.jpg ...]   (tanpa argumen: gambar sintetis)
+
+#include "../include/jpeg_codec.h"
+#include "../include/parallel.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Gradien + tekstur supaya entropy coding tidak trivial
+void syntheticImage(int w, int h, std::vector<unsigned char>& rgba) {
+    rgba.resize((size_t)w * h * 4);
+    unsigned seed = 12345;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            seed = seed * 1103515245u + 12345u;
+            const int noise = (int)((seed >> 16) & 31) - 16;
+            unsigned char* p = rgba.data() + ((size_t)y * w + x) * 4;
+            p[0] = (unsigned char)std::max(0, std::min(255, x * 255 / w + noise));
+            p[1] = (unsigned char)std::max(0, std::min(255, y * 255 / h + noise));
+            p[2] = (unsigned char)std::max(0, std::min(255, (int)(128 + 100 * std::sin(x * 0.01 + y * 0.02)) + noise));
+            p[3] = 255;
+        }
+    }
+}
+
+bool decodeRgb(const std::vector<unsigned char>& jpeg, std::vector<unsigned char>& rgb) {
+    int w = 0, h = 0;
+    return jpegDecodeScaled(jpeg.data(), jpeg.size(), 1, 3, rgb, w, h);
+}
+
+template <typename Fn>
+double bestOf(int runs, Fn fn) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        if (!fn()) return -1.0;
+        best = std::min(best, elapsedMs(start));
+    }
+    return best;
+}
+
+void benchEncode(const std::vector<unsigned char>& rgba, int w, int h) {
+    const double mp = (double)w * h / 1e6;
+    std::cout << "\n== Encode " << w << "x" << h << " RGBA q90 (" << mp << " MP) ==" << std::endl;
+
+    // Referensi: encoder tunggal dengan restart interval yang sama -> hasil decode harus identik
+    std::vector<unsigned char> reference, referenceRgb;
+    JpegScanlineWriter ref;
+    if (!ref.begin(reference, w, h, 4, 90, 1) || !ref.writeRows(rgba.data(), h, (size_t)w * 4) || !ref.finish() ||
+        !decodeRgb(reference, referenceRgb)) {
+        std::cout << "reference encode failed" << std::endl;
+        return;
+    }
+
+    double base = 0.0;
+    const unsigned maxThreads = std::max(4u, parallelThreads());
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        std::vector<unsigned char> out;
+        const double ms = bestOf(3, [&] {
+            return jpegEncodeParallel(rgba.data(), w, h, 4, (size_t)w * 4, 90, out, threads);
+        });
+        if (ms < 0) {
+            std::cout << "threads=" << threads << " encode failed" << std::endl;
+            continue;
+        }
+        if (threads == 1) base = ms;
+        std::vector<unsigned char> rgb;
+        const bool valid = decodeRgb(out, rgb);
+        const char* check = !valid ? "DECODE FAILED" : (threads == 1 ? "-" : (rgb == referenceRgb ? "identical" : "DIFFERENT"));
+        printf("threads=%-2u %8.1f ms %7.1f MP/s  speedup %.2fx  %7zu KB  decode-check: %s\n",
+               threads, ms, mp / (ms / 1000.0), base / ms, out.size() / 1024, check);
+    }
+
+    // Jalur streaming yang dipakai renderer: baris datang per strip
+    std::vector<unsigned char> out, rgb;
+    const unsigned streamThreads = std::max(2u, parallelThreads());
+    const double ms = bestOf(3, [&] {
+        ParallelJpegWriter writer;
+        if (!writer.begin(out, w, h, 4, 90, streamThreads)) return false;
+        for (int y = 0; y < h; y += 64) {
+            if (!writer.writeRows(rgba.data() + (size_t)y * w * 4, std::min(64, h - y), (size_t)w * 4)) return false;
+        }
+        return writer.finish();
+    });
+    printf("streaming ParallelJpegWriter threads=%u %8.1f ms  decode-check: %s\n", streamThreads, ms,
+           decodeRgb(out, rgb) && rgb == referenceRgb ? "identical" : "DIFFERENT");
+}
+
+void benchDecode(const std::string& name, const std::vector<unsigned char>& jpeg) {
+    JpegScanlineReader header;
+    if (!header.openMemory(jpeg.data(), jpeg.size())) {
+        std::cout << name << ": not a JPEG" << std::endl;
+        return;
+    }
+    const int w = header.imageWidth(), h = header.imageHeight();
+    const double mp = (double)w * h / 1e6;
+    std::cout << "\n== Decode " << name << " " << w << "x" << h << " (" << mp << " MP), restart interval "
+              << header.restartInterval() << " MCU ==" << std::endl;
+
+    for (int denom : {1, 2}) {
+        std::vector<unsigned char> reference;
+        int rw = 0, rh = 0;
+        double base = 0.0;
+        const unsigned maxThreads = std::max(4u, parallelThreads());
+        for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+            std::vector<unsigned char> out;
+            int ow = 0, oh = 0;
+            const double ms = bestOf(3, [&] {
+                return jpegDecodeScaled(jpeg.data(), jpeg.size(), denom, 4, out, ow, oh, threads);
+            });
+            if (ms < 0) {
+                std::cout << "threads=" << threads << " decode failed" << std::endl;
+                continue;
+            }
+            if (threads == 1) {
+                base = ms;
+                reference.swap(out);
+                rw = ow; rh = oh;
+                printf("1/%d threads=%-2u %8.1f ms %7.1f MP/s  speedup 1.00x  %dx%d\n", denom, threads, ms, mp / (ms / 1000.0), rw, rh);
+                continue;
+            }
+            printf("1/%d threads=%-2u %8.1f ms %7.1f MP/s  speedup %.2fx  check: %s\n", denom, threads, ms, mp / (ms / 1000.0),
+                   base / ms, (ow == rw && oh == rh && out == reference) ? "identical" : "DIFFERENT");
+        }
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::cout << "hardware threads: " << parallelThreads() << std::endl;
+    int w = 3000, h = 4500;
+    std::vector<unsigned char> rgba;
+    if (argc > 1) {
+        std::vector<unsigned char> file;
+        if (!readFileBytes(argv[1], file) || !jpegDecodeScaled(file.data(), file.size(), 1, 4, rgba, w, h)) {
+            std::cerr << "cannot decode " << argv[1] << std::endl;
+            return 1;
+        }
+    } else {
+        syntheticImage(w, h, rgba);
+    }
+    benchEncode(rgba, w, h);
+
+    if (argc > 1) {
+        for (int i = 1; i < argc; ++i) {
+            std::vector<unsigned char> file;
+            if (readFileBytes(argv[i], file)) benchDecode(argv[i], file);
+        }
+        return 0;
+    }
+    // Tanpa file kamera: 24 MP sintetis dengan DRI satu baris MCU (seperti banyak DSLR) dan tanpa DRI
+    w = 6000; h = 4000;
+    syntheticImage(w, h, rgba);
+    for (int restartRows : {1, 0}) {
+        std::vector<unsigned char> jpeg;
+        JpegScanlineWriter writer;
+        if (!writer.begin(jpeg, w, h, 4, 92, restartRows) || !writer.writeRows(rgba.data(), h, (size_t)w * 4) || !writer.finish()) {
+            std::cerr << "synthetic encode failed" << std::endl;
+            return 1;
+        }
+        benchDecode(restartRows ? "synthetic-dri" : "synthetic-nodri", jpeg);
+    }
+    return 0;
+}
@@ -0,0 +1,255 @@
+// effects_bench.cpp - Benchmark kernel efek per megapiksel: jalur SIMD vs skalar, satu thread vs
+// semua thread, plus cek bahwa hasil SIMD identik dengan skalar dan EffectPipeline::runTiled
+// identik dengan run (halo tile blur/sharpen, grid pixelate, segmen geometri)
+// Pemakaian: bin/effects-bench [foto.jpg]   (tanpa argumen: gambar sintetis 24 MP dan 2 MP)
+
+#include "../include/server.h"
+#include "../include/effect_kernels.h"
+#include "../include/color_lut.h"
+#include "../include/jpeg_codec.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::function<void(std::vector<unsigned char>& rgb, int w, int h, unsigned threads)> Effect;
+
+struct NamedEffect {
+    const char* name;
+    Effect run;
+};
+
+double elapsedMs(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void syntheticImage(int w, int h, std::vector<unsigned char>& rgb) {
+    rgb.resize((size_t)w * h * 3);
+    unsigned seed = 12345;
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            seed = seed * 1103515245u + 12345u;
+            const int noise = (int)((seed >> 16) & 31) - 16;
+            unsigned char* p = rgb.data() + ((size_t)y * w + x) * 3;
+            p[0] = (unsigned char)std::max(0, std::min(255, x * 255 / w + noise));
+            p[1] = (unsigned char)std::max(0, std::min(255, y * 255 / h + noise));
+            p[2] = (unsigned char)std::max(0, std::min(255, (int)(128 + 100 * std::sin(x * 0.01 + y * 0.02)) + noise));
+        }
+    }
+}
+
+// Look "warm" sintetis 33^3 dalam format .cube: kurva S, bayangan ke teal, highlight ke oranye
+std::string gradedCube(int size) {
+    std::ostringstream out;
+    out << "TITLE \"bench warm\"\nLUT_3D_SIZE " << size << "\n";
+    for (int b = 0; b < size; ++b) {
+        for (int g = 0; g < size; ++g) {
+            for (int r = 0; r < size; ++r) {
+                const double in[3] = {r / (size - 1.0), g / (size - 1.0), b / (size - 1.0)};
+                const double luma = 0.299 * in[0] + 0.587 * in[1] + 0.114 * in[2];
+                const double tint[3] = {0.08 * (luma - 0.4), 0.01, -0.06 * (luma - 0.4)};
+                out << std::fixed;
+                for (int c = 0; c < 3; ++c) {
+                    const double s = in[c] * in[c] * (3.0 - 2.0 * in[c]);
+                    out << (c ? " " : "") << std::min(1.0, std::max(0.0, 0.5 * in[c] + 0.5 * s + tint[c]));
+                }
+                out << "\n";
+            }
+        }
+    }
+    return out.str();
+}
+
+const ColorLut& benchLut() {
+    static ColorLut lut;
+    if (lut.size == 0) {
+        const std::string text = gradedCube(33);
+        std::string error;
+        auto start = std::chrono::steady_clock::now();
+        if (!parseCubeLut(text, lut, error)) {
+            std::cerr << "LUT parse failed: " << error << std::endl;
+            lut = identityLut(33);
+        } else {
+            std::cout << "parse .cube 33^3 (" << text.size() / 1024 << " KB): " << elapsedMs(start) << " ms" << std::endl;
+        }
+    }
+    return lut;
+}
+
+Effect remap(void (*fn)(const unsigned char*, unsigned char*, int, int, float, unsigned), float strength) {
+    return [fn, strength](std::vector<unsigned char>& rgb, int w, int h, unsigned threads) {
+        std::vector<unsigned char> out(rgb.size());
+        fn(rgb.data(), out.data(), w, h, strength, threads);
+        rgb.swap(out);
+    };
+}
+
+std::vector<NamedEffect> effects() {
+    std::vector<NamedEffect> list;
+    list.push_back({"grayscale", [](std::vector<unsigned char>& rgb, int w, int h, unsigned t) { grayscaleImage(rgb.data(), w, h, 128, t); }});
+    list.push_back({"sepia", [](std::vector<unsigned char>& rgb, int w, int h, unsigned t) { sepiaImage(rgb.data(), w, h, 100, t); }});
+    list.push_back({"invert", [](std::vector<unsigned char>& rgb, int w, int h, unsigned t) { invertImage(rgb.data(), w, h, 128, t); }});
+    list.push_back({"lut 33", [](std::vector<unsigned char>& rgb, int w, int h, unsigned t) { lutImage(rgb.data(), w, h, benchLut(), 128, t); }});
+    list.push_back({"vignette", [](std::vector<unsigned char>& rgb, int w, int h, unsigned t) { vignetteImage(rgb.data(), w, h, 1.0f, t); }});
+    // Rantai sepia + LUT + vignette: dilebur (sekali lewat per chunk) vs tiga pass terpisah
+    list.push_back({"chain fused", [](std::vector<unsigned char>& rgb, int w, int h, unsigned t) {
+        std::vector<PointOp> ops(3);
+        ops[0].kind = PointOp::Sepia;
+        ops[0].amount = 100;
+        ops[1].kind = PointOp::Lut;
+        ops[1].lut = &benchLut();
+        ops[2].kind = PointOp::Vignette;
+        ops[2].strength = 1.0f;
+        pointOpsImage(rgb.data(), w, h, ops, t);
+    }});
+    list.push_back({"chain 3-pass", [](std::vector<unsigned char>& rgb, int w, int h, unsigned t) {
+        sepiaImage(rgb.data(), w, h, 100, t);
+        lutImage(rgb.data(), w, h, benchLut(), 128, t);
+        vignetteImage(rgb.data(), w, h, 1.0f, t);
+    }});
+    // Sigma 2..64: waktu per MP harus hampir sama
+    list.push_back({"blur s2", [](std::vector<unsigned char>& rgb, int w, int h, unsigned t) { gaussianBlurImage(rgb.data(), w, h, 2.0f, t); }});
+    list.push_back({"blur s8", [](std::vector<unsigned char>& rgb, int w, int h, unsigned t) { gaussianBlurImage(rgb.data(), w, h, 8.0f, t); }});
+    list.push_back({"blur s64", [](std::vector<unsigned char>& rgb, int w, int h, unsigned t) { gaussianBlurImage(rgb.data(), w, h, 64.0f, t); }});
+    list.push_back({"unsharp", [](std::vector<unsigned char>& rgb, int w, int h, unsigned t) { unsharpMaskImage(rgb.data(), w, h, 3.0f, 128, t); }});
+    list.push_back({"pixelate", [](std::vector<unsigned char>& rgb, int w, int h, unsigned t) { pixelateImage(rgb.data(), w, h, 31, t); }});
+    list.push_back({"fisheye", [](std::vector<unsigned char>& rgb, int w, int h, unsigned t) {
+        std::vector<unsigned char> out(rgb.size());
+        fisheyeImage(rgb.data(), out.data(), w, h, 0.25f, 1.0f, t);
+        rgb.swap(out);
+    }});
+    list.push_back({"wide-angle", remap(wideAngleImage, 0.3f)});
+    return list;
+}
+
+// Waktu terbaik dari beberapa run; output run terakhir dikembalikan lewat result
+double bestOf(int runs, const NamedEffect& effect, const std::vector<unsigned char>& input, int w, int h,
+              unsigned threads, std::vector<unsigned char>& result) {
+    double best = 1e30;
+    for (int i = 0; i < runs; ++i) {
+        result = input;
+        auto start = std::chrono::steady_clock::now();
+        effect.run(result, w, h, threads);
+        best = std::min(best, elapsedMs(start));
+    }
+    return best;
+}
+
+void benchImage(const std::string& label, const std::vector<unsigned char>& rgb, int w, int h) {
+    const double mp = (double)w * h / 1e6;
+    const unsigned all = parallelThreads();
+    std::cout << "\n== " << label << " " << w << "x" << h << " (" << mp << " MP), SIMD path: " << effectSimdPath() << " ==" << std::endl;
+    printf("%-12s %13s %13s %13s %8s  %s\n", "effect", "scalar ms/MP", "simd ms/MP", "simd xN ms/MP", "speedup", "check");
+    const int runs = mp > 8 ? 2 : 4;
+    for (const auto& effect : effects()) {
+        std::vector<unsigned char> scalarOut, simdOut, parallelOut;
+        setEffectForceScalar(true);
+        const double scalarMs = bestOf(runs, effect, rgb, w, h, 1, scalarOut);
+        setEffectForceScalar(false);
+        const double simdMs = bestOf(runs, effect, rgb, w, h, 1, simdOut);
+        const double parallelMs = bestOf(runs, effect, rgb, w, h, all, parallelOut);
+        const char* check = (simdOut == scalarOut && parallelOut == simdOut) ? "identical" : "DIFFERENT";
+        printf("%-12s %13.2f %13.2f %13.2f %7.2fx  %s\n", effect.name, scalarMs / mp, simdMs / mp, parallelMs / mp,
+               scalarMs / simdMs, check);
+    }
+
+    // Tabel remap: panggilan pertama membangun peta, berikutnya hanya sampling
+    for (const auto& effect : effects()) {
+        const std::string name = effect.name;
+        if (name != "fisheye" && name != "wide-angle") continue;
+        std::vector<unsigned char> out = rgb;
+        clearRemapCache();
+        auto start = std::chrono::steady_clock::now();
+        effect.run(out, w, h, all);
+        const double cold = elapsedMs(start);
+        out = rgb;
+        start = std::chrono::steady_clock::now();
+        effect.run(out, w, h, all);
+        const double warm = elapsedMs(start);
+        printf("%-11s remap table: cold %.1f ms, cached %.1f ms, table %.1f MB\n", effect.name, cold, warm,
+               remapCacheBytes() / 1048576.0);
+    }
+}
+
+// Rantai jalur capture: runTiled harus menghasilkan byte yang sama dengan run untuk setiap
+// jumlah thread. Ukuran sengaja bukan kelipatan tinggi tile maupun blok pixelate
+void checkTiled() {
+    const char* chains[] = {
+        "blur:0.6", "sharpen:0.7", "pixelate:0.5", "fisheye:0.6", "wideangle:0.5",
+        "sepia:0.8,blur:0.5,vignette", "pixelate:0.4,blur:0.3", "blur:0.4,fisheye:0.5,sharpen:0.6",
+        "grayscale,wideangle:0.4,pixelate:0.6"
+    };
+    const int sizes[][2] = {{641, 479}, {1917, 1083}, {4003, 2999}};
+    const unsigned threadCounts[] = {1, 3, parallelThreads()};
+    for (const auto& size : sizes) {
+        const int w = size[0], h = size[1];
+        std::vector<unsigned char> rgb;
+        syntheticImage(w, h, rgb);
+        std::cout << "\n== run vs runTiled " << w << "x" << h << " ==" << std::endl;
+        printf("%-36s %9s %9s  %s\n", "chain", "run ms", "tiled ms", "check");
+        for (const char* spec : chains) {
+            std::vector<EffectStep> steps;
+            std::string error;
+            if (!EffectPipeline::parseSteps(spec, steps, error)) {
+                std::cerr << "bad chain " << spec << ": " << error << std::endl;
+                continue;
+            }
+            const EffectPipeline pipeline(steps);
+            ImageData reference;
+            reference.width = w;
+            reference.height = h;
+            reference.data = rgb;
+            auto start = std::chrono::steady_clock::now();
+            pipeline.run(reference);
+            const double runMs = elapsedMs(start);
+            double tiledMs = 0.0;
+            int mismatches = 0;
+            for (unsigned threads : threadCounts) {
+                ImageData tiled;
+                tiled.width = w;
+                tiled.height = h;
+                tiled.data = rgb;
+                start = std::chrono::steady_clock::now();
+                pipeline.runTiled(tiled, 0.0, threads);
+                if (threads == parallelThreads()) tiledMs = elapsedMs(start);
+                if (tiled.data != reference.data) ++mismatches;
+            }
+            printf("%-36s %9.1f %9.1f  %s\n", spec, runMs, tiledMs, mismatches == 0 ? "identical" : "DIFFERENT");
+        }
+    }
+}
+
+}
+
+int main(int argc, char** argv) {
+    std::cout << "hardware threads: " << parallelThreads() << std::endl;
+    std::vector<unsigned char> rgb;
+    if (argc > 1) {
+        std::vector<unsigned char> file;
+        int w = 0, h = 0;
+        if (!readFileBytes(argv[1], file) || !jpegDecodeScaled(file.data(), file.size(), 1, 3, rgb, w, h)) {
+            std::cerr << "cannot decode " << argv[1] << std::endl;
+            return 1;
+        }
+        benchImage(argv[1], rgb, w, h);
+        // Ukuran live view: decode 1/4
+        if (jpegDecodeScaled(file.data(), file.size(), 4, 3, rgb, w, h)) benchImage("preview 1/4", rgb, w, h);
+        checkTiled();
+        return 0;
+    }
+    // Capture 24 MP dan frame live view ~2 MP
+    syntheticImage(6000, 4000, rgb);
+    benchImage("synthetic capture", rgb, 6000, 4000);
+    syntheticImage(1920, 1080, rgb);
+    benchImage("synthetic preview", rgb, 1920, 1080);
+    checkTiled();
+    return 0;
+}
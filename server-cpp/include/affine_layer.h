@@ -0,0 +1,38 @@
+#ifndef AFFINE_LAYER_H
+#define AFFINE_LAYER_H
+
+#include <vector>
+#include <cstdint>
+
+// Layer bitmap dengan transform affine sembarang (skala, rotasi, translasi) ke kanvas.
+// Render memakai inverse mapping: tiap piksel kanvas di dalam bounding box hasil transform
+// dipetakan balik ke tekstur lalu di-sample bilinear. Tekstur disimpan premultiplied dengan
+// border transparan 2 piksel, jadi tepi layer otomatis anti-alias tanpa cabang per piksel.
+class AffineLayer {
+public:
+    // forward = {a, b, c, d, e, f}: x = a*sx + b*sy + c, y = d*sx + e*sy + f,
+    // (sx, sy) koordinat kontinu bitmap w x h. false bila ukuran tidak valid atau matriks singular
+    bool begin(int w, int h, const double forward[6]);
+    // Isi baris y tekstur dari RGBA straight alpha; opacity 0..255 ikut dikalikan
+    void setRow(int y, const unsigned char* rgba, unsigned char opacity = 255);
+    // Blend baris kanvas [y0, y0+rows) ke dst (RGBA, lebar dstW)
+    void drawRows(unsigned char* dst, int dstW, int y0, int rows) const;
+
+    int top() const { return boundsTop; }
+    int bottom() const { return boundsBottom; }
+
+private:
+    int width = 0;
+    int height = 0;
+    int stride = 0;
+    std::vector<uint32_t> texels;
+    double inv[6] = {0, 0, 0, 0, 0, 0};
+    int boundsLeft = 0, boundsTop = 0, boundsRight = 0, boundsBottom = 0;
+};
+
+// Kernel inner loop: sample bilinear (u, v dalam 16.16, koordinat texel) lalu blend
+// premultiplied ke count piksel dst. SSE2 bila tersedia, hasil identik dengan jalur skalar
+void blendAffineSpan(unsigned char* dst, int count, const uint32_t* texels, int stride,
+                     int32_t u, int32_t v, int32_t du, int32_t dv);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef COLOR_LUT_H
+#define COLOR_LUT_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+// 3D LUT (Adobe .cube) yang sudah dikompilasi ke fixed-point untuk lutImage() di effect_kernels.h.
+// Setiap titik kisi dikemas ke satu uint32 (R | G << 10 | B << 20) dengan nilai 0..510 (Q1), jadi
+// interpolasi tetrahedral dengan bobot Q7 (total 128) tetap muat di lane uint16 dan jalur AVX2
+// cukup satu gather per titik sudut.
+struct ColorLut {
+    static const int kMinSize = 2;
+    static const int kMaxSize = 65;
+    static const int kOne = 510;   // nilai lattice untuk 1.0
+
+    std::string title;
+    int size = 0;                  // titik per sumbu
+    std::vector<uint32_t> lattice; // size^3, R berubah paling cepat (urutan baris file .cube)
+    uint16_t positionScale = 0;    // posisi Q7 = ((v << 7) * positionScale) >> 16, v = 0..255
+};
+
+// Parse teks .cube: TITLE, LUT_3D_SIZE, DOMAIN_MIN/DOMAIN_MAX (harus 0..1), lalu size^3 baris "r g b".
+// Nilai di luar 0..1 di-clamp. false + error bila format tidak valid atau tidak didukung (LUT_1D)
+bool parseCubeLut(const std::string& text, ColorLut& lut, std::string& error);
+bool loadCubeLut(const std::string& path, ColorLut& lut, std::string& error);
+// LUT identitas (benchmark / verifikasi hasil interpolasi)
+ColorLut identityLut(int size);
+
+// Direktori LUT (<dir>/<nama>.cube). Hasil parse di-cache per nama dan dimuat ulang bila mtime
+// atau ukuran file berubah; LUT yang sedang dipakai efek tetap hidup lewat shared_ptr
+class LutLibrary {
+public:
+    explicit LutLibrary(const std::string& dir);
+
+    // nama boleh dengan atau tanpa .cube; nullptr + error bila tidak ada / tidak valid
+    std::shared_ptr<const ColorLut> get(const std::string& name, std::string& error);
+    // Nama LUT (tanpa .cube) yang ada di direktori, terurut
+    std::vector<std::string> list() const;
+    const std::string& directory() const { return dir; }
+
+    // Huruf, angka, '-', '_', '.' dan spasi; tanpa path
+    static bool validName(const std::string& name);
+
+private:
+    struct Entry {
+        std::shared_ptr<const ColorLut> lut;
+        int64_t mtime = 0;
+        uint64_t size = 0;
+    };
+
+    static std::string stem(const std::string& name);
+
+    std::string dir;
+    std::mutex mu;
+    std::map<std::string, Entry> cache;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef EFFECT_KERNELS_H
+#define EFFECT_KERNELS_H
+
+#include <cstddef>
+#include <vector>
+
+struct ColorLut;
+
+// Kernel efek foto di server atas buffer RGB 8-bit (3 byte per piksel, baris rapat width*3).
+// Formula mengikuti worker efek di frontend (client/src/workers/imageEffectsWorker.js) supaya
+// hasil capture sama dengan preview di browser.
+// - Operasi titik (matriks warna, 3D LUT, vignette) memecah baris menjadi chunk planar int16 lalu
+//   menghitung 8 (SSE2) atau 16 (AVX2) piksel sekaligus.
+// - Blur, unsharp mask dan pixelate bekerja langsung pada byte interleaved (operasinya sama untuk
+//   ketiga channel), geometri memakai sampling bilinear fixed-point.
+// Semua kernel paralel per pita baris. SSE2/AVX2 dipilih saat kompilasi (AVX2 butuh -mavx2,
+// mis. make ARCH_FLAGS=-march=native); kernel integer menghasilkan byte yang identik dengan
+// jalur skalar. maxThreads 0 = parallelThreads().
+
+// Jalur yang aktif: "avx2", "sse2" atau "scalar"
+const char* effectSimdPath();
+// Paksa jalur skalar (benchmark / verifikasi hasil); default false
+void setEffectForceScalar(bool scalar);
+
+// Satu operasi titik untuk pointOpsImage
+struct PointOp {
+    enum Kind { Grayscale, Sepia, Invert, Lut, Vignette };
+    Kind kind = Grayscale;
+    int amount = 128;               // Grayscale/Sepia/Invert/Lut: 0..128
+    float strength = 0.0f;          // Vignette
+    const ColorLut* lut = nullptr;  // Lut; harus tetap hidup selama pemanggilan
+};
+// Rantai operasi titik dijalankan berurutan pada setiap chunk planar: gambar dibaca/ditulis sekali
+// untuk seluruh rantai. Hasilnya identik dengan memanggil kernel di bawah satu per satu
+void pointOpsImage(unsigned char* rgb, int width, int height, const std::vector<PointOp>& ops, unsigned maxThreads = 0);
+// Sama untuk baris [firstRow, lastRow) dari gambar setinggi height; rows menunjuk ke baris firstRow
+// (mis. tile). Geometri vignette tetap dihitung dari gambar penuh
+void pointOpsRows(unsigned char* rows, int width, int height, int firstRow, int lastRow, const std::vector<PointOp>& ops,
+                  unsigned maxThreads = 0);
+
+// amount 0..128: porsi efek yang di-blend ke piksel asli (128 = penuh)
+void grayscaleImage(unsigned char* rgb, int width, int height, int amount, unsigned maxThreads = 0);
+void sepiaImage(unsigned char* rgb, int width, int height, int amount, unsigned maxThreads = 0);
+void invertImage(unsigned char* rgb, int width, int height, int amount, unsigned maxThreads = 0);
+// 3D LUT (color_lut.h) dengan interpolasi tetrahedral; amount 0..128 seperti di atas
+void lutImage(unsigned char* rgb, int width, int height, const ColorLut& lut, int amount, unsigned maxThreads = 0);
+// Gelap ke tepi: faktor = max(0, 1 - jarak/jarakSudut * strength)
+void vignetteImage(unsigned char* rgb, int width, int height, float strength, unsigned maxThreads = 0);
+
+// Gaussian separable didekati 3 box pass: waktu per piksel konstan untuk sigma berapa pun
+// (maks 100). Horizontal lewat prefix sum per baris, vertikal lewat satu baris running sum
+// yang digeser ke bawah; tepi di-clamp
+void gaussianBlurImage(unsigned char* rgb, int width, int height, float sigma, unsigned maxThreads = 0);
+// Jangkauan blur (px ke tiap sisi): baris di luar jarak ini tidak memengaruhi hasil, jadi tile
+// dengan halo sebesar ini memberi byte yang identik dengan blur gambar penuh
+int gaussianBlurSupport(float sigma);
+// Unsharp mask di atas blur yang sama: out = c + (c - blur(c, sigma)) * amount / 128, amount 0..256
+void unsharpMaskImage(unsigned char* rgb, int width, int height, float sigma, int amount, unsigned maxThreads = 0);
+void pixelateImage(unsigned char* rgb, int width, int height, int blockSize, unsigned maxThreads = 0);
+
+// Distorsi geometri ke dst terpisah (width*height*3). Peta perpindahan fixed-point dihitung sekali
+// per (ukuran, strength, radius) dan di-cache; tiap frame/capture hanya membayar sampling bilinear
+// (gather AVX2 8 piksel sekaligus bila tersedia).
+// Fisheye: barrel di dalam lingkaran radiusScale * 0.9 * min(cx, cy), r' = r * (1 + strength * r^2)
+void fisheyeImage(const unsigned char* src, unsigned char* dst, int width, int height, float strength,
+                  float radiusScale, unsigned maxThreads = 0);
+// Wide angle: barrel satu frame penuh dinormalisasi ke sudut, sudut gambar tetap di tempat
+void wideAngleImage(const unsigned char* src, unsigned char* dst, int width, int height, float strength,
+                    unsigned maxThreads = 0);
+// Total byte tabel remap yang sedang di-cache; clear untuk benchmark build vs cache
+size_t remapCacheBytes();
+void clearRemapCache();
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef EFFECT_VARIANTS_H
+#define EFFECT_VARIANTS_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+class EffectPipeline;
+
+// Versi berefek dari foto capture. Foto asli di uploads/ tidak pernah ditimpa; hasil rantai efek
+// disimpan terpisah di <dir>/<nama>.<id>.jpg dengan id dari inode + ukuran + mtime sumber dan
+// EffectPipeline::signature(), jadi ganti efek cukup render ulang dari foto asli tanpa capture
+// ulang. Render berjalan di satu thread worker (satu foto per waktu; setiap render sudah memakai
+// semua core lewat EffectPipeline::runTiled). Request konkuren untuk varian yang sama menempel ke
+// satu proses render (single-flight).
+class EffectVariantStore {
+public:
+    // path varian di disk, atau "" bila sumber tidak bisa diproses
+    typedef std::function<void(const std::string& path)> Ready;
+
+    explicit EffectVariantStore(const std::string& dir);
+    ~EffectVariantStore();
+
+    // Hentikan worker; render yang masih antri dijawab "" (gagal) supaya tidak ada yang menggantung.
+    // Dipanggil PhotoBoothServer::stop sebelum server WS berhenti agar respons masih terkirim
+    void shutdown();
+    bool isStopping();
+
+    // "" bila sumber tidak ada
+    std::string variantPath(const std::string& sourcePath, const EffectPipeline& pipeline) const;
+    // Varian yang sudah ada langsung dilaporkan dari thread pemanggil; selain itu ready dipanggil
+    // dari thread worker setelah file selesai ditulis
+    void render(const std::string& sourcePath, std::shared_ptr<const EffectPipeline> pipeline, const Ready& ready);
+    // Hapus semua varian efek milik file sumber (foto dihapus dari galeri)
+    void removeFor(const std::string& sourcePath);
+
+private:
+    struct Task {
+        std::string sourcePath;
+        std::string path;
+        std::shared_ptr<const EffectPipeline> pipeline;
+    };
+
+    void workerLoop();
+    void runTask(const Task& task);
+
+    std::string dir;
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<Task> queue;
+    // Varian yang sedang/akan dibuat -> callback yang menunggu
+    std::map<std::string, std::vector<Ready>> inflight;
+    bool stopping = false;
+    std::thread worker;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+#include <ctime>
+
+// Glyph yang sudah di-rasterize ke atlas coverage 8-bit. Pointer pixels stabil
+// selama atlas hidup: halaman atlas tidak pernah dipindah atau ditimpa.
+struct GlyphBitmap {
+    const unsigned char* pixels = nullptr;
+    int stride = 0;
+    int width = 0;
+    int height = 0;
+    int left = 0;       // offset dari pen ke tepi kiri bitmap
+    int top = 0;        // offset dari baseline ke tepi atas bitmap (ke atas positif)
+    long advance = 0;   // 26.6 fixed point
+    unsigned int index = 0;
+};
+
+struct PositionedGlyph {
+    int x = 0;
+    int y = 0;
+    const GlyphBitmap* glyph = nullptr;
+};
+
+class GlyphAtlas;
+
+// Teks yang sudah di-layout; cukup dibuat sekali per render lalu di-blend per strip
+struct TextRun {
+    std::shared_ptr<GlyphAtlas> atlas;
+    std::vector<PositionedGlyph> glyphs;
+    unsigned char r = 255;
+    unsigned char g = 255;
+    unsigned char b = 255;
+    int top = 0;
+    int bottom = 0;
+};
+
+// Atlas per (font, ukuran piksel). Glyph di-rasterize FreeType sekali, render berikutnya
+// hanya membaca coverage dari atlas.
+class GlyphAtlas {
+public:
+    ~GlyphAtlas();
+
+    // Layout UTF-8 dari pen (x, baselineY) dengan kerning; glyph baru di-rasterize on demand
+    bool layout(const std::string& utf8, float x, float baselineY, TextRun& run);
+
+private:
+    friend class GlyphAtlasCache;
+    GlyphAtlas() = default;
+
+    struct Page {
+        std::vector<unsigned char> pixels;
+        int width = 0;
+        int height = 0;
+        int cursorX = 0;
+        int shelfY = 0;
+        int shelfHeight = 0;
+    };
+
+    const GlyphBitmap* glyphLocked(uint32_t codepoint);
+    unsigned char* allocateLocked(int w, int h, int& stride);
+
+    std::mutex mu;
+    std::shared_ptr<void> library;  // FT_Library, harus hidup lebih lama dari face
+    void* face = nullptr;           // FT_Face; disembunyikan supaya header tidak butuh ft2build.h
+    bool hasKerning = false;
+    std::vector<std::unique_ptr<Page>> pages;
+    std::unordered_map<uint32_t, GlyphBitmap> glyphs;
+};
+
+class GlyphAtlasCache {
+public:
+    static GlyphAtlasCache& instance();
+
+    // nullptr bila font tidak bisa dibuka. fontMtime ikut kunci cache supaya font yang diganti
+    // di disk dimuat ulang, bukan dilayani dari face lama
+    std::shared_ptr<GlyphAtlas> acquire(const std::string& fontPath, int pixelSize, time_t fontMtime = 0);
+    size_t size();
+
+private:
+    GlyphAtlasCache();
+
+    std::mutex mu;
+    std::shared_ptr<void> library;
+    std::map<std::string, std::shared_ptr<GlyphAtlas>> atlases;
+};
+
+// Blend warna solid ke baris RGBA dengan coverage 8-bit (SSE2 bila tersedia)
+void blendCoverageRow(unsigned char* dst, const unsigned char* coverage, int count,
+                      unsigned char r, unsigned char g, unsigned char b);
+
+#endif
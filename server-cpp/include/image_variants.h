@@ -0,0 +1,76 @@
+#ifndef IMAGE_VARIANTS_H
+#define IMAGE_VARIANTS_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+// Varian JPEG ukuran kecil dari foto di uploads/ untuk galeri (/uploads/<nama>?w=320&q=70).
+// File varian disimpan di <dir>/<nama>.<id sumber>.w<lebar>q<kualitas>.jpg; id sumber diturunkan dari
+// inode + ukuran + mtime, jadi foto yang ditimpa otomatis mendapat varian baru.
+// Pembuatan berjalan di satu thread worker: permintaan on-demand didahulukan, ukuran eager
+// (setelah capture/upload) diantrikan di belakang. Request konkuren untuk varian yang sama
+// menempel ke satu proses generate (single-flight).
+class ImageVariantStore {
+public:
+    // path varian di disk, atau "" bila sumber tidak bisa di-decode
+    typedef std::function<void(const std::string& path)> Ready;
+
+    ImageVariantStore(const std::string& dir, const std::vector<int>& eagerWidths, int eagerQuality);
+    ~ImageVariantStore();
+
+    // Hentikan worker; varian yang masih antri dijawab "" (gagal) supaya tidak ada yang menggantung.
+    // Dipanggil WebSocketServer::stop sebelum server berhenti agar respons yang ditahan masih terkirim
+    void shutdown();
+    bool isStopping();
+
+    // Parameter query ke lebar/kualitas kanonik: lebar dibulatkan ke atas kelipatan 16 (16..2560),
+    // kualitas kelipatan 5 (30..95, default 75). false bila nilainya bukan angka
+    static bool normalize(const std::string& widthParam, const std::string& qualityParam, int& width, int& quality);
+
+    // true + path bila varian sudah ada di disk. false bila perlu dibuat (path tetap diisi) atau
+    // sumber tidak ada (path kosong)
+    bool lookup(const std::string& sourcePath, int width, int quality, std::string& path);
+    // Buat varian di thread worker; ready dipanggil dari thread itu
+    void generate(const std::string& sourcePath, int width, int quality, const Ready& ready);
+    // Antrikan ukuran eager untuk foto baru; decode dilakukan sekali untuk semua ukuran
+    void warm(const std::string& sourcePath);
+    // Hapus semua varian milik file sumber (foto dihapus dari galeri)
+    void removeFor(const std::string& sourcePath);
+
+private:
+    struct Target {
+        std::string path;
+        int width = 0;
+        int quality = 0;
+    };
+    struct Task {
+        std::string sourcePath;
+        std::vector<Target> targets;
+    };
+
+    std::string variantPath(const std::string& sourcePath, int width, int quality) const;
+    void enqueue(Task&& task, bool urgent);
+    void workerLoop();
+    void runTask(const Task& task);
+
+    std::string dir;
+    std::vector<int> eagerWidths;
+    int eagerQuality;
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<Task> queue;
+    // Varian yang sedang/akan dibuat -> callback yang menunggu
+    std::map<std::string, std::vector<Ready>> inflight;
+    bool stopping = false;
+    std::thread worker;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef JPEG_CODEC_H
+#define JPEG_CODEC_H
+
+#include <string>
+#include <vector>
+#include <memory>
+
+// Helper JPEG berbasis libjpeg(-turbo). Dipakai renderer dan pipeline foto
+// untuk decode yang sadar ukuran target (DCT scaling 1/2, 1/4, 1/8).
+
+bool readFileBytes(const std::string& path, std::vector<unsigned char>& out);
+bool isJpegData(const unsigned char* data, size_t size);
+
+// Baca dimensi dari header JPEG tanpa decode
+bool jpegReadDimensions(const unsigned char* data, size_t size, int& width, int& height);
+
+// Denominator terbesar (1, 2, 4, 8) yang hasil decode-nya masih >= minW x minH.
+// minW/minH <= 0 berarti tidak ada batas pada sumbu tersebut.
+int jpegChooseScaleDenom(int width, int height, int minW, int minH);
+
+// Decode JPEG pada skala 1/scaleDenom langsung ke RGB (channels=3) atau RGBA (channels=4).
+// JPEG baseline dengan restart marker (DRI) di-decode paralel per kelompok baris MCU langsung
+// ke buffer tujuan; tanpa restart marker jatuh ke decode satu thread. maxThreads 0 = parallelThreads()
+bool jpegDecodeScaled(const unsigned char* data, size_t size, int scaleDenom, int channels,
+                      std::vector<unsigned char>& out, int& outW, int& outH, unsigned maxThreads = 0);
+
+// Decoder baris-per-baris: hanya buffer internal libjpeg yang tinggal di memori
+class JpegScanlineReader {
+public:
+    JpegScanlineReader();
+    ~JpegScanlineReader();
+
+    bool open(const std::string& path);
+    bool openMemory(const unsigned char* data, size_t size);
+    int imageWidth() const;
+    int imageHeight() const;
+    // Restart interval dalam MCU (0 = tanpa DRI); tersedia setelah open
+    int restartInterval() const;
+
+    bool start(int scaleDenom, int channels);
+    int width() const;
+    int height() const;
+    bool readRow(unsigned char* row);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+// Encoder baris-per-baris; input RGB/RGBA dikonsumsi langsung tanpa salinan RGB penuh.
+// restartRows > 0 menulis marker RSTn setiap restartRows baris MCU
+class JpegScanlineWriter {
+public:
+    JpegScanlineWriter();
+    ~JpegScanlineWriter();
+
+    bool begin(std::vector<unsigned char>& out, int width, int height, int channels, int quality, int restartRows = 0);
+    bool writeRows(const unsigned char* rows, int count, size_t stride);
+    bool finish();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+// Encoder paralel untuk output besar. Gambar dipecah per kJpegSegmentRows baris; tiap segmen
+// di-encode di thread sendiri dengan state Huffman sendiri dan restart interval = satu baris MCU,
+// lalu entropy segment-nya disambung dengan RSTn menjadi satu JPEG baseline yang valid.
+// Dengan satu core (atau gambar kecil) jatuh ke JpegScanlineWriter biasa.
+const int kJpegSegmentRows = 256;
+
+class ParallelJpegWriter {
+public:
+    ParallelJpegWriter();
+    ~ParallelJpegWriter();
+
+    // maxThreads 0 = parallelThreads()
+    bool begin(std::vector<unsigned char>& out, int width, int height, int channels, int quality,
+               unsigned maxThreads = 0);
+    // Baris disalin ke buffer segmen; segmen penuh langsung dikirim ke worker
+    bool writeRows(const unsigned char* rows, int count, size_t stride);
+    bool finish();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+// Encode gambar penuh di memori dengan skema segmen yang sama, tanpa menyalin piksel
+bool jpegEncodeParallel(const unsigned char* pixels, int width, int height, int channels, size_t stride,
+                        int quality, std::vector<unsigned char>& out, unsigned maxThreads = 0);
+
+// Decoder + encoder untuk aliran frame (live view MJPEG). Handle libjpeg dibuat sekali dan dipakai
+// ulang per frame, jadi tidak ada create/destroy, alokasi tabel, maupun buffer output baru per frame.
+// IDCT/FDCT integer cepat dan tanpa fancy upsampling: selisih kualitas tidak terlihat di preview.
+// Tidak thread-safe; satu instance per thread pemroses
+class JpegFrameCodec {
+public:
+    JpegFrameCodec();
+    ~JpegFrameCodec();
+
+    // RGB pada skala 1/scaleDenom (1, 2, 4, 8) ke rgb (kapasitasnya dipakai ulang)
+    bool decode(const unsigned char* data, size_t size, int scaleDenom, std::vector<unsigned char>& rgb,
+                int& width, int& height);
+    bool encode(const unsigned char* rgb, int width, int height, int quality, std::vector<unsigned char>& out);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
+#endif
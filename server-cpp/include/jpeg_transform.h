@@ -0,0 +1,39 @@
+#ifndef JPEG_TRANSFORM_H
+#define JPEG_TRANSFORM_H
+
+#include <cstddef>
+#include <vector>
+
+// Operasi JPEG di domain koefisien DCT (jpeg_read_coefficients / jpeg_write_coefficients):
+// tanpa decode ke piksel, tanpa IDCT/FDCT dan tanpa kuantisasi ulang. Mirror dan rotasi adalah
+// permutasi blok 8x8 plus transpose/tanda koefisien, jadi lossless. Seperti jpegtran -trim, tepi
+// yang tidak genap satu iMCU (8 atau 16 px) dibuang pada sumbu yang dibalik, dan crop dimulai di
+// batas iMCU. Output baseline dengan restart marker per baris MCU (decode paralel jpeg_codec.h).
+struct JpegCoefTransform {
+    bool grayscale = false;   // buang plane Cb/Cr, tinggal luma
+    bool mirror = false;      // cermin horizontal (preview selfie), sebelum rotasi
+    int rotate = 0;           // 0, 90, 180, 270 derajat searah jarum jam
+    // Crop dalam koordinat sumber (sebelum mirror/rotasi); aktif bila lebar dan tinggi > 0.
+    // Awal dibulatkan turun ke batas iMCU
+    int cropX = 0;
+    int cropY = 0;
+    int cropWidth = 0;
+    int cropHeight = 0;
+    // Ukuran sel pixelate (px, dibulatkan ke kelipatan iMCU terdekat) dari rata-rata koefisien DC;
+    // 0 = mati. Sel dihitung di koordinat output
+    int pixelate = 0;
+
+    bool identity() const;
+    // Orientasi EXIF 1..8 -> mirror + rotate yang menegakkan gambar
+    static JpegCoefTransform fromExifOrientation(int orientation);
+};
+
+// Tag Orientation (0x0112) dari APP1 Exif; 1 bila tidak ada atau tidak valid
+int jpegExifOrientation(const unsigned char* data, size_t size);
+
+// false bila data bukan JPEG yang bisa dibaca atau area hasil kosong (mis. gambar lebih kecil dari
+// satu iMCU pada sumbu yang dibalik). Marker APPn/COM tidak disalin
+bool jpegTransformCoefficients(const unsigned char* data, size_t size, const JpegCoefTransform& transform,
+                               std::vector<unsigned char>& out, int* outWidth = nullptr, int* outHeight = nullptr);
+
+#endif
@@ -0,0 +1,14 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+// Jumlah thread kerja yang masuk akal untuk pekerjaan CPU-bound (minimal 1)
+unsigned parallelThreads();
+
+// Jalankan fn(i) untuk setiap i di [0, count) tersebar di beberapa thread dan tunggu
+// sampai semuanya selesai. maxThreads 0 = parallelThreads(). Thread pemanggil ikut bekerja.
+void parallelFor(size_t count, const std::function<void(size_t)>& fn, unsigned maxThreads = 0);
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef PHOTO_CATALOG_H
+#define PHOTO_CATALOG_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <sqlite3.h>
+
+struct PhotoRecord {
+    std::string filename;
+    int64_t timestamp = 0;  // ms epoch: dari nama photo_<ms>.jpg, selain itu mtime
+    uint64_t size = 0;
+    int64_t mtime = 0;      // detik
+    uint64_t version = 0;   // versi katalog saat entri ini terakhir berubah
+};
+
+struct PhotoPage {
+    std::vector<PhotoRecord> photos;
+    std::string nextCursor;  // kosong = halaman terakhir
+    uint64_t version = 0;
+};
+
+// Perubahan sejak versi tertentu. reset = tombstone rentang itu sudah dipangkas,
+// klien harus mengambil ulang daftar penuh
+struct PhotoDelta {
+    uint64_t version = 0;
+    std::vector<PhotoRecord> upserts;   // terbaru dulu
+    std::vector<std::string> deleted;
+    bool reset = false;
+};
+
+// Katalog foto di uploads/ yang tinggal di memori dan dipersist ke SQLite (data/photo_catalog.db).
+// Dibangun sekali saat startup (isi DB + satu readdir untuk rekonsiliasi), lalu diperbarui
+// incremental dari capture/upload/delete dan watch inotify pada direktori foto.
+// Listing dibaca dari index terurut (terbaru dulu) tanpa menyentuh filesystem.
+// Setiap perubahan menaikkan versi katalog yang monoton; penghapusan disimpan sebagai tombstone
+// (maks kMaxTombstones) supaya klien bisa meminta delta sejak versi terakhir yang dilihatnya.
+class PhotoCatalog {
+public:
+    typedef std::function<void(const PhotoDelta&)> Listener;
+    static const size_t kMaxTombstones = 4096;
+
+    PhotoCatalog();
+    ~PhotoCatalog();
+
+    bool init(const std::string& photoDir, const std::string& dataDir);
+    void stop();
+
+    // Upsert dari file di photoDir (stat); false bila bukan foto atau file tidak ada
+    bool add(const std::string& filename);
+    bool remove(const std::string& filename);
+
+    // Terbaru dulu; limit 0 = semua
+    std::vector<PhotoRecord> list(size_t limit = 0) const;
+    // Halaman berikutnya setelah cursor (kosong = dari awal). false bila cursor tidak valid
+    bool page(const std::string& cursor, size_t limit, PhotoPage& out) const;
+    PhotoDelta changesSince(uint64_t version) const;
+    // Foto dengan timestamp > timestamp (ms), terbaru dulu
+    std::vector<PhotoRecord> newerThan(int64_t timestamp, size_t limit = 0) const;
+    uint64_t version() const;
+    size_t size() const;
+
+    // Dipanggil (di luar lock) dengan delta satu perubahan setiap kali katalog berubah
+    void setListener(const Listener& listener);
+
+    static bool isPhotoName(const std::string& filename);
+    static std::string cursorFor(const PhotoRecord& record);
+
+private:
+    typedef std::pair<int64_t, std::string> TimeKey;
+    struct Newer {
+        bool operator()(const TimeKey& a, const TimeKey& b) const {
+            return a.first != b.first ? a.first > b.first : a.second > b.second;
+        }
+    };
+
+    bool openDatabase(const std::string& path);
+    void loadLocked();
+    void reconcile();
+    void putLocked(const PhotoRecord& record);
+    void eraseLocked(const std::string& filename);
+    // Naikkan versi, ubah index dan catat ke delta; false bila gagal ditulis ke DB
+    bool upsertLocked(PhotoRecord record, PhotoDelta& delta);
+    bool removeLocked(const std::string& filename, PhotoDelta& delta);
+    void addTombstoneLocked(const std::string& filename, uint64_t version);
+    void dropTombstoneLocked(const std::string& filename);
+    bool persistLocked(const PhotoRecord& record);
+    bool unpersistLocked(const std::string& filename, uint64_t version);
+    void saveMetaLocked();
+    bool execLocked(const std::string& sql, const std::string& text = "", int64_t a = 0, int64_t b = 0);
+    void notify(const PhotoDelta& delta);
+    void watchLoop();
+
+    std::string photoDir;
+    mutable std::mutex mu;
+    sqlite3* db;
+    std::map<std::string, PhotoRecord> byName;
+    std::set<TimeKey, Newer> byTime;
+    std::map<uint64_t, std::string> byVersion;
+    std::map<uint64_t, std::string> tombstones;          // versi hapus -> nama
+    std::map<std::string, uint64_t> tombstoneByName;
+    uint64_t currentVersion;
+    uint64_t tombstoneFloor;  // delta sejak versi < floor tidak lengkap lagi
+
+    std::mutex listenerMu;
+    Listener listener;
+
+    int inotifyFd;
+    int wakePipe[2];   // stop() menulis ke sini untuk membangunkan watchLoop
+    std::atomic<bool> running;
+    std::thread watcher;
+};
+
+#endif
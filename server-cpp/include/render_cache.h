@@ -0,0 +1,59 @@
+#ifndef RENDER_CACHE_H
+#define RENDER_CACHE_H
+
+#include "template_renderer.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+// Cache hasil render JPEG, dialamati oleh konten: hash layout ter-compile (template + ukuran),
+// identitas foto (inode, ukuran, mtime), mtime aset, dan kualitas JPEG.
+// Tier memori (LRU dengan batas byte) di atas penyimpanan disk <dir>/<key>.jpg + index.txt.
+class RenderCache {
+public:
+    RenderCache(const std::string& dir, size_t memoryBytes, uint64_t diskBytes);
+
+    // String kosong bila layout tidak punya key atau salah satu foto tidak bisa di-stat
+    static std::string makeKey(const CompiledLayout& layout, const std::vector<std::string>& photoPaths);
+
+    // Key turunan untuk ukuran/kualitas lain dari render yang sama (level piramida output)
+    static std::string variantKey(const std::string& key, int width, int height, int quality);
+
+    std::string pathFor(const std::string& key) const;
+    static std::string urlFor(const std::string& path);
+
+    // Hit bila file ada di disk; jpeg diisi dari tier memori (atau dibaca dan dipromosikan) bila diminta
+    bool lookup(const std::string& key, std::shared_ptr<const std::vector<unsigned char>>* jpeg = nullptr);
+    // Tulis atomik ke disk (tmp + rename) lalu masukkan ke tier memori
+    bool store(const std::string& key, const std::vector<unsigned char>& jpeg);
+
+    size_t memoryEntries() const;
+    size_t diskEntries() const;
+
+private:
+    struct DiskEntry {
+        uint64_t size = 0;
+        int64_t lastAccess = 0;
+    };
+    typedef std::shared_ptr<const std::vector<unsigned char>> Bytes;
+
+    void loadIndexLocked();
+    void saveIndexLocked();
+    void rememberLocked(const std::string& key, const Bytes& bytes);
+    void evictDiskLocked();
+
+    std::string dir;
+    size_t memoryLimit;
+    uint64_t diskLimit;
+    mutable std::mutex mu;
+    std::list<std::pair<std::string, Bytes>> memory;
+    size_t memoryUsed = 0;
+    std::map<std::string, DiskEntry> disk;
+    uint64_t diskUsed = 0;
+};
+
+#endif
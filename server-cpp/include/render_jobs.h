@@ -0,0 +1,116 @@
+#ifndef RENDER_JOBS_H
+#define RENDER_JOBS_H
+
+#include "template_renderer.h"
+#include "render_cache.h"
+#include <string>
+#include <map>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+enum class RenderJobState {
+    Queued,
+    Running,
+    Done,
+    Failed,
+    Cancelled
+};
+
+// Output tambahan dari render yang sama (web, thumbnail, ...). Path ditentukan saat submit
+struct RenderOutput {
+    std::string name;
+    int width = 0;
+    int height = 0;
+    int quality = 85;
+    std::string path;
+    std::string cacheKey;
+};
+
+// Snapshot job yang aman dibaca di luar lock
+struct RenderJobInfo {
+    std::string id;
+    RenderJobState state = RenderJobState::Queued;
+    float progress = 0.0f;
+    std::string outputPath;
+    std::vector<RenderOutput> outputs;
+    std::string error;
+};
+
+struct RenderJob {
+    std::string id;
+    std::shared_ptr<const CompiledLayout> layout;
+    std::vector<std::string> photoPaths;
+    std::string outputPath;
+    std::string cacheKey;
+    std::vector<RenderOutput> outputs;
+    RenderJobState state = RenderJobState::Queued;
+    float progress = 0.0f;
+    std::string error;
+    int64_t createdAt = 0;
+    int64_t finishedAt = 0;
+    std::atomic<bool> cancelRequested{false};
+    bool preview = false;   // jalur preview: depan antrian, hasil hanya lewat onFinished
+    std::function<void(const RenderJobInfo&, const std::vector<unsigned char>&)> onFinished;
+};
+
+// Worker pool render dengan antrian terbatas. Event progress/selesai dikirim lewat emitter.
+// Job preview masuk di depan antrian dan punya satu worker tambahan yang hanya mengambil preview,
+// jadi preview tidak menunggu render resolusi penuh yang sedang berjalan
+class RenderJobManager {
+public:
+    typedef std::function<void(const std::string&, const std::map<std::string, std::string>&)> Emitter;
+    // Dipanggil sekali saat job selesai/gagal/batal; bytes JPEG hanya terisi bila sukses
+    typedef std::function<void(const RenderJobInfo&, const std::vector<unsigned char>&)> Completion;
+
+    // cache boleh nullptr; bila ada, output job langsung disimpan sebagai entri cache
+    RenderJobManager(const std::string& outputDir, int workers, size_t maxQueued, Emitter emit,
+                     RenderCache* cache = nullptr);
+    ~RenderJobManager();
+
+    // Return false (antrian penuh) tanpa membuat job; jobId terisi bila diterima.
+    // outputs: ukuran tambahan (<= ukuran layout) yang dihasilkan dari kanvas yang sama.
+    // preview: jalur preview, tanpa event render-progress/render-done
+    bool submit(const std::shared_ptr<const CompiledLayout>& layout, const std::vector<std::string>& photoPaths, std::string& jobId,
+                Completion onFinished = nullptr, const std::vector<RenderOutput>& outputs = std::vector<RenderOutput>(),
+                bool preview = false);
+    // Lengkapi ukuran output (sisi 0 mengikuti rasio layout, dibatasi ukuran layout) dan key cache-nya
+    static std::vector<RenderOutput> resolveOutputs(const CompiledLayout& layout, const std::string& cacheKey,
+                                                    const std::vector<RenderOutput>& outputs);
+    // Path output sudah ditentukan saat submit, jadi URL bisa dikembalikan sebelum render selesai
+    static std::string outputUrl(const std::string& outputPath);
+    bool get(const std::string& jobId, RenderJobInfo& info) const;
+    bool cancel(const std::string& jobId);
+    void shutdown();
+
+    static const char* stateName(RenderJobState state);
+    static std::string toJson(const RenderJobInfo& info);
+
+private:
+    void workerLoop(bool previewLane);
+    void runJob(const std::shared_ptr<RenderJob>& job);
+    void finishJob(const std::shared_ptr<RenderJob>& job, const RenderJobInfo& info, const std::vector<unsigned char>& jpeg);
+    bool writeOutput(const std::string& path, const std::string& cacheKey, const std::vector<unsigned char>& jpeg);
+    void pruneFinishedLocked();
+    std::string nextJobId();
+    RenderJobInfo snapshotLocked(const RenderJob& job) const;
+
+    std::string outputDir;
+    size_t maxQueued;
+    Emitter emit;
+    RenderCache* cache;
+    mutable std::mutex mu;
+    std::condition_variable cv;
+    std::deque<std::shared_ptr<RenderJob>> queue;
+    std::map<std::string, std::shared_ptr<RenderJob>> jobs;
+    std::vector<std::thread> threads;
+    bool stopping;
+    unsigned long long sequence;
+};
+
+#endif
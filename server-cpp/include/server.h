@@ -4,6 +4,7 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include <functional>
 #include <iostream>
 #include <thread>
@@ -166,16 +167,17 @@ struct Camera {
     std::string port;
 };
 
-// NOTE: Efek foto telah dipindahkan ke frontend untuk optimasi performa
-// Struktur ini tetap ada untuk backward compatibility
+struct ColorLut;
+
+// Parameter efek; skala nilainya sama dengan slider di frontend
 struct EffectParams {
     double intensity = 0.5;  // 0.0 to 1.0
     double radius = 1.0;     // untuk fisheye, vignette
     int pixelSize = 10;      // untuk pixelate
+    std::string lut;         // untuk LUT: nama file .cube di luts/
+    std::shared_ptr<const ColorLut> lutTable;  // hasil LutLibrary::get(lut), diisi handler
 };
 
-// NOTE: Efek foto telah dipindahkan ke frontend untuk optimasi performa
-// Enum ini tetap ada untuk backward compatibility
 enum class EffectType {
     NONE,
     FISHEYE,
@@ -186,7 +188,14 @@ enum class EffectType {
     BLUR,
     SHARPEN,
     INVERT,
-    PIXELATE
+    PIXELATE,
+    LUT
+};
+
+// Satu langkah di rantai efek
+struct EffectStep {
+    EffectType type = EffectType::NONE;
+    EffectParams params;
 };
 
 // Struktur untuk foto
@@ -216,21 +225,123 @@ class WebSocketServer;
 
 class BoothIdentityStore;
 
-// NOTE: ImageEffects class telah di-simplify karena efek dipindahkan ke frontend
-// Class ini tetap ada untuk backward compatibility tapi tidak melakukan processing
+class PhotoCatalog;
+
+struct PhotoDelta;
+
+class TemplateLayoutCache;
+
+class RenderJobManager;
+
+class RenderCache;
+
+class StaticFileCache;
+
+class ImageVariantStore;
+
+class LutLibrary;
+
+class EffectVariantStore;
+
+struct JpegCoefTransform;
+
+class JpegFrameCodec;
+
+struct CompiledLayout;
+
+// Rantai efek terkompilasi. Langkah operasi titik yang berurutan (grayscale, sepia, invert, LUT,
+// vignette) dilebur menjadi satu pass per chunk (pointOpsImage); blur, sharpen, pixelate dan
+// geometri tetap pass sendiri di antaranya. Immutable, aman dipakai bersama antar thread.
+class EffectPipeline {
+public:
+    static const size_t kMaxSteps = 8;
+
+    // Langkah NONE dan LUT tanpa tabel dibuang
+    explicit EffectPipeline(const std::vector<EffectStep>& steps);
+
+    bool empty() const { return effectSteps.empty(); }
+    const std::vector<EffectStep>& steps() const { return effectSteps; }
+    // Jumlah pass atas gambar penuh
+    size_t passCount() const { return stages.size(); }
+    // mis. "[sepia+vignette] -> blur"
+    std::string describe() const;
+    // In-place pada gambar RGB yang sudah di-decode. sizeScale: piksel gambar per piksel preview
+    // (radius blur, blok pixelate); 0 = dihitung dari ukuran gambar (ImageEffects::previewScale)
+    void run(ImageData& image, double sizeScale = 0.0) const;
+    // Hasil sama persis dengan run, untuk gambar capture penuh: gambar dipecah menjadi tile pita
+    // baris seukuran cache dan setiap tile melewati seluruh rantai di satu core (paralel antar
+    // tile), jadi gambar dibaca/ditulis sekali per segmen, bukan sekali per pass. Blur, sharpen dan
+    // pixelate membaca halo baris tetangga dari sumber. Fisheye dan wide angle (remap global) tetap
+    // satu pass gambar penuh di antara segmen tile
+    void runTiled(ImageData& image, double sizeScale = 0.0, unsigned maxThreads = 0) const;
+    // Kunci stabil langkah + parameter, mis. untuk nama file varian efek
+    std::string signature() const;
+
+    // true bila seluruh rantai bisa dikerjakan di koefisien DCT (grayscale penuh, pixelate) dan
+    // isi transform untuk gambar width x height; false = perlu decode ke piksel
+    bool coefficientTransform(int width, int height, JpegCoefTransform& transform) const;
+
+    static bool isPointOp(EffectType type);
+    static bool parseEffectName(const std::string& name, EffectType& type);
+    static std::string effectName(EffectType type);
+    // Array JSON [{"effect":"sepia","intensity":0.8}, ...] atau bentuk ringkas
+    // "sepia:0.8,vignette,lut:warm:0.6" (nama[:intensity], LUT: lut:nama[:intensity])
+    static bool parseSteps(const std::string& spec, std::vector<EffectStep>& steps, std::string& error);
+    // Isi lutTable setiap langkah LUT dari library; false + error bila ada yang tidak ditemukan
+    static bool resolveLuts(std::vector<EffectStep>& steps, LutLibrary& library, std::string& error);
+
+private:
+    struct Stage {
+        bool fused;                  // true: semua langkah adalah operasi titik
+        std::vector<size_t> steps;   // indeks ke effectSteps
+    };
+
+    bool isGeometry(const Stage& stage) const;
+    // Perluas [y0, y1) ke baris input yang dibutuhkan stage untuk menghasilkan baris itu
+    void inputRows(const Stage& stage, double scale, int height, int& y0, int& y1) const;
+    // Jalankan stage (bukan geometri) pada baris [y0, y1) gambar setinggi height; rows = baris y0
+    void runStageRows(const Stage& stage, unsigned char* rows, int width, int height, int y0, int y1,
+                      double scale) const;
+    void runTileSegment(ImageData& image, size_t firstStage, size_t lastStage, double scale, unsigned maxThreads) const;
+
+    std::vector<EffectStep> effectSteps;
+    std::vector<Stage> stages;
+};
+
+// Efek foto di server (kernel SIMD di effect_kernels.h). Formula sama dengan preview di frontend;
+// radius blur dan ukuran pixelate diskalakan dari ukuran preview (1920 px) ke ukuran gambar.
+// Efek aktif adalah rantai langkah; pipeline terkompilasinya di-cache sampai pengaturan berubah
 class ImageEffects {
 private:
-    EffectType currentEffect;
+    EffectType currentEffect;   // langkah pertama, untuk getEffect()
     EffectParams params;
+    std::shared_ptr<const EffectPipeline> pipeline;
+    bool mirrored;              // cermin horizontal (preview selfie)
     mutable std::mutex mutex;
     
 public:
     ImageEffects();
+    // Satu efek (rantai satu langkah); NONE mengosongkan rantai
     void setEffect(EffectType effect, const EffectParams& params);
     std::pair<EffectType, EffectParams> getEffect() const;
-    
-    // NOTE: applyEffect sekarang hanya return original data (no processing)
+    // Rantai efek berurutan; dikompilasi sekali di sini, tidak per frame
+    void setEffects(const std::vector<EffectStep>& steps);
+    std::vector<EffectStep> getEffects() const;
+    std::shared_ptr<const EffectPipeline> getPipeline() const;
+    void setMirror(bool enabled);
+    bool isMirrored() const;
+    
+    // Decode -> rantai efek aktif -> encode. Input dikembalikan apa adanya bila rantai kosong dan tanpa
+    // mirror, atau gagal. Orientasi EXIF ditegakkan; mirror, grayscale penuh dan pixelate dikerjakan
+    // di koefisien DCT (jpeg_transform.h) tanpa decode bila rantainya memungkinkan
     std::vector<unsigned char> applyEffect(const std::vector<unsigned char>& jpegData);
+    // Sama, dengan pipeline yang sudah dikompilasi (boleh nullptr) di luar pengaturan instance
+    static std::vector<unsigned char> applyEffect(const std::vector<unsigned char>& jpegData,
+                                                  const std::shared_ptr<const EffectPipeline>& compiled, bool mirror);
+    // Terapkan efek ke gambar RGB yang sudah di-decode (in-place)
+    static void applyEffectTo(ImageData& image, EffectType effect, const EffectParams& params, double sizeScale = 0.0);
+    // Piksel gambar width x height per piksel preview frontend (>= 1)
+    static double previewScale(int width, int height);
     
     // Utility methods untuk file operations (tetap dibutuhkan)
     ImageData decodeFile(const std::string& filePath);
@@ -238,19 +349,15 @@ public:
     
 private:
     // JPEG encode/decode methods (tetap dibutuhkan untuk file operations)
-    ImageData decodeJPEG(const std::vector<unsigned char>& jpegData);
-    std::vector<unsigned char> encodeJPEG(const ImageData& rgbData);
-    
-    // NOTE: Effect implementation methods tetap ada untuk backward compatibility tapi tidak melakukan processing
-    void applyGrayscaleEffect(ImageData& image);
-    void applySepiaEffect(ImageData& image);
-    void applyInvertEffect(ImageData& image);
-    void applyVignetteEffect(ImageData& image);
-    void applyBlurEffect(ImageData& image);
-    void applySharpenEffect(ImageData& image);
-    void applyPixelateEffect(ImageData& image);
-    void applyFishEyeEffect(ImageData& image);
-    void applyWideAngleEffect(ImageData& image);
+    static ImageData decodeJPEG(const std::vector<unsigned char>& jpegData);
+    static std::vector<unsigned char> encodeJPEG(const ImageData& rgbData);
+    
+    static void applyBlurEffect(ImageData& image, const EffectParams& params, double scale);
+    static void applySharpenEffect(ImageData& image, const EffectParams& params, double scale);
+    static void applyPixelateEffect(ImageData& image, const EffectParams& params, double scale);
+    static void applyFishEyeEffect(ImageData& image, const EffectParams& params);
+    static void applyWideAngleEffect(ImageData& image, const EffectParams& params);
+    static void applyPointEffect(ImageData& image, EffectType effect, const EffectParams& params);
 };
 
 // Kelas untuk wrapper gphoto2
@@ -274,6 +381,10 @@ public:
     void cleanupPreviews(int keepLast);
     void setEffect(EffectType effect, const EffectParams& params);
     std::pair<EffectType, EffectParams> getCurrentEffect() const;
+    // Rantai efek capture. captureImage menyimpan foto asli apa adanya; versi berefek dibuat
+    // terpisah di latar belakang (EffectVariantStore) supaya respons capture tidak menunggu
+    void setEffects(const std::vector<EffectStep>& steps);
+    std::shared_ptr<const EffectPipeline> getPipeline() const;
     std::string base64Encode(const std::vector<unsigned char>& data);
     std::vector<unsigned char> readImageFile(const std::string& filePath);
     bool writeImageFile(const std::string& filePath, const std::vector<unsigned char>& data);
@@ -282,6 +393,58 @@ private:
     std::string executeCommand(const std::string& command);
 };
 
+// Efek live view per frame dengan anggaran waktu. Frame di-decode pada skala 1/scaleDenom (IDCT
+// libjpeg-turbo yang diperkecil), rantai efek dijalankan, lalu di-encode ulang dengan handle
+// libjpeg yang dipakai ulang. scaleDenom naik bila rata-rata waktu proses melewati anggaran dan
+// turun lagi bila jauh di bawahnya. Bila di skala 1/kMaxScaleDenom pun masih lewat anggaran, hanya
+// sebagian frame yang dirender dan sisanya dibuang sampai biayanya muat lagi. Pembaca stream juga
+// membuang frame yang menumpuk selama satu frame diproses (hanya frame lengkap terbaru yang
+// dirender). Dipanggil dari satu thread (thread pembaca stream); setBudgetMs dan stats aman dari
+// thread lain
+class LiveViewRenderer {
+public:
+    static const int kMaxScaleDenom = 4;
+
+    struct Stats {
+        uint64_t frames = 0;        // frame yang dikirim
+        uint64_t dropped = 0;       // tidak dikirim: tertimpa frame lebih baru atau di luar anggaran
+        uint64_t passthrough = 0;   // dikirim apa adanya (tanpa efek)
+        double avgMs = 0.0;         // rata-rata waktu proses (EMA)
+        int scaleDenom = 1;
+        double budgetMs = 0.0;
+    };
+
+    explicit LiveViewRenderer(const ImageEffects& effects);
+    ~LiveViewRenderer();
+
+    // arrival: saat frame selesai dibaca dari kamera (untuk interval frame). false = frame dibuang
+    // untuk menjaga anggaran, out tidak diisi. out berisi frame asli bila tanpa efek atau pemrosesan gagal
+    bool render(const std::vector<unsigned char>& frame, std::chrono::steady_clock::time_point arrival,
+                std::vector<unsigned char>& out);
+    // Frame lengkap yang tidak dirender karena sudah tertimpa frame lebih baru
+    void noteDropped(uint64_t count);
+    // 0 = ikuti interval frame kamera (15..100 ms)
+    void setBudgetMs(double ms);
+    Stats stats() const;
+
+private:
+    bool renderPixels(const std::vector<unsigned char>& frame, const EffectPipeline* pipeline, bool mirror,
+                      std::vector<unsigned char>& out);
+    double currentBudgetMs() const;
+
+    const ImageEffects& effects;
+    std::unique_ptr<JpegFrameCodec> codec;
+    ImageData image;                       // buffer RGB dipakai ulang antar frame
+    int scaleDenom;
+    double pixelMs;                        // EMA waktu jalur decode -> efek -> encode
+    std::chrono::steady_clock::time_point lastArrival;
+    double frameIntervalMs;                // EMA interval antar frame kamera
+    unsigned overBudgetFrames;             // frame sejak render terakhir saat lewat anggaran
+    std::atomic<double> budgetOverrideMs;
+    mutable std::mutex statsMutex;
+    Stats current;
+};
+
 // Kelas untuk MJPEG Server
 class MJPEGServer {
 private:
@@ -289,6 +452,7 @@ private:
     bool isStreaming;
     std::vector<unsigned char> frameBuffer;
     ImageEffects effects;
+    std::unique_ptr<LiveViewRenderer> liveView;
     int serverSocket;
     std::vector<int> clientSockets;
     mutable std::mutex clientsMutex;
@@ -309,6 +473,14 @@ public:
     int getClientCount() const;
     void setEffect(EffectType effect, const EffectParams& params);
     std::pair<EffectType, EffectParams> getCurrentEffect() const;
+    // Rantai efek live view; dikompilasi sekali, frame di-encode sekali untuk semua penonton
+    void setEffects(const std::vector<EffectStep>& steps);
+    std::vector<EffectStep> getEffects() const;
+    std::string describeEffects() const;
+    void setMirror(bool enabled);
+    bool isMirrored() const;
+    // Anggaran waktu proses per frame (ms); 0 = ikuti interval frame kamera
+    void setFrameBudget(double ms);
     
 private:
     void setupRoutes();
@@ -332,8 +504,14 @@ private:
     std::unique_ptr<websocket_server> wsServer;
     PhotoBoothServer* photoBoothServer;
     std::map<connection_hdl, std::string, std::owner_less<connection_hdl>> clients;
+    std::set<connection_hdl, std::owner_less<connection_hdl>> photoSubscribers;  // dijaga clientsMutex
     mutable std::mutex clientsMutex;
     std::thread serverThread;
+    std::unique_ptr<TemplateLayoutCache> templateCache;
+    std::unique_ptr<RenderCache> renderCache;
+    std::unique_ptr<RenderJobManager> renderJobs;
+    std::unique_ptr<StaticFileCache> staticFiles;
+    std::unique_ptr<ImageVariantStore> variants;
     
 public:
     WebSocketServer(int port, PhotoBoothServer* photoBoothServer);
@@ -348,6 +526,12 @@ public:
     void broadcast(const std::string& event, const std::map<std::string, std::string>& data);
     void emitToAll(const std::string& event, const std::map<std::string, std::string>& data);
     
+    // Kirim perubahan katalog foto ke klien yang subscribe-photos
+    void publishPhotoDelta(const PhotoDelta& delta);
+    
+    // Varian galeri (thumbnail) untuk foto di uploads/
+    ImageVariantStore* getImageVariants() { return variants.get(); }
+    
 private:
     void setupEventHandlers();
     void onOpen(connection_hdl hdl);
@@ -359,6 +543,7 @@ private:
     // WebSocket message handling
     void handleWebSocketMessage(connection_hdl hdl, const std::string& message);
     void handleEvent(connection_hdl hdl, const std::string& event, const std::map<std::string, std::string>& data);
+    void subscribePhotos(connection_hdl hdl, const std::map<std::string, std::string>& data);
     
     // HTTP request handling (untuk API endpoints)
     void handleApiRequest(const std::string& method, const std::string& path, const std::map<std::string, std::string>& data);
@@ -376,20 +561,28 @@ private:
                          const std::string& contentType, bool includeCors);
     
     // HTTP API handlers
+    void sendHttpBinaryResponse(connection_hdl hdl, std::string&& body, const std::string& contentType,
+                                const std::string& cacheControl);
     void handleHttpApiStatusRequest(connection_hdl hdl);
-    void handleHttpApiPhotosRequest(connection_hdl hdl);
+    void handleHttpApiPhotosRequest(connection_hdl hdl, const std::map<std::string, std::string>& queryParams);
     void handleHttpApiIdentityGetRequest(connection_hdl hdl);
     void handleHttpApiIdentityPostRequest(connection_hdl hdl, websocket_server::connection_ptr con);
     void handleHttpApiPhotoDeleteRequest(connection_hdl hdl, const std::string& filename);
     void handleHttpUploadImagePostRequest(connection_hdl hdl, websocket_server::connection_ptr con);
     void handleHttpRenderTemplatePostRequest(connection_hdl hdl, websocket_server::connection_ptr con);
+    void handleHttpRenderPreview(connection_hdl hdl, const std::shared_ptr<const CompiledLayout>& layout,
+                                 const std::vector<std::string>& photoPaths, bool wantJpeg);
+    void handleHttpRenderJobRequest(connection_hdl hdl, const std::string& method, const std::string& jobId);
     
     // Static file serving handlers
     std::string getMimeTypeFromExtension(const std::string& filename);
     bool isPathSafe(const std::string& path);
     bool fileExists(const std::string& filepath);
     std::vector<uint8_t> readBinaryFile(const std::string& filepath);
-    void handleStaticFileRequest(connection_hdl hdl, const std::string& path);
+    void handleStaticFileRequest(connection_hdl hdl, const std::string& path,
+                                 const std::map<std::string, std::string>& queryParams);
+    // Kirim file dengan ETag/Last-Modified, jawab 304 dan Range; fullPath relatif cwd
+    void serveStaticFile(connection_hdl hdl, const std::string& fullPath, const std::string& cacheControl);
 };
 
 // Kelas HTTP Server utama
@@ -402,6 +595,9 @@ private:
     WebSocketServer* webSocketServer;
     bool running;
     BoothIdentityStore* identityStore;
+    PhotoCatalog* photoCatalog;
+    LutLibrary* lutLibrary;
+    EffectVariantStore* effectVariants;
     
 public:
     PhotoBoothServer(int apiPort = API_PORT, int mjpegPort = MJPEG_PORT);
@@ -416,6 +612,11 @@ public:
     GPhotoWrapper* getGPhotoWrapper() { return gphoto; }
     WebSocketServer* getWebSocketServer() { return webSocketServer; }
     BoothIdentityStore* getIdentityStore() { return identityStore; }
+    PhotoCatalog* getPhotoCatalog() { return photoCatalog; }
+    LutLibrary* getLutLibrary() { return lutLibrary; }
+    EffectVariantStore* getEffectVariants() { return effectVariants; }
+    // Rantai efek dari parameter query (?effect=..&intensity=..); nullptr bila tanpa efek atau tidak valid
+    std::shared_ptr<const EffectPipeline> effectPipelineFor(const std::map<std::string, std::string>& query);
     std::vector<Photo> getPhotosList();
     bool deletePhoto(const std::string& filename);
     
@@ -431,8 +632,19 @@ public:
     void handleSetEffectEvent(connection_hdl hdl, const std::map<std::string, std::string>& data);
     void handleGetEffectEvent(connection_hdl hdl);
     void handleApplyEffectEvent(connection_hdl hdl, const std::map<std::string, std::string>& data);
+    void handleGetLutsEvent(connection_hdl hdl);
+    void handleSetMirrorEvent(connection_hdl hdl, const std::map<std::string, std::string>& data);
+    // Render ulang varian efek dari foto asli yang sudah ada (tanpa capture ulang)
+    void handleRenderPhotoEffectEvent(connection_hdl hdl, const std::map<std::string, std::string>& data);
     
 private:
+    // "effects" (rantai) atau "effect" + parameter dari event; LUT di-resolve dari lutLibrary
+    bool parseEffectSteps(const std::map<std::string, std::string>& data, std::vector<EffectStep>& steps,
+                          std::string& effectName, EffectParams& params, std::string& error);
+    // Antrikan varian efek foto; hasilnya dikirim sebagai event (default "photo-effect-ready")
+    void renderEffectVariant(connection_hdl hdl, const std::string& filename,
+                             std::shared_ptr<const EffectPipeline> pipeline,
+                             const std::string& event = "photo-effect-ready", const std::string& effectName = "");
     void setupRoutes();
     void handleHttpRequest(int clientSocket, const std::string& request);
     void handleWebSocketConnection(int clientSocket);
@@ -0,0 +1,67 @@
+#ifndef STATIC_FILE_CACHE_H
+#define STATIC_FILE_CACHE_H
+
+#include <string>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <cstdint>
+
+// Cache file statis yang sedang terbuka untuk /uploads dan /outputs: fd, ukuran, ETag kuat dan
+// Last-Modified dihitung sekali per versi file. Tiap request cukup satu stat() untuk validasi
+// (inode + ukuran + mtime ns); body dibaca dengan pread dari page cache langsung ke buffer respons.
+// Sengaja tidak memakai mmap: capture dan upload ditulis di tempat, dan file yang terpotong saat
+// dipetakan akan memicu SIGBUS.
+class StaticFileCache {
+public:
+    struct File {
+        File() = default;
+        File(const File&) = delete;
+        File& operator=(const File&) = delete;
+        ~File();
+
+        int fd = -1;
+        uint64_t size = 0;
+        uint64_t inode = 0;
+        int64_t mtimeNs = 0;
+        std::string etag;           // termasuk tanda kutip
+        std::string lastModified;   // format IMF-fixdate (RFC 7231)
+
+        // Baca [offset, offset+length) ke out; false bila file memendek di tengah jalan
+        bool read(uint64_t offset, uint64_t length, std::string& out) const;
+    };
+
+    explicit StaticFileCache(size_t maxOpenFiles = 64);
+
+    // nullptr bila file tidak ada atau bukan file biasa
+    std::shared_ptr<const File> open(const std::string& path);
+    void invalidate(const std::string& path);
+
+    size_t openFiles() const;
+
+private:
+    typedef std::list<std::pair<std::string, std::shared_ptr<const File>>> Lru;
+
+    size_t maxOpen;
+    mutable std::mutex mu;
+    Lru lru;
+    std::map<std::string, Lru::iterator> index;
+};
+
+// Hasil parsing header Range untuk resource berukuran size
+struct ByteRange {
+    enum Kind { None, Satisfiable, Unsatisfiable };
+    Kind kind = None;
+    uint64_t first = 0;
+    uint64_t length = 0;
+};
+
+// Hanya satu range "bytes=a-b", "bytes=a-" atau "bytes=-n". Multi-range dan sintaks lain
+// dianggap None (dilayani penuh 200), sesuai RFC 7233 yang mengizinkan server mengabaikan Range
+ByteRange parseByteRange(const std::string& header, uint64_t size);
+
+// If-None-Match: daftar ETag dipisah koma atau "*", dibandingkan secara weak
+bool etagMatches(const std::string& ifNoneMatch, const std::string& etag);
+
+#endif
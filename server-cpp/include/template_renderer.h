@@ -4,6 +4,11 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <ctime>
+#include <functional>
 
 struct RgbaImage {
     int width = 0;
@@ -20,14 +25,128 @@ struct TextSpec {
     unsigned char b = 255;
     float x = 0.0f;
     float y = 0.0f;
+    // Diisi saat compile (0 bila font belum ada); font yang diganti di disk membuat layout basi
+    time_t fontMtime = 0;
+};
+
+enum class FitMode {
+    Stretch,
+    Contain,
+    Cover   // isi kotak penuh, kelebihan di-crop di tengah
+};
+
+// Slot foto untuk kolase/photo strip. Koordinat dalam ukuran desain template
+struct PhotoSlot {
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 0.0f;
+    float height = 0.0f;
+    FitMode mode = FitMode::Cover;
+    float cornerRadius = 0.0f;
+    std::string maskPath;   // PNG; alpha-nya dipakai sebagai mask slot
+    int photoIndex = -1;    // -1 = urutan slot
+};
+
+// Sticker/prop/logo dengan transform affine. Koordinat dalam ukuran desain template
+struct StickerSpec {
+    std::string path;
+    float x = 0.0f;          // pusat sticker
+    float y = 0.0f;
+    float width = 0.0f;      // 0 = ikut rasio aspek dari sisi lain, atau ukuran asli aset
+    float height = 0.0f;
+    float scale = 1.0f;
+    float rotation = 0.0f;   // derajat, searah jarum jam
+    float opacity = 1.0f;
 };
 
 struct TemplateSpec {
     std::string backgroundPath;
     std::vector<std::string> overlays;
     std::vector<TextSpec> texts;
+    // Kosong = satu foto contain di seluruh kanvas (perilaku lama)
+    std::vector<PhotoSlot> slots;
+    // Digambar di atas overlay, di bawah teks
+    std::vector<StickerSpec> stickers;
+    // Ukuran desain template; posisi & ukuran teks diskalakan ke ukuran output
+    int designWidth = 0;
+    int designHeight = 0;
+};
+
+enum class LayerKind {
+    Background,
+    Photo,
+    Overlay,
+    Sticker
+};
+
+// Aset yang sudah divalidasi saat compile: dimensi & skala DCT tidak dihitung ulang per render
+struct LayoutAsset {
+    std::string path;
+    int width = 0;
+    int height = 0;
+    int scaleDenom = 1;
+    time_t mtime = 0;
+};
+
+struct CompiledLayer {
+    LayerKind kind = LayerKind::Overlay;
+    LayoutAsset asset;
+    int x = 0, y = 0, w = 0, h = 0;
+    FitMode mode = FitMode::Stretch;
+    bool blend = false;
+    // Khusus layer foto: indeks ke daftar foto, sudut membulat (px output) dan mask opsional
+    int photoIndex = 0;
+    float cornerRadius = 0.0f;
+    LayoutAsset mask;
+    // Khusus sticker: w/h = ukuran bitmap di output, diputar rotation (radian) di sekitar pusatnya
+    float centerX = 0.0f;
+    float centerY = 0.0f;
+    float rotation = 0.0f;
+    unsigned char opacity = 255;
+};
+
+// Hasil compile template untuk satu ukuran output. Immutable setelah dibuat
+struct CompiledLayout {
+    std::string key;
+    int width = 0;
+    int height = 0;
+    float scaleX = 1.0f;
+    float scaleY = 1.0f;
+    int quality = 90;
+    bool preview = false;  // aset di-resize sekali lalu di-cache di memori
+    std::vector<CompiledLayer> layers;
+    std::vector<TextSpec> texts;
+
+    bool isStale() const;
 };
 
+// Cache LRU layout ter-compile, dikunci hash konten template + ukuran output
+class TemplateLayoutCache {
+public:
+    explicit TemplateLayoutCache(size_t capacity = 32);
+
+    static std::string makeKey(const std::string& templateJson, int outW, int outH);
+    std::shared_ptr<const CompiledLayout> get(const std::string& key);
+    void put(const std::shared_ptr<const CompiledLayout>& layout);
+    size_t size() const;
+
+private:
+    size_t capacity;
+    mutable std::mutex mu;
+    std::list<std::shared_ptr<const CompiledLayout>> entries;
+};
+
+// Satu ukuran output dari render yang sama (mis. print, web, thumbnail)
+struct OutputLevel {
+    int width = 0;
+    int height = 0;
+    int quality = 90;
+};
+
+class RowSource;
+class AffineLayer;
+struct TextRun;
+
 class TemplateRenderer {
 public:
     TemplateRenderer();
@@ -45,15 +164,78 @@ public:
                             int outH,
                             std::vector<unsigned char>& outJpeg);
 
+    // Kolase: slot ke-i memakai photoPaths[photoIndex % photoPaths.size()]
+    bool renderToJpegBuffer(const TemplateSpec& spec,
+                            const std::vector<std::string>& photoPaths,
+                            int outW,
+                            int outH,
+                            std::vector<unsigned char>& outJpeg);
+
+    // progress dipanggil berkala dengan fraksi 0..1; return false untuk membatalkan render
+    bool renderLayout(const CompiledLayout& layout,
+                      const std::string& photoPath,
+                      std::vector<unsigned char>& outJpeg,
+                      const std::function<bool(float)>& progress = nullptr);
+    bool renderLayout(const CompiledLayout& layout,
+                      const std::vector<std::string>& photoPaths,
+                      std::vector<unsigned char>& outJpeg,
+                      const std::function<bool(float)>& progress = nullptr);
+
+    // Kanvas dirender sekali, setiap level (<= ukuran layout) di-downscale dari level terdekat
+    // yang lebih besar lalu semua level di-encode paralel. outJpegs sejajar dengan levels
+    bool renderPyramid(const CompiledLayout& layout,
+                       const std::vector<std::string>& photoPaths,
+                       const std::vector<OutputLevel>& levels,
+                       std::vector<std::vector<unsigned char>>& outJpegs,
+                       const std::function<bool(float)>& progress = nullptr);
+
+    // Varian responsif satu foto (galeri). Tiap level = kotak contain (sisi 0 = bebas), dipotong ke
+    // ukuran asli; foto di-decode sekali untuk level terbesar lalu level lain diturunkan seperti piramida.
+    // sizes (opsional) diisi ukuran akhir tiap level
+    bool renderPhotoVariants(const std::string& photoPath,
+                             const std::vector<OutputLevel>& levels,
+                             std::vector<std::vector<unsigned char>>& outJpegs,
+                             std::vector<OutputLevel>* sizes = nullptr);
+
+    static std::shared_ptr<const CompiledLayout> compile(const TemplateSpec& spec,
+                                                        int outW,
+                                                        int outH,
+                                                        const std::string& key,
+                                                        std::string& error);
+
+    // Layout yang sama diskalakan ke sisi terpanjang maxSide untuk preview layar kiosk.
+    // Key hasilnya = previewKey(full.key, maxSide) sehingga bisa disimpan di TemplateLayoutCache
+    static const int kPreviewMaxSide = 800;
+    static std::shared_ptr<const CompiledLayout> previewLayout(const CompiledLayout& full, int maxSide = kPreviewMaxSide);
+    static std::string previewKey(const std::string& key, int maxSide = kPreviewMaxSide);
+
     static bool parseColorHex(const std::string& hex, unsigned char& r, unsigned char& g, unsigned char& b);
 
 private:
-    RgbaImage loadImageRGBA(const std::string& path);
+    // Komposit semua layer per strip; sink menerima (baris, y0, jumlah baris) berurutan
+    bool composeLayout(const CompiledLayout& layout,
+                       const std::vector<std::string>& photoPaths,
+                       const std::function<bool(const unsigned char*, int, int)>& sink,
+                       const std::function<bool(float)>& progress);
+    // Downscale + encode paralel level piramida dari satu bitmap; semua level <= ukuran canvas
+    bool encodeLevels(RgbaImage&& canvas,
+                      const std::vector<OutputLevel>& levels,
+                      std::vector<std::vector<unsigned char>>& outJpegs);
+    RgbaImage loadImageRGBA(const std::string& path, int boxW = 0, int boxH = 0, FitMode mode = FitMode::Stretch);
     RgbaImage resizeImage(const RgbaImage& src, int w, int h);
+    std::unique_ptr<RowSource> openRowSource(const std::string& path, int boxW, int boxH, FitMode mode);
+    std::unique_ptr<RowSource> openRowSource(const LayoutAsset& asset);
+    std::unique_ptr<RowSource> openScaledAsset(const LayoutAsset& asset, int w, int h);
+    // decodeFailed diset bila aset mask/sticker terpotong di tengah decode
+    std::shared_ptr<std::vector<unsigned char>> buildSlotMask(const CompiledLayer& layer, bool& decodeFailed);
+    std::unique_ptr<AffineLayer> openStickerLayer(const CompiledLayer& layer, bool preview, bool& decodeFailed);
+    static void fitSize(int srcW, int srcH, int boxW, int boxH, FitMode mode, int& outW, int& outH);
     void blitImage(RgbaImage& dest, const RgbaImage& src, int x, int y);
     void blendImage(RgbaImage& dest, const RgbaImage& src, int x, int y);
     void fillBackground(RgbaImage& dest, unsigned char r, unsigned char g, unsigned char b);
-    void drawText(RgbaImage& dest, const TextSpec& text);
+    // x/y TextSpec = pen kiri & baseline (sama seperti canvas fillText default)
+    static bool layoutText(const TextSpec& text, TextRun& run);
+    void drawText(RgbaImage& dest, const TextRun& run, int originY = 0);
     bool writeJpegToFile(const RgbaImage& rgba, const std::string& path);
     bool writeJpegToBuffer(const RgbaImage& rgba, std::vector<unsigned char>& out);
 };
@@ -0,0 +1,161 @@
+#include "../include/affine_layer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Border transparan di setiap sisi tekstur. Dua piksel supaya pembulatan 16.16 di ujung
+// span tidak pernah membaca di luar buffer
+const int kPad = 2;
+// Sisi maksimum bitmap; u/v 16.16 harus muat di int32
+const int kMaxSide = 16384;
+
+inline unsigned int div255(unsigned int x) {
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+// Persempit [lo, hi] (indeks piksel) ke piksel yang nilai slope*(px+0.5)+base berada di [minV, maxV]
+void limitSpan(double slope, double base, double minV, double maxV, double& lo, double& hi) {
+    if (std::fabs(slope) < 1e-12) {
+        if (base < minV || base > maxV) hi = lo - 1.0;
+        return;
+    }
+    double t1 = (minV - base) / slope - 0.5;
+    double t2 = (maxV - base) / slope - 0.5;
+    lo = std::max(lo, std::min(t1, t2));
+    hi = std::min(hi, std::max(t1, t2));
+}
+
+}
+
+bool AffineLayer::begin(int w, int h, const double forward[6]) {
+    if (w <= 0 || h <= 0 || w > kMaxSide || h > kMaxSide) return false;
+    const double a = forward[0], b = forward[1], c = forward[2];
+    const double d = forward[3], e = forward[4], f = forward[5];
+    const double det = a * e - b * d;
+    if (std::fabs(det) < 1e-9) return false;
+
+    width = w;
+    height = h;
+    stride = w + 2 * kPad;
+    texels.assign((size_t)stride * (h + 2 * kPad), 0);
+
+    inv[0] = e / det;  inv[1] = -b / det; inv[2] = (b * f - e * c) / det;
+    inv[3] = -d / det; inv[4] = a / det;  inv[5] = (d * c - a * f) / det;
+
+    // Bounding box hasil transform, termasuk setengah piksel ramp anti-alias
+    const double xs[4] = {-0.5, w + 0.5, -0.5, w + 0.5};
+    const double ys[4] = {-0.5, -0.5, h + 0.5, h + 0.5};
+    double minX = 1e30, minY = 1e30, maxX = -1e30, maxY = -1e30;
+    for (int i = 0; i < 4; ++i) {
+        const double x = a * xs[i] + b * ys[i] + c;
+        const double y = d * xs[i] + e * ys[i] + f;
+        minX = std::min(minX, x); maxX = std::max(maxX, x);
+        minY = std::min(minY, y); maxY = std::max(maxY, y);
+    }
+    boundsLeft = (int)std::floor(minX);
+    boundsTop = (int)std::floor(minY);
+    boundsRight = (int)std::ceil(maxX) + 1;
+    boundsBottom = (int)std::ceil(maxY) + 1;
+    return true;
+}
+
+void AffineLayer::setRow(int y, const unsigned char* rgba, unsigned char opacity) {
+    if (y < 0 || y >= height) return;
+    uint32_t* out = texels.data() + (size_t)(y + kPad) * stride + kPad;
+    for (int x = 0; x < width; ++x, rgba += 4) {
+        const unsigned int a = div255(rgba[3] * (unsigned int)opacity);
+        unsigned char px[4] = {
+            (unsigned char)div255(rgba[0] * a),
+            (unsigned char)div255(rgba[1] * a),
+            (unsigned char)div255(rgba[2] * a),
+            (unsigned char)a
+        };
+        std::memcpy(out + x, px, 4);
+    }
+}
+
+void AffineLayer::drawRows(unsigned char* dst, int dstW, int y0, int rows) const {
+    if (texels.empty()) return;
+    const int from = std::max(y0, boundsTop);
+    const int to = std::min(y0 + rows, boundsBottom);
+    // Texel tekstur k berpusat di koordinat bitmap k - kPad + 0.5
+    const double shift = kPad - 0.5;
+    // Area yang terlihat: antara texel border terakhir dan texel isi pertama (ramp 1 piksel)
+    const double eps = 1e-3;
+    const double uMin = kPad - 1 + eps, uMax = width + kPad - eps;
+    const double vMin = kPad - 1 + eps, vMax = height + kPad - eps;
+    for (int py = from; py < to; ++py) {
+        const double yc = py + 0.5;
+        const double uBase = inv[1] * yc + inv[2] + shift;
+        const double vBase = inv[4] * yc + inv[5] + shift;
+        double lo = std::max(0, boundsLeft), hi = std::min(dstW, boundsRight) - 1;
+        limitSpan(inv[0], uBase, uMin, uMax, lo, hi);
+        limitSpan(inv[3], vBase, vMin, vMax, lo, hi);
+        const int px0 = (int)std::ceil(lo);
+        const int px1 = (int)std::floor(hi);
+        if (px0 > px1) continue;
+        const double u = inv[0] * (px0 + 0.5) + uBase;
+        const double v = inv[3] * (px0 + 0.5) + vBase;
+        blendAffineSpan(dst + ((size_t)(py - y0) * dstW + px0) * 4, px1 - px0 + 1, texels.data(), stride,
+                        (int32_t)std::lround(u * 65536.0), (int32_t)std::lround(v * 65536.0),
+                        (int32_t)std::lround(inv[0] * 65536.0), (int32_t)std::lround(inv[3] * 65536.0));
+    }
+}
+
+void blendAffineSpan(unsigned char* dst, int count, const uint32_t* texels, int stride,
+                     int32_t u, int32_t v, int32_t du, int32_t dv) {
+    // Bobot 7-bit: semua perkalian antara muat di u16 (255 * 128)
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi16(255);
+    const __m128i bias = _mm_set1_epi16(128);
+    for (; i < count; ++i, u += du, v += dv, dst += 4) {
+        const uint32_t* p = texels + (size_t)(v >> 16) * stride + (u >> 16);
+        const int fx = (u >> 9) & 127, fy = (v >> 9) & 127;
+        // top = p00 | p01, bot = p10 | p11 sebagai 8 x u16
+        __m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+        __m128i bot = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + stride)), zero);
+        __m128i col = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(top, _mm_set1_epi16((short)(128 - fy))),
+                                                   _mm_mullo_epi16(bot, _mm_set1_epi16((short)fy))), 7);
+        __m128i wx = _mm_unpacklo_epi64(_mm_set1_epi16((short)(128 - fx)), _mm_set1_epi16((short)fx));
+        col = _mm_mullo_epi16(col, wx);
+        __m128i s = _mm_srli_epi16(_mm_add_epi16(col, _mm_srli_si128(col, 8)), 7);
+        const int sa = _mm_extract_epi16(s, 3);
+        if (sa == 0) continue;
+        // dst = s + dst * (255 - sa) / 255
+        uint32_t d32;
+        std::memcpy(&d32, dst, 4);
+        __m128i d = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int)d32), zero);
+        d = _mm_add_epi16(_mm_mullo_epi16(d, _mm_sub_epi16(full, _mm_set1_epi16((short)sa))), bias);
+        d = _mm_srli_epi16(_mm_add_epi16(d, _mm_srli_epi16(d, 8)), 8);
+        d32 = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(_mm_add_epi16(d, s), zero));
+        std::memcpy(dst, &d32, 4);
+    }
+#endif
+    for (; i < count; ++i, u += du, v += dv, dst += 4) {
+        const uint32_t* p = texels + (size_t)(v >> 16) * stride + (u >> 16);
+        const int fx = (u >> 9) & 127, fy = (v >> 9) & 127;
+        const unsigned char* p00 = reinterpret_cast<const unsigned char*>(p);
+        const unsigned char* p01 = p00 + 4;
+        const unsigned char* p10 = reinterpret_cast<const unsigned char*>(p + stride);
+        const unsigned char* p11 = p10 + 4;
+        unsigned int s[4];
+        for (int k = 0; k < 4; ++k) {
+            const unsigned int c0 = (p00[k] * (128 - fy) + p10[k] * fy) >> 7;
+            const unsigned int c1 = (p01[k] * (128 - fy) + p11[k] * fy) >> 7;
+            s[k] = (c0 * (128 - fx) + c1 * fx) >> 7;
+        }
+        if (s[3] == 0) continue;
+        const unsigned int ia = 255 - s[3];
+        for (int k = 0; k < 4; ++k) {
+            dst[k] = (unsigned char)std::min(255u, s[k] + div255(dst[k] * ia));
+        }
+    }
+}
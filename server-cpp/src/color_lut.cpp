@@ -0,0 +1,237 @@
+#include "../include/color_lut.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <dirent.h>
+#include <sys/stat.h>
+
+namespace {
+
+const size_t kMaxCubeBytes = 64u * 1024 * 1024;
+
+uint32_t quantize(float v) {
+    if (!(v > 0.0f)) return 0;  // juga NaN
+    if (v >= 1.0f) return ColorLut::kOne;
+    return static_cast<uint32_t>(std::lround(v * ColorLut::kOne));
+}
+
+uint32_t pack(float r, float g, float b) {
+    return quantize(r) | (quantize(g) << 10) | (quantize(b) << 20);
+}
+
+// ceil((size - 1) * 65536 / 255): v = 255 tepat jatuh di titik terakhir, v lain maks setengah Q7 lebih jauh
+void finish(ColorLut& lut) {
+    lut.positionScale = static_cast<uint16_t>(((lut.size - 1) * 65536 + 254) / 255);
+}
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+bool parseFloats(const char* p, float* out, int count) {
+    for (int i = 0; i < count; ++i) {
+        char* end = nullptr;
+        out[i] = std::strtof(p, &end);
+        if (end == p) return false;
+        p = end;
+    }
+    while (isSpace(*p)) ++p;
+    return *p == '\0';
+}
+
+}
+
+bool parseCubeLut(const std::string& text, ColorLut& lut, std::string& error) {
+    lut = ColorLut();
+    size_t expected = 0;
+    int lineNo = 0;
+    std::string line;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t eol = text.find('\n', pos);
+        if (eol == std::string::npos) eol = text.size();
+        line.assign(text, pos, eol - pos);
+        pos = eol + 1;
+        ++lineNo;
+
+        size_t start = 0;
+        while (start < line.size() && isSpace(line[start])) ++start;
+        if (start == line.size() || line[start] == '#') continue;
+        const char* p = line.c_str() + start;
+        const char c = *p;
+
+        if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.') {
+            if (expected == 0) {
+                error = "data sebelum LUT_3D_SIZE (baris " + std::to_string(lineNo) + ")";
+                return false;
+            }
+            float rgb[3];
+            if (!parseFloats(p, rgb, 3)) {
+                error = "baris data tidak valid (baris " + std::to_string(lineNo) + ")";
+                return false;
+            }
+            if (lut.lattice.size() >= expected) {
+                error = "data lebih dari " + std::to_string(expected) + " titik";
+                return false;
+            }
+            lut.lattice.push_back(pack(rgb[0], rgb[1], rgb[2]));
+            continue;
+        }
+
+        std::istringstream in(line.substr(start));
+        std::string keyword;
+        in >> keyword;
+        if (keyword == "TITLE") {
+            const size_t open = line.find('"');
+            const size_t close = line.rfind('"');
+            if (open != std::string::npos && close > open) lut.title = line.substr(open + 1, close - open - 1);
+        } else if (keyword == "LUT_3D_SIZE") {
+            int size = 0;
+            if (!(in >> size) || size < ColorLut::kMinSize || size > ColorLut::kMaxSize) {
+                error = "LUT_3D_SIZE harus " + std::to_string(ColorLut::kMinSize) + ".." + std::to_string(ColorLut::kMaxSize);
+                return false;
+            }
+            if (expected != 0) {
+                error = "LUT_3D_SIZE muncul dua kali";
+                return false;
+            }
+            lut.size = size;
+            expected = static_cast<size_t>(size) * size * size;
+            lut.lattice.reserve(expected);
+        } else if (keyword == "LUT_1D_SIZE") {
+            error = "LUT 1D tidak didukung";
+            return false;
+        } else if (keyword == "DOMAIN_MIN" || keyword == "DOMAIN_MAX") {
+            const float want = keyword == "DOMAIN_MIN" ? 0.0f : 1.0f;
+            float v[3];
+            if (!(in >> v[0] >> v[1] >> v[2])) {
+                error = keyword + " tidak valid";
+                return false;
+            }
+            for (float x : v) {
+                if (std::fabs(x - want) > 1e-6f) {
+                    error = "domain selain 0..1 tidak didukung";
+                    return false;
+                }
+            }
+        } else if (keyword == "LUT_3D_INPUT_RANGE") {
+            float lo = 0.0f, hi = 0.0f;
+            if (!(in >> lo >> hi) || std::fabs(lo) > 1e-6f || std::fabs(hi - 1.0f) > 1e-6f) {
+                error = "domain selain 0..1 tidak didukung";
+                return false;
+            }
+        }
+        // Keyword lain (LUT_IN_VIDEO_RANGE, dsb. dari Resolve) diabaikan
+    }
+    if (expected == 0) {
+        error = "LUT_3D_SIZE tidak ada";
+        return false;
+    }
+    if (lut.lattice.size() != expected) {
+        error = "jumlah titik " + std::to_string(lut.lattice.size()) + ", seharusnya " + std::to_string(expected);
+        return false;
+    }
+    finish(lut);
+    return true;
+}
+
+bool loadCubeLut(const std::string& path, ColorLut& lut, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "tidak bisa membuka " + path;
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    const std::string text = buffer.str();
+    if (text.size() > kMaxCubeBytes) {
+        error = "file LUT terlalu besar";
+        return false;
+    }
+    return parseCubeLut(text, lut, error);
+}
+
+ColorLut identityLut(int size) {
+    ColorLut lut;
+    lut.title = "identity";
+    lut.size = std::min(ColorLut::kMaxSize, std::max(ColorLut::kMinSize, size));
+    lut.lattice.reserve(static_cast<size_t>(lut.size) * lut.size * lut.size);
+    const float step = 1.0f / (lut.size - 1);
+    for (int b = 0; b < lut.size; ++b) {
+        for (int g = 0; g < lut.size; ++g) {
+            for (int r = 0; r < lut.size; ++r) lut.lattice.push_back(pack(r * step, g * step, b * step));
+        }
+    }
+    finish(lut);
+    return lut;
+}
+
+LutLibrary::LutLibrary(const std::string& dir) : dir(dir) {}
+
+bool LutLibrary::validName(const std::string& name) {
+    if (name.empty() || name.size() > 128 || name[0] == '.') return false;
+    for (char c : name) {
+        const bool ok = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+                        c == '-' || c == '_' || c == '.' || c == ' ';
+        if (!ok) return false;
+    }
+    return true;
+}
+
+std::string LutLibrary::stem(const std::string& name) {
+    const std::string ext = ".cube";
+    if (name.size() > ext.size() && name.compare(name.size() - ext.size(), ext.size(), ext) == 0) {
+        return name.substr(0, name.size() - ext.size());
+    }
+    return name;
+}
+
+std::shared_ptr<const ColorLut> LutLibrary::get(const std::string& name, std::string& error) {
+    const std::string key = stem(name);
+    if (!validName(key)) {
+        error = "nama LUT tidak valid";
+        return nullptr;
+    }
+    const std::string path = dir + "/" + key + ".cube";
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        error = "LUT tidak ditemukan: " + key;
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(mu);
+    auto it = cache.find(key);
+    if (it != cache.end() && it->second.mtime == static_cast<int64_t>(st.st_mtime) &&
+        it->second.size == static_cast<uint64_t>(st.st_size)) {
+        return it->second.lut;
+    }
+    auto lut = std::make_shared<ColorLut>();
+    if (!loadCubeLut(path, *lut, error)) {
+        std::cout << "❌ LUT " << key << ": " << error << std::endl;
+        return nullptr;
+    }
+    std::cout << "🎨 LUT loaded: " << key << " (" << lut->size << "^3"
+              << (lut->title.empty() ? "" : ", \"" + lut->title + "\"") << ")" << std::endl;
+    Entry& entry = cache[key];
+    entry.lut = lut;
+    entry.mtime = static_cast<int64_t>(st.st_mtime);
+    entry.size = static_cast<uint64_t>(st.st_size);
+    return entry.lut;
+}
+
+std::vector<std::string> LutLibrary::list() const {
+    std::vector<std::string> names;
+    DIR* d = opendir(dir.c_str());
+    if (!d) return names;
+    while (struct dirent* e = readdir(d)) {
+        const std::string name = e->d_name;
+        const std::string key = stem(name);
+        if (key != name && validName(key)) names.push_back(key);
+    }
+    closedir(d);
+    std::sort(names.begin(), names.end());
+    return names;
+}
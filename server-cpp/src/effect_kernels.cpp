@@ -0,0 +1,1132 @@
+#include "../include/effect_kernels.h"
+#include "../include/color_lut.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace {
+
+std::atomic<bool> forceScalar(false);
+
+bool useSimd() {
+    return !forceScalar.load(std::memory_order_relaxed);
+}
+
+// fn(y0, y1) untuk pita baris; beberapa pita per thread supaya beban merata. Satu thread = satu
+// pita (blur vertikal membayar pemanasan jendela di awal setiap pita; penting untuk tile runTiled)
+void forEachBand(int height, unsigned maxThreads, const std::function<void(int, int)>& fn) {
+    const unsigned threads = maxThreads == 0 ? parallelThreads() : maxThreads;
+    const int bands = threads <= 1 ? 1 : std::max(1, std::min(height, static_cast<int>(threads) * 4));
+    const int rowsPerBand = (height + bands - 1) / bands;
+    parallelFor(static_cast<size_t>(bands), [&](size_t i) {
+        const int y0 = static_cast<int>(i) * rowsPerBand;
+        const int y1 = std::min(height, y0 + rowsPerBand);
+        if (y0 < y1) fn(y0, y1);
+    }, threads);
+}
+
+// ============ OPERASI TITIK (chunk planar int16) ============
+const int kChunk = 64;  // piksel per chunk; kelipatan 16 supaya AVX2 tidak butuh ekor
+
+struct Planar {
+    alignas(32) int16_t c[3][kChunk];
+};
+
+void loadPlanar(const unsigned char* p, int n, Planar& q) {
+    for (int i = 0; i < n; ++i) {
+        q.c[0][i] = p[3 * i];
+        q.c[1][i] = p[3 * i + 1];
+        q.c[2][i] = p[3 * i + 2];
+    }
+    for (int i = n; i < kChunk; ++i) q.c[0][i] = q.c[1][i] = q.c[2][i] = 0;
+}
+
+void storePlanar(const Planar& q, int n, unsigned char* p) {
+    for (int i = 0; i < n; ++i) {
+        p[3 * i] = static_cast<unsigned char>(q.c[0][i]);
+        p[3 * i + 1] = static_cast<unsigned char>(q.c[1][i]);
+        p[3 * i + 2] = static_cast<unsigned char>(q.c[2][i]);
+    }
+}
+
+// out_k = clamp((w_k . rgb + bias) >> shift), lalu blend ke piksel asli dengan amount/128
+struct ColorMatrix {
+    int16_t w[3][3];
+    int32_t bias;
+    int shift;
+};
+
+// Bobot integer sama dengan worker frontend
+const ColorMatrix kGrayscale = {{{77, 150, 29}, {77, 150, 29}, {77, 150, 29}}, 0, 8};
+const ColorMatrix kSepia = {{{393, 769, 189}, {349, 686, 168}, {272, 534, 131}}, 0, 10};
+const ColorMatrix kInvert = {{{-256, 0, 0}, {0, -256, 0}, {0, 0, -256}}, 255 << 8, 8};
+
+void colorMatrixScalar(Planar& q, int n, const ColorMatrix& m, int amount) {
+    for (int i = 0; i < n; ++i) {
+        const int rgb[3] = {q.c[0][i], q.c[1][i], q.c[2][i]};
+        for (int k = 0; k < 3; ++k) {
+            int v = (rgb[0] * m.w[k][0] + rgb[1] * m.w[k][1] + rgb[2] * m.w[k][2] + m.bias) >> m.shift;
+            v = std::min(255, std::max(0, v));
+            q.c[k][i] = static_cast<int16_t>((rgb[k] * (128 - amount) + v * amount + 64) >> 7);
+        }
+    }
+}
+
+void scaleScalar(Planar& q, int n, const int16_t* factor) {
+    for (int k = 0; k < 3; ++k) {
+        for (int i = 0; i < n; ++i) q.c[k][i] = static_cast<int16_t>((q.c[k][i] * factor[i] + 64) >> 7);
+    }
+}
+
+#if defined(__SSE2__) && !defined(__AVX2__)
+void colorMatrixSse2(Planar& q, int n, const ColorMatrix& m, int amount) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i maxv = _mm_set1_epi16(255);
+    const __m128i a = _mm_set1_epi16(static_cast<short>(amount));
+    const __m128i inva = _mm_set1_epi16(static_cast<short>(128 - amount));
+    const __m128i half = _mm_set1_epi16(64);
+    const __m128i bias = _mm_set1_epi32(m.bias);
+    const __m128i shift = _mm_cvtsi32_si128(m.shift);
+    __m128i wrg[3], wb[3];
+    for (int k = 0; k < 3; ++k) {
+        wrg[k] = _mm_set1_epi32(static_cast<int>((static_cast<uint32_t>(static_cast<uint16_t>(m.w[k][1])) << 16) |
+                                                 static_cast<uint16_t>(m.w[k][0])));
+        wb[k] = _mm_set1_epi32(static_cast<uint16_t>(m.w[k][2]));
+    }
+    for (int i = 0; i < n; i += 8) {
+        __m128i c[3];
+        for (int k = 0; k < 3; ++k) c[k] = _mm_load_si128(reinterpret_cast<const __m128i*>(q.c[k] + i));
+        const __m128i rgLo = _mm_unpacklo_epi16(c[0], c[1]), rgHi = _mm_unpackhi_epi16(c[0], c[1]);
+        const __m128i bLo = _mm_unpacklo_epi16(c[2], zero), bHi = _mm_unpackhi_epi16(c[2], zero);
+        for (int k = 0; k < 3; ++k) {
+            __m128i lo = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(rgLo, wrg[k]), _mm_madd_epi16(bLo, wb[k])), bias);
+            __m128i hi = _mm_add_epi32(_mm_add_epi32(_mm_madd_epi16(rgHi, wrg[k]), _mm_madd_epi16(bHi, wb[k])), bias);
+            __m128i v = _mm_packs_epi32(_mm_sra_epi32(lo, shift), _mm_sra_epi32(hi, shift));
+            v = _mm_min_epi16(_mm_max_epi16(v, zero), maxv);
+            v = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(c[k], inva), _mm_mullo_epi16(v, a)), half);
+            _mm_store_si128(reinterpret_cast<__m128i*>(q.c[k] + i), _mm_srli_epi16(v, 7));
+        }
+    }
+}
+
+void scaleSse2(Planar& q, int n, const int16_t* factor) {
+    const __m128i half = _mm_set1_epi16(64);
+    for (int i = 0; i < n; i += 8) {
+        const __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i*>(factor + i));
+        for (int k = 0; k < 3; ++k) {
+            __m128i* p = reinterpret_cast<__m128i*>(q.c[k] + i);
+            *p = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(*p, f), half), 7);
+        }
+    }
+}
+#endif
+
+#ifdef __AVX2__
+void colorMatrixAvx2(Planar& q, int n, const ColorMatrix& m, int amount) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i maxv = _mm256_set1_epi16(255);
+    const __m256i a = _mm256_set1_epi16(static_cast<short>(amount));
+    const __m256i inva = _mm256_set1_epi16(static_cast<short>(128 - amount));
+    const __m256i half = _mm256_set1_epi16(64);
+    const __m256i bias = _mm256_set1_epi32(m.bias);
+    const __m128i shift = _mm_cvtsi32_si128(m.shift);
+    __m256i wrg[3], wb[3];
+    for (int k = 0; k < 3; ++k) {
+        wrg[k] = _mm256_set1_epi32(static_cast<int>((static_cast<uint32_t>(static_cast<uint16_t>(m.w[k][1])) << 16) |
+                                                    static_cast<uint16_t>(m.w[k][0])));
+        wb[k] = _mm256_set1_epi32(static_cast<uint16_t>(m.w[k][2]));
+    }
+    // unpack/pack AVX2 bekerja per lane 128-bit, urutan piksel kembali seperti semula setelah packs
+    for (int i = 0; i < n; i += 16) {
+        __m256i c[3];
+        for (int k = 0; k < 3; ++k) c[k] = _mm256_load_si256(reinterpret_cast<const __m256i*>(q.c[k] + i));
+        const __m256i rgLo = _mm256_unpacklo_epi16(c[0], c[1]), rgHi = _mm256_unpackhi_epi16(c[0], c[1]);
+        const __m256i bLo = _mm256_unpacklo_epi16(c[2], zero), bHi = _mm256_unpackhi_epi16(c[2], zero);
+        for (int k = 0; k < 3; ++k) {
+            __m256i lo = _mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(rgLo, wrg[k]), _mm256_madd_epi16(bLo, wb[k])), bias);
+            __m256i hi = _mm256_add_epi32(_mm256_add_epi32(_mm256_madd_epi16(rgHi, wrg[k]), _mm256_madd_epi16(bHi, wb[k])), bias);
+            __m256i v = _mm256_packs_epi32(_mm256_sra_epi32(lo, shift), _mm256_sra_epi32(hi, shift));
+            v = _mm256_min_epi16(_mm256_max_epi16(v, zero), maxv);
+            v = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(c[k], inva), _mm256_mullo_epi16(v, a)), half);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(q.c[k] + i), _mm256_srli_epi16(v, 7));
+        }
+    }
+}
+
+void scaleAvx2(Planar& q, int n, const int16_t* factor) {
+    const __m256i half = _mm256_set1_epi16(64);
+    for (int i = 0; i < n; i += 16) {
+        const __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(factor + i));
+        for (int k = 0; k < 3; ++k) {
+            __m256i* p = reinterpret_cast<__m256i*>(q.c[k] + i);
+            *p = _mm256_srli_epi16(_mm256_add_epi16(_mm256_mullo_epi16(*p, f), half), 7);
+        }
+    }
+}
+#endif
+
+void colorMatrix(Planar& q, int n, const ColorMatrix& m, int amount) {
+    if (useSimd()) {
+#if defined(__AVX2__)
+        colorMatrixAvx2(q, n, m, amount);
+        return;
+#elif defined(__SSE2__)
+        colorMatrixSse2(q, n, m, amount);
+        return;
+#endif
+    }
+    colorMatrixScalar(q, n, m, amount);
+}
+
+// factor: satu nilai Q7 (0..128) per piksel, dibaca sampai n dibulatkan ke kelipatan 16
+void scaleByFactor(Planar& q, int n, const int16_t* factor) {
+    if (useSimd()) {
+#if defined(__AVX2__)
+        scaleAvx2(q, n, factor);
+        return;
+#elif defined(__SSE2__)
+        scaleSse2(q, n, factor);
+        return;
+#endif
+    }
+    scaleScalar(q, n, factor);
+}
+
+// ============ 3D LUT (interpolasi tetrahedral, lane uint16) ============
+// Per chunk planar: (1) indeks kisi, bobot dan offset sudut per piksel, (2) ambil 4 titik sudut
+// dari lattice (gather AVX2 atau skalar), (3) jumlah berbobot per channel lalu blend dengan amount.
+// Untuk fraksi terurut f1 >= f2 >= f3 pada sumbu a1, a2, a3:
+//   out = (128 - f1) c000 + (f1 - f2) c[a1] + (f2 - f3) c[a1 + a2] + f3 c111,  a1 + a2 = semua - a3
+// Bila ada fraksi yang sama, sudut yang ambigu berbobot 0 sehingga pilihan sumbunya tidak berpengaruh.
+// Lattice Q1 (maks 510) x bobot Q7 (total 128) <= 65280: akumulasi tetap muat uint16.
+struct LutParams {
+    const uint32_t* lattice;
+    int size;
+    int stride[3];   // 1, size, size^2
+    int offAll;      // sudut c111
+    uint16_t scale;
+    int amount;
+};
+
+struct LutLanes {
+    alignas(32) int16_t index[3][kChunk];  // indeks kisi per sumbu
+    alignas(32) int16_t off1[kChunk];      // sudut kedua: sumbu fraksi terbesar
+    alignas(32) int16_t off2[kChunk];      // sudut ketiga: semua sumbu kecuali fraksi terkecil
+    alignas(32) int16_t w[4][kChunk];
+    alignas(32) uint32_t c[4][kChunk];
+};
+
+void lutWeightsScalar(const Planar& q, int n, const LutParams& p, LutLanes& l) {
+    for (int i = 0; i < n; ++i) {
+        int f[3];
+        for (int k = 0; k < 3; ++k) {
+            const int pos = static_cast<int>(((static_cast<uint32_t>(q.c[k][i]) << 7) * p.scale) >> 16);
+            const int idx = std::min(pos >> 7, p.size - 2);
+            l.index[k][i] = static_cast<int16_t>(idx);
+            f[k] = pos - (idx << 7);
+        }
+        const int fmax = std::max(std::max(f[0], f[1]), f[2]);
+        const int fmin = std::min(std::min(f[0], f[1]), f[2]);
+        const int fmid = f[0] + f[1] + f[2] - fmax - fmin;
+        const int amax = (f[0] >= f[1] && f[0] >= f[2]) ? 0 : (f[1] >= f[2] ? 1 : 2);
+        const int amin = (f[0] <= f[1] && f[0] <= f[2]) ? 0 : (f[1] <= f[2] ? 1 : 2);
+        l.off1[i] = static_cast<int16_t>(p.stride[amax]);
+        l.off2[i] = static_cast<int16_t>(p.offAll - p.stride[amin]);
+        l.w[0][i] = static_cast<int16_t>(128 - fmax);
+        l.w[1][i] = static_cast<int16_t>(fmax - fmid);
+        l.w[2][i] = static_cast<int16_t>(fmid - fmin);
+        l.w[3][i] = static_cast<int16_t>(fmin);
+    }
+}
+
+void lutFetchScalar(int n, const LutParams& p, LutLanes& l) {
+    for (int i = 0; i < n; ++i) {
+        const uint32_t* c = p.lattice + l.index[0][i] + l.index[1][i] * p.stride[1] + l.index[2][i] * p.stride[2];
+        l.c[0][i] = c[0];
+        l.c[1][i] = c[l.off1[i]];
+        l.c[2][i] = c[l.off2[i]];
+        l.c[3][i] = c[p.offAll];
+    }
+}
+
+void lutBlendScalar(Planar& q, int n, const LutParams& p, const LutLanes& l) {
+    for (int i = 0; i < n; ++i) {
+        for (int ch = 0; ch < 3; ++ch) {
+            int acc = 0;
+            for (int k = 0; k < 4; ++k) acc += static_cast<int>((l.c[k][i] >> (10 * ch)) & 1023) * l.w[k][i];
+            const int v = (acc + 128) >> 8;
+            q.c[ch][i] = static_cast<int16_t>((q.c[ch][i] * (128 - p.amount) + v * p.amount + 64) >> 7);
+        }
+    }
+}
+
+#ifdef __SSE2__
+// Dipakai juga di build AVX2; hanya pengambilan titik sudut yang punya jalur AVX2 (gather)
+void lutWeightsSse2(const Planar& q, int n, const LutParams& p, LutLanes& l) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i scale = _mm_set1_epi16(static_cast<short>(p.scale));
+    const __m128i top = _mm_set1_epi16(static_cast<short>(p.size - 2));
+    const __m128i one = _mm_set1_epi16(128);
+    const __m128i s0 = _mm_set1_epi16(static_cast<short>(p.stride[0]));
+    const __m128i s1 = _mm_set1_epi16(static_cast<short>(p.stride[1]));
+    const __m128i s2 = _mm_set1_epi16(static_cast<short>(p.stride[2]));
+    const __m128i all = _mm_set1_epi16(static_cast<short>(p.offAll));
+    auto select = [](__m128i mask, __m128i a, __m128i b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); };
+    for (int i = 0; i < n; i += 8) {
+        __m128i f[3];
+        for (int k = 0; k < 3; ++k) {
+            const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(q.c[k] + i));
+            const __m128i pos = _mm_mulhi_epu16(_mm_slli_epi16(v, 7), scale);
+            const __m128i idx = _mm_min_epi16(_mm_srli_epi16(pos, 7), top);
+            _mm_store_si128(reinterpret_cast<__m128i*>(l.index[k] + i), idx);
+            f[k] = _mm_sub_epi16(pos, _mm_slli_epi16(idx, 7));
+        }
+        const __m128i fmax = _mm_max_epi16(_mm_max_epi16(f[0], f[1]), f[2]);
+        const __m128i fmin = _mm_min_epi16(_mm_min_epi16(f[0], f[1]), f[2]);
+        const __m128i fmid = _mm_sub_epi16(_mm_add_epi16(_mm_add_epi16(f[0], f[1]), f[2]), _mm_add_epi16(fmax, fmin));
+        // Urutan pemilihan sumbu sama dengan jalur skalar (r, lalu g, lalu b)
+        const __m128i rMax = _mm_cmpeq_epi16(_mm_or_si128(_mm_cmpgt_epi16(f[1], f[0]), _mm_cmpgt_epi16(f[2], f[0])), zero);
+        const __m128i gMax = _mm_cmpeq_epi16(_mm_cmpgt_epi16(f[2], f[1]), zero);
+        const __m128i rMin = _mm_cmpeq_epi16(_mm_or_si128(_mm_cmpgt_epi16(f[0], f[1]), _mm_cmpgt_epi16(f[0], f[2])), zero);
+        const __m128i gMin = _mm_cmpeq_epi16(_mm_cmpgt_epi16(f[1], f[2]), zero);
+        _mm_store_si128(reinterpret_cast<__m128i*>(l.off1 + i), select(rMax, s0, select(gMax, s1, s2)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(l.off2 + i), _mm_sub_epi16(all, select(rMin, s0, select(gMin, s1, s2))));
+        _mm_store_si128(reinterpret_cast<__m128i*>(l.w[0] + i), _mm_sub_epi16(one, fmax));
+        _mm_store_si128(reinterpret_cast<__m128i*>(l.w[1] + i), _mm_sub_epi16(fmax, fmid));
+        _mm_store_si128(reinterpret_cast<__m128i*>(l.w[2] + i), _mm_sub_epi16(fmid, fmin));
+        _mm_store_si128(reinterpret_cast<__m128i*>(l.w[3] + i), fmin);
+    }
+}
+
+void lutBlendSse2(Planar& q, int n, const LutParams& p, const LutLanes& l) {
+    const __m128i mask = _mm_set1_epi32(1023);
+    const __m128i round = _mm_set1_epi16(128);
+    const __m128i a = _mm_set1_epi16(static_cast<short>(p.amount));
+    const __m128i inva = _mm_set1_epi16(static_cast<short>(128 - p.amount));
+    const __m128i half = _mm_set1_epi16(64);
+    for (int i = 0; i < n; i += 8) {
+        __m128i acc[3] = {_mm_setzero_si128(), _mm_setzero_si128(), _mm_setzero_si128()};
+        for (int k = 0; k < 4; ++k) {
+            const __m128i w = _mm_load_si128(reinterpret_cast<const __m128i*>(l.w[k] + i));
+            const __m128i lo = _mm_load_si128(reinterpret_cast<const __m128i*>(l.c[k] + i));
+            const __m128i hi = _mm_load_si128(reinterpret_cast<const __m128i*>(l.c[k] + i + 4));
+            const __m128i r = _mm_packs_epi32(_mm_and_si128(lo, mask), _mm_and_si128(hi, mask));
+            const __m128i g = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(lo, 10), mask), _mm_and_si128(_mm_srli_epi32(hi, 10), mask));
+            const __m128i b = _mm_packs_epi32(_mm_srli_epi32(lo, 20), _mm_srli_epi32(hi, 20));
+            acc[0] = _mm_add_epi16(acc[0], _mm_mullo_epi16(r, w));
+            acc[1] = _mm_add_epi16(acc[1], _mm_mullo_epi16(g, w));
+            acc[2] = _mm_add_epi16(acc[2], _mm_mullo_epi16(b, w));
+        }
+        for (int ch = 0; ch < 3; ++ch) {
+            __m128i* c = reinterpret_cast<__m128i*>(q.c[ch] + i);
+            const __m128i v = _mm_srli_epi16(_mm_add_epi16(acc[ch], round), 8);
+            *c = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(*c, inva), _mm_mullo_epi16(v, a)), half), 7);
+        }
+    }
+}
+#endif
+
+#ifdef __AVX2__
+void lutFetchAvx2(int n, const LutParams& p, LutLanes& l) {
+    const int* lattice = reinterpret_cast<const int*>(p.lattice);
+    const __m256i sg = _mm256_set1_epi32(p.stride[1]);
+    const __m256i sb = _mm256_set1_epi32(p.stride[2]);
+    const __m256i all = _mm256_set1_epi32(p.offAll);
+    auto widen = [](const int16_t* v) { return _mm256_cvtepi16_epi32(_mm_load_si128(reinterpret_cast<const __m128i*>(v))); };
+    for (int i = 0; i < n; i += 8) {
+        const __m256i base = _mm256_add_epi32(_mm256_add_epi32(widen(l.index[0] + i), _mm256_mullo_epi32(widen(l.index[1] + i), sg)),
+                                              _mm256_mullo_epi32(widen(l.index[2] + i), sb));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(l.c[0] + i), _mm256_i32gather_epi32(lattice, base, 4));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(l.c[1] + i),
+                           _mm256_i32gather_epi32(lattice, _mm256_add_epi32(base, widen(l.off1 + i)), 4));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(l.c[2] + i),
+                           _mm256_i32gather_epi32(lattice, _mm256_add_epi32(base, widen(l.off2 + i)), 4));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(l.c[3] + i), _mm256_i32gather_epi32(lattice, _mm256_add_epi32(base, all), 4));
+    }
+}
+#endif
+
+void lutChunk(Planar& q, int n, const LutParams& p) {
+    LutLanes l;
+#ifdef __SSE2__
+    if (useSimd()) {
+        // Lane padding chunk berisi 0, indeksnya tetap valid
+        const int padded = (n + 7) & ~7;
+        lutWeightsSse2(q, padded, p, l);
+#ifdef __AVX2__
+        lutFetchAvx2(padded, p, l);
+#else
+        lutFetchScalar(padded, p, l);
+#endif
+        lutBlendSse2(q, padded, p, l);
+        return;
+    }
+#endif
+    lutWeightsScalar(q, n, p, l);
+    lutFetchScalar(n, p, l);
+    lutBlendScalar(q, n, p, l);
+}
+
+LutParams lutParamsFor(const ColorLut& lut, int amount) {
+    LutParams p;
+    p.lattice = lut.lattice.data();
+    p.size = lut.size;
+    p.stride[0] = 1;
+    p.stride[1] = lut.size;
+    p.stride[2] = lut.size * lut.size;
+    p.offAll = 1 + lut.size + lut.size * lut.size;
+    p.scale = lut.positionScale;
+    p.amount = amount;
+    return p;
+}
+
+// ============ RANTAI OPERASI TITIK (satu pass per chunk) ============
+struct PreparedOp {
+    PointOp::Kind kind;
+    const ColorMatrix* matrix;
+    int amount;
+    LutParams lut;
+    float vignetteK;
+    int factorRow;   // indeks baris faktor vignette milik op ini
+};
+
+// Faktor vignette Q7 satu baris: max(0, 1 - jarak * k) * 128
+void vignetteRow(int16_t* factor, int width, float cx, float dy, float k) {
+    const float dy2 = dy * dy;
+    int x = 0;
+#ifdef __SSE2__
+    if (useSimd()) {
+        const __m128 kv = _mm_set1_ps(k), one = _mm_set1_ps(1.0f), zero = _mm_setzero_ps();
+        const __m128 scale = _mm_set1_ps(128.0f), half = _mm_set1_ps(0.5f), dy2v = _mm_set1_ps(dy2);
+        for (; x + 4 <= width; x += 4) {
+            const __m128 dx = _mm_sub_ps(_mm_setr_ps(x, x + 1.0f, x + 2.0f, x + 3.0f), _mm_set1_ps(cx));
+            const __m128 d = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), dy2v));
+            const __m128 v = _mm_max_ps(zero, _mm_sub_ps(one, _mm_mul_ps(d, kv)));
+            const __m128i f = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half));
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(factor + x), _mm_packs_epi32(f, f));
+        }
+    }
+#endif
+    for (; x < width; ++x) {
+        const float dx = x - cx;
+        const float v = std::max(0.0f, 1.0f - std::sqrt(dx * dx + dy2) * k);
+        factor[x] = static_cast<int16_t>(v * 128.0f + 0.5f);
+    }
+}
+
+// Op yang tidak berefek (amount 0, strength 0, LUT kosong) dibuang
+std::vector<PreparedOp> prepareOps(const std::vector<PointOp>& ops, int width, int height, int& factorRows) {
+    std::vector<PreparedOp> prepared;
+    factorRows = 0;
+    const float diagonal = std::sqrt(width * width * 0.25f + height * height * 0.25f);
+    for (const auto& op : ops) {
+        PreparedOp p = {op.kind, nullptr, std::min(128, std::max(0, op.amount)), LutParams(), 0.0f, -1};
+        switch (op.kind) {
+            case PointOp::Grayscale: p.matrix = &kGrayscale; break;
+            case PointOp::Sepia: p.matrix = &kSepia; break;
+            case PointOp::Invert: p.matrix = &kInvert; break;
+            case PointOp::Lut:
+                if (!op.lut || op.lut->size < ColorLut::kMinSize || op.lut->size > ColorLut::kMaxSize ||
+                    op.lut->lattice.size() != static_cast<size_t>(op.lut->size) * op.lut->size * op.lut->size) {
+                    continue;
+                }
+                p.lut = lutParamsFor(*op.lut, p.amount);
+                break;
+            case PointOp::Vignette:
+                if (!(op.strength > 0.0f)) continue;
+                p.amount = 128;
+                p.vignetteK = op.strength / diagonal;
+                p.factorRow = factorRows++;
+                break;
+        }
+        if (p.amount > 0) prepared.push_back(p);
+    }
+    return prepared;
+}
+
+// ============ SAMPLING BILINEAR (koordinat Q8) ============
+// Dua tahap pembulatan ke bawah (vertikal lalu horizontal), sama persis di jalur SIMD dan skalar
+void sampleScalar(const unsigned char* src, int width, int height, int32_t sx, int32_t sy, unsigned char* out) {
+    const int x0 = sx >> 8, y0 = sy >> 8, fx = sx & 255, fy = sy & 255;
+    const int x1 = std::min(x0 + 1, width - 1), y1 = std::min(y0 + 1, height - 1);
+    const size_t stride = static_cast<size_t>(width) * 3;
+    const unsigned char* t0 = src + y0 * stride + x0 * 3;
+    const unsigned char* t1 = src + y0 * stride + x1 * 3;
+    const unsigned char* b0 = src + y1 * stride + x0 * 3;
+    const unsigned char* b1 = src + y1 * stride + x1 * 3;
+    for (int c = 0; c < 3; ++c) {
+        const int l = (t0[c] * (256 - fy) + b0[c] * fy) >> 8;
+        const int r = (t1[c] * (256 - fy) + b1[c] * fy) >> 8;
+        out[c] = static_cast<unsigned char>((l * (256 - fx) + r * fx) >> 8);
+    }
+}
+
+// Sampel piksel [x, count) dari koordinat sx/sy ke dstRow
+void sampleRowSse2OrScalar(const unsigned char* src, int width, int height, const int32_t* sx, const int32_t* sy,
+                           int x, int count, unsigned char* dstRow) {
+#ifdef __SSE2__
+    const bool simd = useSimd();
+    const __m128i zero = _mm_setzero_si128();
+    const size_t stride = static_cast<size_t>(width) * 3;
+#endif
+    for (; x < count; ++x) {
+        unsigned char* out = dstRow + x * 3;
+#ifdef __SSE2__
+        const int x0 = sx[x] >> 8, y0 = sy[x] >> 8;
+        // Load 8 byte (dua piksel + 2 byte lebih) masih di dalam buffer
+        if (simd && x0 <= width - 3 && y0 <= height - 2) {
+            const int fx = sx[x] & 255, fy = sy[x] & 255;
+            const unsigned char* p = src + y0 * stride + x0 * 3;
+            const __m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)), zero);
+            const __m128i bot = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p + stride)), zero);
+            __m128i col = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(top, _mm_set1_epi16(static_cast<short>(256 - fy))),
+                                                       _mm_mullo_epi16(bot, _mm_set1_epi16(static_cast<short>(fy)))), 8);
+            __m128i v = _mm_srli_epi16(_mm_add_epi16(_mm_mullo_epi16(col, _mm_set1_epi16(static_cast<short>(256 - fx))),
+                                                     _mm_mullo_epi16(_mm_srli_si128(col, 6), _mm_set1_epi16(static_cast<short>(fx)))), 8);
+            const uint32_t px = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(v, zero)));
+            std::memcpy(out, &px, 3);
+            continue;
+        }
+#endif
+        sampleScalar(src, width, height, sx[x], sy[x], out);
+    }
+}
+
+#ifdef __AVX2__
+// 8 piksel per langkah: empat gather 32-bit (RGB + 1 byte tetangga) untuk keempat sudut,
+// interpolasi per channel di lane int32, lalu dipadatkan kembali ke 24 byte RGB
+int sampleRowAvx2(const unsigned char* src, int width, int height, const int32_t* sx, const int32_t* sy,
+                  int count, unsigned char* dstRow) {
+    if (width < 3 || height < 2) return 0;
+    const int stride = width * 3;
+    const int* base = reinterpret_cast<const int*>(src);
+    const __m256i mask = _mm256_set1_epi32(255);
+    const __m256i one = _mm256_set1_epi32(256);
+    const __m256i three = _mm256_set1_epi32(3);
+    const __m256i strideV = _mm256_set1_epi32(stride);
+    const __m256i lastX = _mm256_set1_epi32(width - 3), lastY = _mm256_set1_epi32(height - 2);
+    const __m256i pack = _mm256_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+                                          0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+    int x = 0;
+    for (; x + 8 <= count; x += 8) {
+        const __m256i qx = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sx + x));
+        const __m256i qy = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(sy + x));
+        const __m256i x0 = _mm256_srai_epi32(qx, 8), y0 = _mm256_srai_epi32(qy, 8);
+        // Gather 4 byte di sudut kanan bawah harus tetap di dalam buffer
+        if (_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpgt_epi32(x0, lastX), _mm256_cmpgt_epi32(y0, lastY))) != 0) {
+            sampleRowSse2OrScalar(src, width, height, sx, sy, x, x + 8, dstRow);
+            continue;
+        }
+        const __m256i fx = _mm256_and_si256(qx, mask), fy = _mm256_and_si256(qy, mask);
+        const __m256i ifx = _mm256_sub_epi32(one, fx), ify = _mm256_sub_epi32(one, fy);
+        const __m256i off = _mm256_add_epi32(_mm256_mullo_epi32(y0, strideV), _mm256_mullo_epi32(x0, three));
+        const __m256i t0 = _mm256_i32gather_epi32(base, off, 1);
+        const __m256i t1 = _mm256_i32gather_epi32(base, _mm256_add_epi32(off, three), 1);
+        const __m256i b0 = _mm256_i32gather_epi32(base, _mm256_add_epi32(off, strideV), 1);
+        const __m256i b1 = _mm256_i32gather_epi32(base, _mm256_add_epi32(off, _mm256_add_epi32(strideV, three)), 1);
+        __m256i out = _mm256_setzero_si256();
+        for (int c = 0; c < 3; ++c) {
+            const __m128i shift = _mm_cvtsi32_si128(8 * c);
+            auto channel = [&](__m256i v) { return _mm256_and_si256(_mm256_srl_epi32(v, shift), mask); };
+            const __m256i l = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(channel(t0), ify),
+                                                                 _mm256_mullo_epi32(channel(b0), fy)), 8);
+            const __m256i r = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(channel(t1), ify),
+                                                                 _mm256_mullo_epi32(channel(b1), fy)), 8);
+            const __m256i v = _mm256_srli_epi32(_mm256_add_epi32(_mm256_mullo_epi32(l, ifx), _mm256_mullo_epi32(r, fx)), 8);
+            out = _mm256_or_si256(out, _mm256_sll_epi32(v, shift));
+        }
+        const __m256i packed = _mm256_shuffle_epi8(out, pack);
+        unsigned char* dst = dstRow + x * 3;
+        // 16 byte pertama (4 byte sisa ditimpa 12 byte berikutnya), tidak pernah lewat 24 byte grup ini
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_castsi256_si128(packed));
+        alignas(16) unsigned char upper[16];
+        _mm_store_si128(reinterpret_cast<__m128i*>(upper), _mm256_extracti128_si256(packed, 1));
+        std::memcpy(dst + 12, upper, 12);
+    }
+    return x;
+}
+#endif
+
+void sampleRow(const unsigned char* src, int width, int height, const int32_t* sx, const int32_t* sy, int count,
+               unsigned char* dstRow) {
+    int x = 0;
+#ifdef __AVX2__
+    if (useSimd()) x = sampleRowAvx2(src, width, height, sx, sy, count, dstRow);
+#endif
+    if (x < count) sampleRowSse2OrScalar(src, width, height, sx, sy, x, count, dstRow);
+}
+
+// ============ TABEL REMAP (fisheye / wide angle) ============
+// Kedua distorsi simetris radial terhadap pusat (w/2, h/2), jadi cukup satu kuadran:
+// entri (i, j) = perpindahan sumber untuk |dx| = i + fracX, |dy| = j + fracY dalam fixed-point
+// int16 dengan fracBits bit pecahan (dipilih supaya perpindahan terbesar masih muat).
+// 24 MP -> ~24 MB, preview 1080p -> ~2 MB.
+enum class LensKind { Fisheye, WideAngle };
+
+struct RemapKey {
+    LensKind kind;
+    int width;
+    int height;
+    int strength;  // x 1e4
+    int radius;    // x 1e4
+    bool operator==(const RemapKey& o) const {
+        return kind == o.kind && width == o.width && height == o.height && strength == o.strength && radius == o.radius;
+    }
+};
+
+struct RemapTable {
+    int width = 0, height = 0;
+    int cols = 0, rows = 0;
+    float cx = 0.0f, cy = 0.0f;
+    int fracBits = 8;
+    std::vector<int16_t> disp;  // (dx, dy) per entri, baris j = |dy|
+    std::vector<int> active;    // per baris j: entri i >= active[j] tidak berpindah (cukup disalin)
+    size_t bytes() const { return disp.size() * sizeof(int16_t) + active.size() * sizeof(int); }
+};
+
+// Perpindahan (>= 0 ke arah menjauhi pusat bila positif) untuk titik di kuadran positif
+struct Lens {
+    LensKind kind;
+    float a = 0.0f, b = 0.0f;
+
+    explicit Lens(const RemapKey& key) : kind(key.kind) {
+        const float cx = key.width * 0.5f, cy = key.height * 0.5f;
+        const float strength = key.strength / 10000.0f;
+        if (kind == LensKind::Fisheye) {
+            // Barrel frontend di dalam lingkaran: r' = r * (1 + strength * r^2)
+            const float maxR = std::min(cx, cy) * 0.9f * (key.radius / 10000.0f);
+            a = maxR * maxR;
+            b = strength / a;
+        } else {
+            // Barrel satu frame dinormalisasi ke sudut: s = (1 + k * r^2 / diag^2) / (1 + k)
+            a = strength / (cx * cx + cy * cy);
+            b = 1.0f / (1.0f + strength);
+        }
+    }
+
+    void operator()(float adx, float ady, float& ox, float& oy) const {
+        const float d2 = adx * adx + ady * ady;
+        float s;
+        if (kind == LensKind::Fisheye) {
+            s = d2 > a ? 1.0f : 1.0f + b * d2;
+        } else {
+            s = (1.0f + a * d2) * b;
+        }
+        ox = adx * (s - 1.0f);
+        oy = ady * (s - 1.0f);
+    }
+};
+
+std::shared_ptr<const RemapTable> buildRemapTable(const RemapKey& key, unsigned maxThreads) {
+    auto table = std::make_shared<RemapTable>();
+    table->width = key.width;
+    table->height = key.height;
+    table->cx = key.width * 0.5f;
+    table->cy = key.height * 0.5f;
+    const float fracX = table->cx - std::floor(table->cx), fracY = table->cy - std::floor(table->cy);
+    table->cols = static_cast<int>(std::max(table->cx, key.width - 1 - table->cx)) + 1;
+    table->rows = static_cast<int>(std::max(table->cy, key.height - 1 - table->cy)) + 1;
+    const Lens lens(key);
+
+    // Lewatan pertama hanya mencari perpindahan terbesar untuk memilih presisi
+    const unsigned threads = maxThreads == 0 ? parallelThreads() : maxThreads;
+    std::vector<float> bandMax(static_cast<size_t>(threads) * 4 + 1, 0.0f);
+    std::atomic<size_t> bandSlot(0);
+    forEachBand(table->rows, threads, [&](int j0, int j1) {
+        float m = 0.0f;
+        for (int j = j0; j < j1; ++j) {
+            for (int i = 0; i < table->cols; ++i) {
+                float ox, oy;
+                lens(i + fracX, j + fracY, ox, oy);
+                m = std::max(m, std::max(std::fabs(ox), std::fabs(oy)));
+            }
+        }
+        bandMax[std::min(bandSlot++, bandMax.size() - 1)] = m;
+    });
+    const float maxDisp = *std::max_element(bandMax.begin(), bandMax.end());
+    while (table->fracBits > 0 && maxDisp * (1 << table->fracBits) > 32767.0f) --table->fracBits;
+
+    table->disp.resize(static_cast<size_t>(table->cols) * table->rows * 2);
+    table->active.assign(table->rows, 0);
+    const float scale = static_cast<float>(1 << table->fracBits);
+    forEachBand(table->rows, threads, [&](int j0, int j1) {
+        for (int j = j0; j < j1; ++j) {
+            int16_t* row = table->disp.data() + static_cast<size_t>(j) * table->cols * 2;
+            for (int i = 0; i < table->cols; ++i) {
+                float ox, oy;
+                lens(i + fracX, j + fracY, ox, oy);
+                row[2 * i] = static_cast<int16_t>(std::lround(std::max(-32767.0f, std::min(32767.0f, ox * scale))));
+                row[2 * i + 1] = static_cast<int16_t>(std::lround(std::max(-32767.0f, std::min(32767.0f, oy * scale))));
+                if (row[2 * i] != 0 || row[2 * i + 1] != 0) table->active[j] = i + 1;
+            }
+        }
+    });
+    return table;
+}
+
+// Cache beberapa tabel terakhir (preview dan capture biasanya bergantian), dibatasi total byte
+const size_t kRemapCacheBytes = 64u << 20;
+
+std::mutex remapMu;
+std::list<std::pair<RemapKey, std::shared_ptr<const RemapTable>>> remapCache;
+
+std::shared_ptr<const RemapTable> remapTableFor(const RemapKey& key, unsigned maxThreads) {
+    {
+        std::lock_guard<std::mutex> lock(remapMu);
+        for (auto it = remapCache.begin(); it != remapCache.end(); ++it) {
+            if (it->first == key) {
+                remapCache.splice(remapCache.begin(), remapCache, it);
+                return remapCache.front().second;
+            }
+        }
+    }
+    // Dibangun di luar lock; permintaan kembar paling buruk membangun dua kali
+    auto table = buildRemapTable(key, maxThreads);
+    std::lock_guard<std::mutex> lock(remapMu);
+    for (const auto& entry : remapCache) {
+        if (entry.first == key) return entry.second;
+    }
+    remapCache.emplace_front(key, table);
+    size_t total = 0;
+    for (auto it = remapCache.begin(); it != remapCache.end();) {
+        total += it->second->bytes();
+        if (it != remapCache.begin() && total > kRemapCacheBytes) {
+            total -= it->second->bytes();
+            it = remapCache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return table;
+}
+
+// Koordinat sumber Q8 untuk kolom [xa, xb) baris y, yaitu bagian baris yang berpindah
+// (tanda perpindahan mengikuti sisi pusat); di luar rentang itu piksel cukup disalin
+void expandRow(const RemapTable& t, int y, int32_t* sx, int32_t* sy, int& xa, int& xb) {
+    const bool above = y < t.cy;
+    const int j = static_cast<int>(above ? t.cy - y : y - t.cy);
+    const int act = t.active[j];
+    xa = std::max(0, static_cast<int>(std::floor(t.cx - act)) + 1);
+    xb = std::min(t.width, static_cast<int>(std::ceil(t.cx + act)));
+    const int shift = 8 - t.fracBits;
+    const int32_t maxX = (t.width - 1) << 8, maxY = (t.height - 1) << 8;
+    const int16_t* row = t.disp.data() + static_cast<size_t>(j) * t.cols * 2;
+    const int32_t baseY = y << 8;
+    const int split = std::max(xa, std::min(xb, static_cast<int>(std::ceil(t.cx))));
+    for (int x = xa; x < split; ++x) {
+        const int i = static_cast<int>(t.cx - x);
+        const int32_t dx = static_cast<int32_t>(row[2 * i]) << shift, dy = static_cast<int32_t>(row[2 * i + 1]) << shift;
+        sx[x] = std::min(maxX, std::max(0, (x << 8) - dx));
+        sy[x] = std::min(maxY, std::max(0, above ? baseY - dy : baseY + dy));
+    }
+    for (int x = split; x < xb; ++x) {
+        const int i = static_cast<int>(x - t.cx);
+        const int32_t dx = static_cast<int32_t>(row[2 * i]) << shift, dy = static_cast<int32_t>(row[2 * i + 1]) << shift;
+        sx[x] = std::min(maxX, std::max(0, (x << 8) + dx));
+        sy[x] = std::min(maxY, std::max(0, above ? baseY - dy : baseY + dy));
+    }
+}
+
+void remapImage(const unsigned char* src, unsigned char* dst, const RemapTable& table, unsigned maxThreads) {
+    const size_t stride = static_cast<size_t>(table.width) * 3;
+    forEachBand(table.height, maxThreads, [&](int y0, int y1) {
+        std::vector<int32_t> sx(table.width), sy(table.width);
+        for (int y = y0; y < y1; ++y) {
+            int xa = 0, xb = 0;
+            expandRow(table, y, sx.data(), sy.data(), xa, xb);
+            const unsigned char* in = src + y * stride;
+            unsigned char* out = dst + y * stride;
+            if (xa >= xb) {
+                std::memcpy(out, in, stride);
+                continue;
+            }
+            std::memcpy(out, in, static_cast<size_t>(xa) * 3);
+            sampleRow(src, table.width, table.height, sx.data() + xa, sy.data() + xa, xb - xa, out + xa * 3);
+            std::memcpy(out + xb * 3, in + xb * 3, static_cast<size_t>(table.width - xb) * 3);
+        }
+    });
+}
+
+int quantizeParam(float v) {
+    return static_cast<int>(std::lround(v * 10000.0f));
+}
+
+// ============ BLUR (sliding sum, waktu konstan terhadap radius) ============
+// Gaussian didekati tiga box berurutan per arah; biaya setiap box tidak bergantung radius.
+// - Horizontal: per baris, prefix sum uint16 (wrap-around aman karena selisih jendela <= 255 * 255)
+//   lalu out = (P[x + r] - P[x - r - 1]) / n delapan byte sekaligus. Baris tinggal di L1.
+// - Vertikal: satu baris jumlah berjalan selebar gambar; setiap baris output hanya +1 baris masuk
+//   dan -1 baris keluar, semua akses baris berurutan (tanpa stride kolom).
+// Keduanya paralel per pita baris dan bekerja per byte (operasinya sama untuk ketiga channel).
+const int kMaxBoxRadius = 127;     // n = 255: (255 * 255 + n/2) masih muat uint16
+const float kMaxBlurSigma = 100.0f;
+
+// Rata-rata sum/n dibulatkan: (sum + n/2) * ceil(65536/n) >> 16
+struct Divider {
+    explicit Divider(int n) : half(n / 2), inv((65536 + n - 1) / n) {}
+    int apply(int sum) const { return ((sum + half) * inv) >> 16; }
+    int half;
+    int inv;
+};
+
+// Radius tiga box yang total variansnya mendekati Gaussian sigma (lebar ganjil wl / wl + 2)
+void gaussBoxRadii(float sigma, int radii[3]) {
+    const double n = 3.0;
+    const double s2 = static_cast<double>(sigma) * sigma;
+    int wl = static_cast<int>(std::floor(std::sqrt(12.0 * s2 / n + 1.0)));
+    if (wl % 2 == 0) --wl;
+    const int m = static_cast<int>(std::lround((12.0 * s2 - n * wl * wl - 4.0 * n * wl - 3.0 * n) / (-4.0 * wl - 4.0)));
+    for (int i = 0; i < 3; ++i) radii[i] = std::min(kMaxBoxRadius, ((i < m ? wl : wl + 2) - 1) / 2);
+}
+
+// out[j] = avg(window[j]) dengan sum = hi[j] - lo[j] (uint16, modulo 2^16)
+void windowAverage(const uint16_t* hi, const uint16_t* lo, int count, const Divider& div, unsigned char* out) {
+    int j = 0;
+#ifdef __SSE2__
+    if (useSimd()) {
+        const __m128i half = _mm_set1_epi16(static_cast<short>(div.half));
+        const __m128i inv = _mm_set1_epi16(static_cast<short>(div.inv));
+        for (; j + 16 <= count; j += 16) {
+            const __m128i a = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hi + j)),
+                                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(lo + j)));
+            const __m128i b = _mm_sub_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hi + j + 8)),
+                                            _mm_loadu_si128(reinterpret_cast<const __m128i*>(lo + j + 8)));
+            const __m128i va = _mm_mulhi_epu16(_mm_add_epi16(a, half), inv);
+            const __m128i vb = _mm_mulhi_epu16(_mm_add_epi16(b, half), inv);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), _mm_packus_epi16(va, vb));
+        }
+    }
+#endif
+    for (; j < count; ++j) out[j] = static_cast<unsigned char>(div.apply(static_cast<uint16_t>(hi[j] - lo[j])));
+}
+
+// Box horizontal satu baris src -> dst (boleh sama). prefix: (width + 2 * radius + 2) * 3 entri,
+// P[m] = jumlah piksel -radius .. m - 1 - radius dengan tepi di-clamp
+void boxPassRow(const unsigned char* src, unsigned char* dst, int width, int radius, uint16_t* prefix) {
+    uint16_t a0 = 0, a1 = 0, a2 = 0;
+    uint16_t* p = prefix;
+    *p++ = 0;
+    *p++ = 0;
+    *p++ = 0;
+    auto push = [&](const unsigned char* px) {
+        a0 = static_cast<uint16_t>(a0 + px[0]);
+        a1 = static_cast<uint16_t>(a1 + px[1]);
+        a2 = static_cast<uint16_t>(a2 + px[2]);
+        *p++ = a0;
+        *p++ = a1;
+        *p++ = a2;
+    };
+    for (int i = 0; i < radius; ++i) push(src);
+    for (int x = 0; x < width; ++x) push(src + x * 3);
+    for (int i = 0; i <= radius; ++i) push(src + (width - 1) * 3);
+    windowAverage(prefix + (2 * radius + 1) * 3, prefix, width * 3, Divider(2 * radius + 1), dst);
+}
+
+// Box vertikal src -> dst (buffer berbeda), baris [y0, y1). sums: satu baris uint16 selebar stride
+void boxPassColumns(const unsigned char* src, unsigned char* dst, size_t stride, int height, int y0, int y1,
+                    int radius, uint16_t* sums) {
+    const Divider div(2 * radius + 1);
+    const int count = static_cast<int>(stride);
+    auto row = [&](int y) { return src + static_cast<size_t>(std::min(height - 1, std::max(0, y))) * stride; };
+    std::fill(sums, sums + count, 0);
+    for (int k = y0 - radius; k <= y0 + radius; ++k) {
+        const unsigned char* r = row(k);
+        for (int j = 0; j < count; ++j) sums[j] = static_cast<uint16_t>(sums[j] + r[j]);
+    }
+    for (int y = y0; y < y1; ++y) {
+        const unsigned char* add = row(y + radius + 1);
+        const unsigned char* sub = row(y - radius);
+        unsigned char* out = dst + static_cast<size_t>(y) * stride;
+        int j = 0;
+#ifdef __SSE2__
+        if (useSimd()) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i half = _mm_set1_epi16(static_cast<short>(div.half));
+            const __m128i inv = _mm_set1_epi16(static_cast<short>(div.inv));
+            for (; j + 16 <= count; j += 16) {
+                __m128i* s = reinterpret_cast<__m128i*>(sums + j);
+                __m128i lo = _mm_loadu_si128(s), hi = _mm_loadu_si128(s + 1);
+                const __m128i outLo = _mm_mulhi_epu16(_mm_add_epi16(lo, half), inv);
+                const __m128i outHi = _mm_mulhi_epu16(_mm_add_epi16(hi, half), inv);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + j), _mm_packus_epi16(outLo, outHi));
+                const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(add + j));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(sub + j));
+                lo = _mm_sub_epi16(_mm_add_epi16(lo, _mm_unpacklo_epi8(a, zero)), _mm_unpacklo_epi8(b, zero));
+                hi = _mm_sub_epi16(_mm_add_epi16(hi, _mm_unpackhi_epi8(a, zero)), _mm_unpackhi_epi8(b, zero));
+                _mm_storeu_si128(s, lo);
+                _mm_storeu_si128(s + 1, hi);
+            }
+        }
+#endif
+        for (; j < count; ++j) {
+            out[j] = static_cast<unsigned char>(div.apply(sums[j]));
+            sums[j] = static_cast<uint16_t>(sums[j] + add[j] - sub[j]);
+        }
+    }
+}
+
+// dst boleh sama dengan src. Horizontal ketiga pass per baris ke tmp, lalu vertikal
+// tmp -> dst -> tmp -> dst (setiap pass butuh baris tetangga yang belum tertimpa)
+void gaussianBlurTo(const unsigned char* src, unsigned char* dst, int width, int height, float sigma,
+                    unsigned maxThreads) {
+    int radii[3];
+    gaussBoxRadii(std::min(kMaxBlurSigma, sigma), radii);
+    const size_t stride = static_cast<size_t>(width) * 3;
+    if (radii[0] + radii[1] + radii[2] == 0) {
+        if (dst != src) std::memcpy(dst, src, stride * height);
+        return;
+    }
+    const int maxRadius = std::max(radii[0], std::max(radii[1], radii[2]));
+    std::vector<unsigned char> tmp(stride * height);
+    forEachBand(height, maxThreads, [&](int y0, int y1) {
+        std::vector<uint16_t> prefix((static_cast<size_t>(width) + 2 * maxRadius + 2) * 3);
+        for (int y = y0; y < y1; ++y) {
+            const unsigned char* in = src + y * stride;
+            unsigned char* out = tmp.data() + y * stride;
+            for (int p = 0; p < 3; ++p) {
+                if (radii[p] == 0) continue;
+                boxPassRow(in, out, width, radii[p], prefix.data());
+                in = out;
+            }
+            if (in != out) std::memcpy(out, in, stride);
+        }
+    });
+    unsigned char* from = tmp.data();
+    unsigned char* to = dst;
+    for (int p = 0; p < 3; ++p) {
+        if (radii[p] == 0) continue;
+        forEachBand(height, maxThreads, [&](int y0, int y1) {
+            std::vector<uint16_t> sums(stride);
+            boxPassColumns(from, to, stride, height, y0, y1, radii[p], sums.data());
+        });
+        std::swap(from, to);
+    }
+    if (from != dst) std::memcpy(dst, from, stride * height);
+}
+
+}
+
+const char* effectSimdPath() {
+    if (!useSimd()) return "scalar";
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+void setEffectForceScalar(bool scalar) {
+    forceScalar.store(scalar);
+}
+
+void pointOpsImage(unsigned char* rgb, int width, int height, const std::vector<PointOp>& ops, unsigned maxThreads) {
+    pointOpsRows(rgb, width, height, 0, height, ops, maxThreads);
+}
+
+void pointOpsRows(unsigned char* rows, int width, int height, int firstRow, int lastRow, const std::vector<PointOp>& ops,
+                  unsigned maxThreads) {
+    firstRow = std::max(0, firstRow);
+    lastRow = std::min(height, lastRow);
+    if (!rows || width <= 0 || firstRow >= lastRow) return;
+    int factorRows = 0;
+    const std::vector<PreparedOp> prepared = prepareOps(ops, width, height, factorRows);
+    if (prepared.empty()) return;
+    const float cx = width * 0.5f, cy = height * 0.5f;
+    const size_t padded = static_cast<size_t>(width + kChunk - 1) / kChunk * kChunk;
+
+    forEachBand(lastRow - firstRow, maxThreads, [&](int y0, int y1) {
+        // Faktor vignette dihitung sekali per baris, dipakai semua chunk di baris itu
+        std::vector<int16_t> factors(padded * factorRows, 0);
+        Planar q;
+        for (int y = firstRow + y0; y < firstRow + y1; ++y) {
+            for (const auto& p : prepared) {
+                if (p.factorRow >= 0) vignetteRow(factors.data() + p.factorRow * padded, width, cx, y - cy, p.vignetteK);
+            }
+            unsigned char* row = rows + static_cast<size_t>(y - firstRow) * width * 3;
+            for (int x = 0; x < width; x += kChunk) {
+                const int n = std::min(kChunk, width - x);
+                loadPlanar(row + x * 3, n, q);
+                for (const auto& p : prepared) {
+                    switch (p.kind) {
+                        case PointOp::Lut: lutChunk(q, n, p.lut); break;
+                        case PointOp::Vignette: scaleByFactor(q, n, factors.data() + p.factorRow * padded + x); break;
+                        default: colorMatrix(q, n, *p.matrix, p.amount); break;
+                    }
+                }
+                storePlanar(q, n, row + x * 3);
+            }
+        }
+    });
+}
+
+void grayscaleImage(unsigned char* rgb, int width, int height, int amount, unsigned maxThreads) {
+    PointOp op;
+    op.kind = PointOp::Grayscale;
+    op.amount = amount;
+    pointOpsImage(rgb, width, height, {op}, maxThreads);
+}
+
+void sepiaImage(unsigned char* rgb, int width, int height, int amount, unsigned maxThreads) {
+    PointOp op;
+    op.kind = PointOp::Sepia;
+    op.amount = amount;
+    pointOpsImage(rgb, width, height, {op}, maxThreads);
+}
+
+void invertImage(unsigned char* rgb, int width, int height, int amount, unsigned maxThreads) {
+    PointOp op;
+    op.kind = PointOp::Invert;
+    op.amount = amount;
+    pointOpsImage(rgb, width, height, {op}, maxThreads);
+}
+
+void lutImage(unsigned char* rgb, int width, int height, const ColorLut& lut, int amount, unsigned maxThreads) {
+    PointOp op;
+    op.kind = PointOp::Lut;
+    op.amount = amount;
+    op.lut = &lut;
+    pointOpsImage(rgb, width, height, {op}, maxThreads);
+}
+
+void vignetteImage(unsigned char* rgb, int width, int height, float strength, unsigned maxThreads) {
+    PointOp op;
+    op.kind = PointOp::Vignette;
+    op.strength = strength;
+    pointOpsImage(rgb, width, height, {op}, maxThreads);
+}
+
+int gaussianBlurSupport(float sigma) {
+    if (!(sigma > 0.0f)) return 0;
+    int radii[3];
+    gaussBoxRadii(std::min(kMaxBlurSigma, sigma), radii);
+    return radii[0] + radii[1] + radii[2];
+}
+
+void gaussianBlurImage(unsigned char* rgb, int width, int height, float sigma, unsigned maxThreads) {
+    if (!rgb || width <= 0 || height <= 0 || !(sigma > 0.0f)) return;
+    gaussianBlurTo(rgb, rgb, width, height, sigma, maxThreads);
+}
+
+void unsharpMaskImage(unsigned char* rgb, int width, int height, float sigma, int amount, unsigned maxThreads) {
+    if (!rgb || width <= 0 || height <= 0 || !(sigma > 0.0f)) return;
+    amount = std::min(256, std::max(0, amount));
+    if (amount == 0) return;
+    const size_t stride = static_cast<size_t>(width) * 3;
+    std::vector<unsigned char> blurred(stride * height);
+    gaussianBlurTo(rgb, blurred.data(), width, height, sigma, maxThreads);
+
+    // out = c + ((c - blur) * amount) >> 7
+    forEachBand(height, maxThreads, [&](int y0, int y1) {
+        const size_t end = static_cast<size_t>(y1) * stride;
+        size_t j = static_cast<size_t>(y0) * stride;
+#ifdef __SSE2__
+        if (useSimd()) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i a = _mm_set1_epi16(static_cast<short>(amount << 3));
+            for (; j + 16 <= end; j += 16) {
+                const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb + j));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(blurred.data() + j));
+                const __m128i cLo = _mm_unpacklo_epi8(c, zero), cHi = _mm_unpackhi_epi8(c, zero);
+                // mulhi((diff << 6) * (amount << 3)) = (diff * amount) >> 7, tetap di int16
+                const __m128i dLo = _mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(cLo, _mm_unpacklo_epi8(b, zero)), 6), a);
+                const __m128i dHi = _mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(cHi, _mm_unpackhi_epi8(b, zero)), 6), a);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(rgb + j),
+                                 _mm_packus_epi16(_mm_add_epi16(cLo, dLo), _mm_add_epi16(cHi, dHi)));
+            }
+        }
+#endif
+        for (; j < end; ++j) {
+            const int diff = rgb[j] - blurred[j];
+            rgb[j] = static_cast<unsigned char>(std::min(255, std::max(0, rgb[j] + ((diff * amount) >> 7))));
+        }
+    });
+}
+
+void pixelateImage(unsigned char* rgb, int width, int height, int blockSize, unsigned maxThreads) {
+    if (!rgb || width <= 0 || height <= 0) return;
+    blockSize = std::min(256, blockSize);
+    if (blockSize <= 1) return;
+    const size_t stride = static_cast<size_t>(width) * 3;
+    const int blockRows = (height + blockSize - 1) / blockSize;
+    const unsigned threads = maxThreads == 0 ? parallelThreads() : maxThreads;
+
+    parallelFor(static_cast<size_t>(blockRows), [&](size_t by) {
+        const int y0 = static_cast<int>(by) * blockSize;
+        const int rows = std::min(blockSize, height - y0);
+        // Jumlah per kolom byte untuk satu baris blok (maks 256 * 255, muat uint16)
+        std::vector<uint16_t> acc(stride + 16, 0);
+        std::vector<unsigned char> pattern(stride);
+        for (int y = y0; y < y0 + rows; ++y) {
+            const unsigned char* row = rgb + y * stride;
+            size_t j = 0;
+#ifdef __SSE2__
+            if (useSimd()) {
+                const __m128i zero = _mm_setzero_si128();
+                for (; j + 16 <= stride; j += 16) {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + j));
+                    __m128i* lo = reinterpret_cast<__m128i*>(&acc[j]);
+                    __m128i* hi = reinterpret_cast<__m128i*>(&acc[j + 8]);
+                    _mm_storeu_si128(lo, _mm_add_epi16(_mm_loadu_si128(lo), _mm_unpacklo_epi8(v, zero)));
+                    _mm_storeu_si128(hi, _mm_add_epi16(_mm_loadu_si128(hi), _mm_unpackhi_epi8(v, zero)));
+                }
+            }
+#endif
+            for (; j < stride; ++j) acc[j] = static_cast<uint16_t>(acc[j] + row[j]);
+        }
+        for (int x0 = 0; x0 < width; x0 += blockSize) {
+            const int cols = std::min(blockSize, width - x0);
+            const uint32_t count = static_cast<uint32_t>(cols * rows);
+            uint32_t sum[3] = {0, 0, 0};
+            for (int x = x0; x < x0 + cols; ++x) {
+                for (int c = 0; c < 3; ++c) sum[c] += acc[x * 3 + c];
+            }
+            unsigned char avg[3];
+            for (int c = 0; c < 3; ++c) avg[c] = static_cast<unsigned char>((sum[c] + count / 2) / count);
+            for (int x = x0; x < x0 + cols; ++x) std::memcpy(&pattern[x * 3], avg, 3);
+        }
+        for (int y = y0; y < y0 + rows; ++y) std::memcpy(rgb + y * stride, pattern.data(), stride);
+    }, threads);
+}
+
+void fisheyeImage(const unsigned char* src, unsigned char* dst, int width, int height, float strength,
+                  float radiusScale, unsigned maxThreads) {
+    if (!src || !dst || width <= 0 || height <= 0) return;
+    const RemapKey key = {LensKind::Fisheye, width, height, quantizeParam(std::min(1.0f, std::max(0.0f, strength))),
+                          quantizeParam(std::min(1.1f, std::max(0.1f, radiusScale)))};
+    remapImage(src, dst, *remapTableFor(key, maxThreads), maxThreads);
+}
+
+void wideAngleImage(const unsigned char* src, unsigned char* dst, int width, int height, float strength,
+                    unsigned maxThreads) {
+    if (!src || !dst || width <= 0 || height <= 0) return;
+    const RemapKey key = {LensKind::WideAngle, width, height, quantizeParam(std::min(1.0f, std::max(0.0f, strength))), 0};
+    remapImage(src, dst, *remapTableFor(key, maxThreads), maxThreads);
+}
+
+size_t remapCacheBytes() {
+    std::lock_guard<std::mutex> lock(remapMu);
+    size_t total = 0;
+    for (const auto& entry : remapCache) total += entry.second->bytes();
+    return total;
+}
+
+void clearRemapCache() {
+    std::lock_guard<std::mutex> lock(remapMu);
+    remapCache.clear();
+}
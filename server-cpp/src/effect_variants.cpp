@@ -0,0 +1,195 @@
+#include "../include/effect_variants.h"
+#include "../include/server.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+std::string baseName(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+bool writeFileAtomic(const std::string& path, const std::vector<unsigned char>& bytes) {
+    const std::string tmp = path + ".part";
+    std::ofstream ofs(tmp, std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+    ofs.close();
+    if (!ofs || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+}
+
+EffectVariantStore::EffectVariantStore(const std::string& dir) : dir(dir) {
+    mkdir(dir.c_str(), 0755);
+    worker = std::thread(&EffectVariantStore::workerLoop, this);
+}
+
+EffectVariantStore::~EffectVariantStore() {
+    shutdown();
+}
+
+void EffectVariantStore::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        stopping = true;
+    }
+    cv.notify_all();
+    if (worker.joinable()) worker.join();
+    // Task yang belum sempat jalan tetap menjawab waiter-nya (gagal) supaya respons HTTP
+    // yang ditahan tidak menggantung, sama seperti RenderJobManager::shutdown
+    std::map<std::string, std::vector<Ready>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        pending.swap(inflight);
+        queue.clear();
+    }
+    for (const auto& entry : pending) {
+        for (const auto& ready : entry.second) {
+            if (ready) ready("");
+        }
+    }
+}
+
+bool EffectVariantStore::isStopping() {
+    std::lock_guard<std::mutex> lock(mu);
+    return stopping;
+}
+
+std::string EffectVariantStore::variantPath(const std::string& sourcePath, const EffectPipeline& pipeline) const {
+    struct stat st;
+    if (stat(sourcePath.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return "";
+    unsigned long long h = 1469598103934665603ULL;
+    const unsigned long long parts[4] = {
+        (unsigned long long)st.st_ino, (unsigned long long)st.st_size,
+        (unsigned long long)st.st_mtim.tv_sec, (unsigned long long)st.st_mtim.tv_nsec
+    };
+    for (unsigned long long v : parts) {
+        for (int i = 0; i < 8; ++i, v >>= 8) {
+            h ^= v & 0xff;
+            h *= 1099511628211ULL;
+        }
+    }
+    for (unsigned char c : pipeline.signature()) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%016llx.jpg", h);
+    return dir + "/" + baseName(sourcePath) + suffix;
+}
+
+void EffectVariantStore::render(const std::string& sourcePath, std::shared_ptr<const EffectPipeline> pipeline,
+                                const Ready& ready) {
+    const std::string path = pipeline && !pipeline->empty() ? variantPath(sourcePath, *pipeline) : "";
+    if (path.empty()) {
+        if (ready) ready("");
+        return;
+    }
+    if (access(path.c_str(), F_OK) == 0) {
+        if (ready) ready(path);
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mu);
+        if (stopping) {
+            // Store sedang ditutup: tidak akan ada worker yang menjawab
+            lock.unlock();
+            if (ready) ready("");
+            return;
+        }
+        auto it = inflight.find(path);
+        if (it != inflight.end()) {
+            if (ready) it->second.push_back(ready);
+            return;
+        }
+        inflight[path].push_back(ready);
+        Task task;
+        task.sourcePath = sourcePath;
+        task.path = path;
+        task.pipeline = pipeline;
+        queue.push_back(std::move(task));
+    }
+    cv.notify_one();
+}
+
+void EffectVariantStore::removeFor(const std::string& sourcePath) {
+    const std::string prefix = baseName(sourcePath) + ".";
+    DIR* d = opendir(dir.c_str());
+    if (!d) return;
+    int removed = 0;
+    while (struct dirent* e = readdir(d)) {
+        const std::string name = e->d_name;
+        if (name.compare(0, prefix.size(), prefix) == 0 && unlink((dir + "/" + name).c_str()) == 0) ++removed;
+    }
+    closedir(d);
+    if (removed > 0) std::cout << "🧹 Removed " << removed << " effect variants of " << baseName(sourcePath) << std::endl;
+}
+
+void EffectVariantStore::workerLoop() {
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            cv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        runTask(task);
+    }
+}
+
+void EffectVariantStore::runTask(const Task& task) {
+    const auto start = std::chrono::steady_clock::now();
+    bool stored = false;
+    try {
+        // Foto yang dihapus selagi antri tidak dirender
+        std::ifstream file(task.sourcePath, std::ios::binary);
+        std::vector<unsigned char> original((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (!original.empty()) {
+            // Pipeline yang diterima dipakai langsung (tanpa kompilasi ulang). applyEffect menegakkan
+            // orientasi EXIF, memakai jalur koefisien DCT bila cukup dan EffectPipeline::runTiled untuk
+            // sisanya; input dikembalikan apa adanya bila gagal
+            const std::vector<unsigned char> processed = ImageEffects::applyEffect(original, task.pipeline, false);
+            stored = !processed.empty() && processed != original && writeFileAtomic(task.path, processed);
+            // deletePhoto menghapus sumber sebelum removeFor: bila sumber sudah hilang di sini,
+            // removeFor mungkin sudah lewat dan varian ini akan yatim
+            if (stored && access(task.sourcePath.c_str(), F_OK) != 0) {
+                unlink(task.path.c_str());
+                stored = false;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error rendering effect variant: " << e.what() << std::endl;
+    }
+
+    std::vector<Ready> waiters;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        auto it = inflight.find(task.path);
+        if (it != inflight.end()) {
+            waiters.swap(it->second);
+            inflight.erase(it);
+        }
+    }
+    if (stored) {
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "🎨 Effect variant ready: " << task.path << " (" << task.pipeline->describe() << ", "
+                  << static_cast<int>(ms) << " ms)" << std::endl;
+    } else {
+        std::cerr << "❌ Failed to render effect variant: " << task.path << std::endl;
+    }
+    for (const auto& ready : waiters) {
+        if (ready) ready(stored ? task.path : "");
+    }
+}
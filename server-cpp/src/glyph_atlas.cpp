@@ -0,0 +1,236 @@
+#include "../include/glyph_atlas.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const int kPageSize = 1024;
+const int kGlyphPadding = 1;
+const size_t kMaxAtlases = 32;
+
+// Decode satu codepoint UTF-8; byte tidak valid dianggap U+FFFD
+uint32_t nextCodepoint(const std::string& s, size_t& i) {
+    unsigned char c = static_cast<unsigned char>(s[i++]);
+    if (c < 0x80) return c;
+    int extra = (c >= 0xF0) ? 3 : (c >= 0xE0) ? 2 : (c >= 0xC0) ? 1 : -1;
+    if (extra < 0) return 0xFFFD;
+    uint32_t cp = c & (0x3F >> extra);
+    for (int k = 0; k < extra; ++k) {
+        if (i >= s.size() || (static_cast<unsigned char>(s[i]) & 0xC0) != 0x80) return 0xFFFD;
+        cp = (cp << 6) | (static_cast<unsigned char>(s[i++]) & 0x3F);
+    }
+    return cp;
+}
+
+// (x + 128 + ((x + 128) >> 8)) >> 8 == round(x / 255) untuk x <= 255*255
+inline unsigned char div255(unsigned int x) {
+    x += 128;
+    return static_cast<unsigned char>((x + (x >> 8)) >> 8);
+}
+
+}
+
+void blendCoverageRow(unsigned char* dst, const unsigned char* coverage, int count,
+                      unsigned char r, unsigned char g, unsigned char b) {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i full = _mm_set1_epi16(255);
+    const __m128i bias = _mm_set1_epi16(128);
+    const __m128i color = _mm_setr_epi16(r, g, b, 255, r, g, b, 255);
+    for (; i + 4 <= count; i += 4) {
+        uint32_t c4;
+        std::memcpy(&c4, coverage + i, 4);
+        if (c4 == 0) continue;
+        // c0 c1 c2 c3 -> c0 x4, c1 x4, c2 x4, c3 x4
+        __m128i cv = _mm_cvtsi32_si128(static_cast<int>(c4));
+        cv = _mm_unpacklo_epi8(cv, cv);
+        cv = _mm_unpacklo_epi16(cv, cv);
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i * 4));
+
+        __m128i aLo = _mm_unpacklo_epi8(cv, zero);
+        __m128i aHi = _mm_unpackhi_epi8(cv, zero);
+        __m128i dLo = _mm_unpacklo_epi8(d, zero);
+        __m128i dHi = _mm_unpackhi_epi8(d, zero);
+        // dst*(255-a) + color*a, maksimum 65025 sehingga muat di u16
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(dLo, _mm_sub_epi16(full, aLo)), _mm_mullo_epi16(color, aLo));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(dHi, _mm_sub_epi16(full, aHi)), _mm_mullo_epi16(color, aHi));
+        lo = _mm_add_epi16(lo, bias);
+        hi = _mm_add_epi16(hi, bias);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i * 4), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < count; ++i) {
+        unsigned int a = coverage[i];
+        if (a == 0) continue;
+        unsigned char* p = dst + i * 4;
+        unsigned int ia = 255 - a;
+        p[0] = div255(p[0] * ia + r * a);
+        p[1] = div255(p[1] * ia + g * a);
+        p[2] = div255(p[2] * ia + b * a);
+        p[3] = div255(p[3] * ia + 255 * a);
+    }
+}
+
+// ============ GlyphAtlas ============
+GlyphAtlas::~GlyphAtlas() {
+    if (face) FT_Done_Face(static_cast<FT_Face>(face));
+}
+
+unsigned char* GlyphAtlas::allocateLocked(int w, int h, int& stride) {
+    const int pw = w + kGlyphPadding, ph = h + kGlyphPadding;
+    Page* page = pages.empty() ? nullptr : pages.back().get();
+    if (page) {
+        if (page->cursorX + pw > page->width) {
+            // Shelf penuh: buka shelf baru di bawahnya
+            page->shelfY += page->shelfHeight;
+            page->cursorX = 0;
+            page->shelfHeight = 0;
+        }
+        if (page->cursorX + pw > page->width || page->shelfY + ph > page->height) {
+            page = nullptr;
+        }
+    }
+    if (!page) {
+        std::unique_ptr<Page> fresh(new Page());
+        fresh->width = std::max(kPageSize, pw);
+        fresh->height = std::max(kPageSize, ph);
+        fresh->pixels.assign(static_cast<size_t>(fresh->width) * fresh->height, 0);
+        pages.push_back(std::move(fresh));
+        page = pages.back().get();
+    }
+    unsigned char* slot = page->pixels.data() + static_cast<size_t>(page->shelfY) * page->width + page->cursorX;
+    page->cursorX += pw;
+    page->shelfHeight = std::max(page->shelfHeight, ph);
+    stride = page->width;
+    return slot;
+}
+
+const GlyphBitmap* GlyphAtlas::glyphLocked(uint32_t codepoint) {
+    auto it = glyphs.find(codepoint);
+    if (it != glyphs.end()) return &it->second;
+
+    FT_Face ftFace = static_cast<FT_Face>(face);
+    GlyphBitmap glyph;
+    glyph.index = FT_Get_Char_Index(ftFace, codepoint);
+    if (FT_Load_Glyph(ftFace, glyph.index, FT_LOAD_RENDER) != 0) {
+        if (glyph.index == 0 || FT_Load_Glyph(ftFace, 0, FT_LOAD_RENDER) != 0) return nullptr;
+        glyph.index = 0;
+    }
+    FT_GlyphSlot slot = ftFace->glyph;
+    const FT_Bitmap& bm = slot->bitmap;
+    glyph.width = static_cast<int>(bm.width);
+    glyph.height = static_cast<int>(bm.rows);
+    glyph.left = slot->bitmap_left;
+    glyph.top = slot->bitmap_top;
+    glyph.advance = slot->advance.x;
+    if (glyph.width > 0 && glyph.height > 0 && bm.pixel_mode == FT_PIXEL_MODE_GRAY) {
+        int stride = 0;
+        unsigned char* dst = allocateLocked(glyph.width, glyph.height, stride);
+        for (int y = 0; y < glyph.height; ++y) {
+            const unsigned char* src = bm.buffer + (bm.pitch >= 0 ? y : y - glyph.height + 1) * bm.pitch;
+            std::memcpy(dst + static_cast<size_t>(y) * stride, src, glyph.width);
+        }
+        glyph.pixels = dst;
+        glyph.stride = stride;
+    } else {
+        glyph.width = glyph.height = 0;
+    }
+    return &glyphs.emplace(codepoint, glyph).first->second;
+}
+
+bool GlyphAtlas::layout(const std::string& utf8, float x, float baselineY, TextRun& run) {
+    std::lock_guard<std::mutex> lock(mu);
+    FT_Face ftFace = static_cast<FT_Face>(face);
+    long pen = std::lround(x * 64.0f);
+    const int baseline = static_cast<int>(std::lround(baselineY));
+    unsigned int prevIndex = 0;
+    run.glyphs.clear();
+    run.top = baseline;
+    run.bottom = baseline;
+    for (size_t i = 0; i < utf8.size();) {
+        const GlyphBitmap* glyph = glyphLocked(nextCodepoint(utf8, i));
+        if (!glyph) continue;
+        if (hasKerning && prevIndex && glyph->index) {
+            FT_Vector delta;
+            if (FT_Get_Kerning(ftFace, prevIndex, glyph->index, FT_KERNING_DEFAULT, &delta) == 0) {
+                pen += delta.x;
+            }
+        }
+        if (glyph->width > 0) {
+            PositionedGlyph pg;
+            pg.x = static_cast<int>((pen + 32) >> 6) + glyph->left;
+            pg.y = baseline - glyph->top;
+            pg.glyph = glyph;
+            run.top = std::min(run.top, pg.y);
+            run.bottom = std::max(run.bottom, pg.y + glyph->height);
+            run.glyphs.push_back(pg);
+        }
+        pen += glyph->advance;
+        prevIndex = glyph->index;
+    }
+    return !run.glyphs.empty();
+}
+
+// ============ GlyphAtlasCache ============
+GlyphAtlasCache& GlyphAtlasCache::instance() {
+    static GlyphAtlasCache cache;
+    return cache;
+}
+
+GlyphAtlasCache::GlyphAtlasCache() {
+    FT_Library lib = nullptr;
+    if (FT_Init_FreeType(&lib) != 0) {
+        std::cerr << "❌ FreeType init failed, template text disabled" << std::endl;
+        return;
+    }
+    library = std::shared_ptr<void>(lib, [](void* p) { FT_Done_FreeType(static_cast<FT_Library>(p)); });
+}
+
+std::shared_ptr<GlyphAtlas> GlyphAtlasCache::acquire(const std::string& fontPath, int pixelSize, time_t fontMtime) {
+    if (pixelSize <= 0) return nullptr;
+    std::string key = fontPath + "@" + std::to_string(pixelSize);
+    if (fontMtime != 0) key += "#" + std::to_string((long long)fontMtime);
+    std::lock_guard<std::mutex> lock(mu);
+    auto it = atlases.find(key);
+    if (it != atlases.end()) return it->second;
+    if (!library) return nullptr;
+
+    FT_Face face = nullptr;
+    if (FT_New_Face(static_cast<FT_Library>(library.get()), fontPath.c_str(), 0, &face) != 0) {
+        std::cerr << "⚠️ Font not found or unreadable: " << fontPath << std::endl;
+        return nullptr;
+    }
+    if (FT_Set_Pixel_Sizes(face, 0, static_cast<FT_UInt>(pixelSize)) != 0) {
+        FT_Done_Face(face);
+        return nullptr;
+    }
+    std::shared_ptr<GlyphAtlas> atlas(new GlyphAtlas());
+    atlas->library = library;
+    atlas->face = face;
+    atlas->hasKerning = FT_HAS_KERNING(face);
+
+    if (atlases.size() >= kMaxAtlases) {
+        // Buang atlas yang tidak sedang dipakai render mana pun
+        for (auto a = atlases.begin(); a != atlases.end();) {
+            if (a->second.use_count() == 1) a = atlases.erase(a); else ++a;
+        }
+    }
+    atlases[key] = atlas;
+    std::cout << "🔤 Glyph atlas created: " << key << std::endl;
+    return atlas;
+}
+
+size_t GlyphAtlasCache::size() {
+    std::lock_guard<std::mutex> lock(mu);
+    return atlases.size();
+}
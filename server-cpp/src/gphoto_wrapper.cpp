@@ -122,10 +122,7 @@ std::map<std::string, std::string> GPhotoWrapper::captureImage() {
         result["error"] = "Photo file not created";
         return result;
     }
-    std::vector<unsigned char> processedData = effects.applyEffect(imageData);
-    if (!processedData.empty()) {
-        writeImageFile(path, processedData);
-    }
+    // Foto asli tidak ditimpa: efek dirender sebagai varian terpisah (PhotoBoothServer)
     result["success"] = "true";
     result["filename"] = filename;
     result["filepath"] = path;
@@ -145,6 +142,14 @@ std::pair<EffectType, EffectParams> GPhotoWrapper::getCurrentEffect() const {
     return effects.getEffect();
 }
 
+void GPhotoWrapper::setEffects(const std::vector<EffectStep>& steps) {
+    effects.setEffects(steps);
+}
+
+std::shared_ptr<const EffectPipeline> GPhotoWrapper::getPipeline() const {
+    return effects.getPipeline();
+}
+
 std::string GPhotoWrapper::executeCommand(const std::string& command) {
     std::string result;
     FILE* pipe = popen(command.c_str(), "r");
@@ -1,5 +1,4 @@
-// image_effects.cpp - SIMPLIFIED VERSION - Efek dipindahkan ke frontend
-// NOTE: File ini hanya untuk backward compatibility, tidak ada processing efek
+// image_effects.cpp - Efek foto di server: decode JPEG, kernel efek (effect_kernels.cpp), encode
 
 // Kompabilitas Windows
 #ifdef _WIN32
@@ -18,10 +17,17 @@
 #include "../include/stb_image_write.h"
 
 #include "../include/server.h"
+#include "../include/jpeg_codec.h"
+#include "../include/effect_kernels.h"
+#include "../include/color_lut.h"
+#include "../include/jpeg_transform.h"
+#include "../include/parallel.h"
+#include <cmath>
 #include <cstring>
+#include <fstream>
 #include <algorithm> // untuk std::max & std::min
 
-ImageEffects::ImageEffects() : currentEffect(EffectType::NONE) {
+ImageEffects::ImageEffects() : currentEffect(EffectType::NONE), mirrored(false) {
     try {
         std::lock_guard<std::mutex> lock(mutex);
         params.intensity = 0.5;
@@ -37,17 +43,60 @@ ImageEffects::ImageEffects() : currentEffect(EffectType::NONE) {
 }
 
 void ImageEffects::setEffect(EffectType effect, const EffectParams& params) {
-    try {
-        std::lock_guard<std::mutex> lock(mutex);
-        this->currentEffect = effect;
-        this->params = params;
-        std::cout << "📝 NOTE: Effect set to " << static_cast<int>(effect) << " but processing moved to frontend" << std::endl;
-    } catch (const std::exception& e) {
-        std::cerr << "❌ Exception in setEffect: " << e.what() << std::endl;
-        // Fallback tanpa lock (beresiko race condition tapi lebih aman daripada crash)
-        this->currentEffect = effect;
-        this->params = params;
+    std::vector<EffectStep> steps;
+    if (effect != EffectType::NONE) steps.push_back(EffectStep{effect, params});
+    setEffects(steps);
+    std::lock_guard<std::mutex> lock(mutex);
+    this->currentEffect = effect;
+    this->params = params;
+}
+
+namespace {
+
+bool sameSteps(const std::vector<EffectStep>& a, const std::vector<EffectStep>& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        const EffectParams& p = a[i].params;
+        const EffectParams& q = b[i].params;
+        if (a[i].type != b[i].type || p.intensity != q.intensity || p.radius != q.radius ||
+            p.pixelSize != q.pixelSize || p.lut != q.lut || p.lutTable != q.lutTable) {
+            return false;
+        }
     }
+    return true;
+}
+
+}
+
+void ImageEffects::setEffects(const std::vector<EffectStep>& steps) {
+    auto compiled = std::make_shared<const EffectPipeline>(steps);
+    std::lock_guard<std::mutex> lock(mutex);
+    // Pengaturan yang sama dikirim ulang (slider, reconnect): pipeline lama tetap dipakai
+    if (pipeline && sameSteps(pipeline->steps(), compiled->steps())) return;
+    pipeline = compiled->empty() ? nullptr : compiled;
+    currentEffect = compiled->empty() ? EffectType::NONE : compiled->steps().front().type;
+    if (!compiled->empty()) params = compiled->steps().front().params;
+    std::cout << "🎨 Effect pipeline: " << compiled->describe() << " (" << compiled->passCount() << " pass)" << std::endl;
+}
+
+std::vector<EffectStep> ImageEffects::getEffects() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pipeline ? pipeline->steps() : std::vector<EffectStep>();
+}
+
+std::shared_ptr<const EffectPipeline> ImageEffects::getPipeline() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return pipeline;
+}
+
+void ImageEffects::setMirror(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex);
+    mirrored = enabled;
+}
+
+bool ImageEffects::isMirrored() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return mirrored;
 }
 
 std::pair<EffectType, EffectParams> ImageEffects::getEffect() const {
@@ -62,14 +111,15 @@ std::pair<EffectType, EffectParams> ImageEffects::getEffect() const {
 }
 
 std::vector<unsigned char> ImageEffects::applyEffect(const std::vector<unsigned char>& jpegData) {
-    // NOTE: EFEX TELAH DIPINDAHKAN KE FRONTEND
-    // Function ini sekarang hanya return original data tanpa processing
+    return applyEffect(jpegData, getPipeline(), isMirrored());
+}
+
+std::vector<unsigned char> ImageEffects::applyEffect(const std::vector<unsigned char>& jpegData,
+                                                     const std::shared_ptr<const EffectPipeline>& compiled, bool mirror) {
     try {
-        if (currentEffect != EffectType::NONE) {
-            std::cout << "📝 NOTE: Effect " << static_cast<int>(currentEffect) << " requested but processing moved to frontend" << std::endl;
+        if ((!compiled || compiled->empty()) && !mirror) {
+            return jpegData;
         }
-        
-        // Safety check untuk ukuran data
         if (jpegData.empty()) {
             return jpegData;
         }
@@ -79,8 +129,44 @@ std::vector<unsigned char> ImageEffects::applyEffect(const std::vector<unsigned
             return jpegData;
         }
         
-        // Return original data tanpa processing
-        return jpegData;
+        // Hasil encode ulang tidak membawa APP1, jadi orientasi EXIF ditegakkan di sini. Mirror
+        // selfie berlaku setelah rotasi: M * R(r) = R(-r) * M
+        JpegCoefTransform geometry = JpegCoefTransform::fromExifOrientation(jpegExifOrientation(jpegData.data(), jpegData.size()));
+        if (mirror) {
+            geometry.rotate = (360 - geometry.rotate) % 360;
+            geometry.mirror = !geometry.mirror;
+        }
+        
+        // Rantai yang cukup di domain DCT: tanpa IDCT, efek per piksel dan kuantisasi ulang
+        int width = 0, height = 0;
+        JpegCoefTransform coefficients = geometry;
+        if (jpegReadDimensions(jpegData.data(), jpegData.size(), width, height) &&
+            (!compiled || compiled->coefficientTransform(width, height, coefficients))) {
+            std::vector<unsigned char> transformed;
+            if (jpegTransformCoefficients(jpegData.data(), jpegData.size(), coefficients, transformed)) {
+                return transformed;
+            }
+        }
+        
+        // Geometri tetap lossless di koefisien, baru kemudian decode untuk rantai efek
+        const std::vector<unsigned char>* source = &jpegData;
+        std::vector<unsigned char> oriented;
+        if (!geometry.identity() && jpegTransformCoefficients(jpegData.data(), jpegData.size(), geometry, oriented)) {
+            source = &oriented;
+        }
+        
+        // libjpeg-turbo (paralel bila ada restart marker), stb sebagai cadangan
+        ImageData image;
+        if (!jpegDecodeScaled(source->data(), source->size(), 1, 3, image.data, image.width, image.height)) {
+            image = decodeJPEG(*source);
+        }
+        if (image.data.empty()) {
+            return *source;
+        }
+        
+        if (compiled) compiled->runTiled(image);
+        std::vector<unsigned char> encoded = encodeJPEG(image);
+        return encoded.empty() ? *source : encoded;
     } catch (const std::exception& e) {
         std::cerr << "❌ Exception in applyEffect: " << e.what() << std::endl;
         // Return original data on error
@@ -92,6 +178,27 @@ std::vector<unsigned char> ImageEffects::applyEffect(const std::vector<unsigned
     }
 }
 
+void ImageEffects::applyEffectTo(ImageData& image, EffectType effect, const EffectParams& params, double sizeScale) {
+    if (image.width <= 0 || image.height <= 0 ||
+        image.data.size() != static_cast<size_t>(image.width) * image.height * 3) {
+        return;
+    }
+    const double scale = sizeScale > 0.0 ? sizeScale : previewScale(image.width, image.height);
+    switch (effect) {
+        case EffectType::FISHEYE: applyFishEyeEffect(image, params); break;
+        case EffectType::WIDE_ANGLE: applyWideAngleEffect(image, params); break;
+        case EffectType::GRAYSCALE:
+        case EffectType::SEPIA:
+        case EffectType::VIGNETTE:
+        case EffectType::INVERT:
+        case EffectType::LUT: applyPointEffect(image, effect, params); break;
+        case EffectType::BLUR: applyBlurEffect(image, params, scale); break;
+        case EffectType::SHARPEN: applySharpenEffect(image, params, scale); break;
+        case EffectType::PIXELATE: applyPixelateEffect(image, params, scale); break;
+        case EffectType::NONE: break;
+    }
+}
+
 // ============ STB IMAGE DECODER (Lightweight) ============
 ImageData ImageEffects::decodeJPEG(const std::vector<unsigned char>& jpegData) {
     ImageData result;
@@ -155,7 +262,7 @@ ImageData ImageEffects::decodeJPEG(const std::vector<unsigned char>& jpegData) {
     }
 }
 
-// ============ STB IMAGE ENCODER (Lightweight) ============
+// ============ JPEG ENCODER (libjpeg-turbo, paralel per segmen restart) ============
 std::vector<unsigned char> ImageEffects::encodeJPEG(const ImageData& rgbData) {
     std::vector<unsigned char> jpegData;
     
@@ -179,36 +286,10 @@ std::vector<unsigned char> ImageEffects::encodeJPEG(const ImageData& rgbData) {
             return jpegData;
         }
         
-        // Reserve dengan ukuran yang masuk akal
-        jpegData.reserve(rgbData.width * rgbData.height);
-        
-        // Write callback dengan safety checks
-        auto writeFunc = [](void* context, void* data, int size) {
-            if (!context || !data || size <= 0) return;
-            
-            auto* vec = static_cast<std::vector<unsigned char>*>(context);
-            auto* bytes = static_cast<unsigned char*>(data);
-            
-            try {
-                vec->insert(vec->end(), bytes, bytes + size);
-            } catch (const std::exception& e) {
-                std::cerr << "❌ Error in write callback: " << e.what() << std::endl;
-            }
-        };
-        
-        // Encode dengan quality 80 (balance antara quality dan size)
-        int success = stbi_write_jpg_to_func(
-            writeFunc,
-            &jpegData,
-            rgbData.width,
-            rgbData.height,
-            3,
-            rgbData.data.data(),
-            80  // Quality 80 untuk hemat CPU & bandwidth
-        );
-        
-        if (!success) {
-            std::cerr << "❌ STB encode failed" << std::endl;
+        // Quality 80 untuk hemat CPU & bandwidth; gambar besar di-encode paralel per segmen restart
+        if (!jpegEncodeParallel(rgbData.data.data(), rgbData.width, rgbData.height, 3,
+                                static_cast<size_t>(rgbData.width) * 3, 80, jpegData)) {
+            std::cerr << "❌ JPEG encode failed" << std::endl;
             return std::vector<unsigned char>();
         }
         
@@ -222,50 +303,420 @@ std::vector<unsigned char> ImageEffects::encodeJPEG(const ImageData& rgbData) {
     }
 }
 
-// ============ NOTE: SEMUA EFFECT IMPLEMENTATIONS TELAH DIPINDAHKAN KE FRONTEND ============
-// Untuk performa yang lebih baik pada spek terbatas, semua processing efek sekarang dilakukan di frontend
-// menggunakan Canvas API dan Web Workers
+// ============ EFFECT IMPLEMENTATIONS (kernel SIMD di effect_kernels.cpp) ============
+namespace {
+
+int pixelBlockSize(double scale, const EffectParams& params) {
+    return std::max(1, static_cast<int>(std::lround(std::max(2, params.pixelSize) * scale)));
+}
+
+int amountOf(const EffectParams& params) {
+    return static_cast<int>(std::lround(std::min(1.0, std::max(0.0, params.intensity)) * 128.0));
+}
 
-// Placeholder methods untuk backward compatibility (tidak melakukan apa-apa)
-void ImageEffects::applyGrayscaleEffect(ImageData& image) {
-    std::cout << "📝 NOTE: Grayscale effect moved to frontend" << std::endl;
+// Operasi titik untuk satu langkah; LUT tidak bergantung ukuran gambar, jadi preview dan capture
+// memakai tabel yang sama
+PointOp pointOpFor(EffectType effect, const EffectParams& params) {
+    PointOp op;
+    op.amount = amountOf(params);
+    switch (effect) {
+        case EffectType::SEPIA: op.kind = PointOp::Sepia; break;
+        case EffectType::INVERT: op.kind = PointOp::Invert; break;
+        case EffectType::VIGNETTE:
+            op.kind = PointOp::Vignette;
+            op.strength = static_cast<float>(params.intensity * 2.0);
+            break;
+        case EffectType::LUT:
+            op.kind = PointOp::Lut;
+            op.lut = params.lutTable.get();
+            break;
+        default: op.kind = PointOp::Grayscale; break;
+    }
+    return op;
 }
 
-void ImageEffects::applySepiaEffect(ImageData& image) {
-    std::cout << "📝 NOTE: Sepia effect moved to frontend" << std::endl;
+// Sigma 0.8..8 px pada ukuran preview, diskalakan ke resolusi gambar (biaya tidak naik)
+float blurSigmaFor(const EffectParams& params, double scale) {
+    const double previewSigma = std::max(0.8, std::min(1.0, std::max(0.0, params.intensity)) * 8.0);
+    return static_cast<float>(previewSigma * scale);
 }
 
-void ImageEffects::applyInvertEffect(ImageData& image) {
-    std::cout << "📝 NOTE: Invert effect moved to frontend" << std::endl;
+// Unsharp mask radius ~1.5 px preview
+float sharpenSigmaFor(double scale) {
+    return static_cast<float>(1.5 * scale);
 }
 
-void ImageEffects::applyVignetteEffect(ImageData& image) {
-    std::cout << "📝 NOTE: Vignette effect moved to frontend" << std::endl;
+// Target byte per tile runTiled (termasuk halo): muat di L2 bersama buffer sementara kernel
+const size_t kTileBytes = 512 * 1024;
+
 }
 
-void ImageEffects::applyBlurEffect(ImageData& image) {
-    std::cout << "📝 NOTE: Blur effect moved to frontend" << std::endl;
+// Preview frontend diproses maksimal 1920 px; ukuran dalam piksel (radius blur, blok pixelate)
+// diskalakan supaya tampilan capture penuh sama dengan preview
+double ImageEffects::previewScale(int width, int height) {
+    return std::max(1.0, std::max(width, height) / 1920.0);
 }
 
-void ImageEffects::applySharpenEffect(ImageData& image) {
-    std::cout << "📝 NOTE: Sharpen effect moved to frontend" << std::endl;
+void ImageEffects::applyBlurEffect(ImageData& image, const EffectParams& params, double scale) {
+    gaussianBlurImage(image.data.data(), image.width, image.height, blurSigmaFor(params, scale));
 }
 
-void ImageEffects::applyPixelateEffect(ImageData& image) {
-    std::cout << "📝 NOTE: Pixelate effect moved to frontend" << std::endl;
+void ImageEffects::applySharpenEffect(ImageData& image, const EffectParams& params, double scale) {
+    // Kekuatan 0..2x detail
+    unsharpMaskImage(image.data.data(), image.width, image.height, sharpenSigmaFor(scale), amountOf(params) * 2);
 }
 
-void ImageEffects::applyFishEyeEffect(ImageData& image) {
-    std::cout << "📝 NOTE: Fish Eye effect moved to frontend" << std::endl;
+void ImageEffects::applyPixelateEffect(ImageData& image, const EffectParams& params, double scale) {
+    pixelateImage(image.data.data(), image.width, image.height, pixelBlockSize(scale, params));
 }
 
-void ImageEffects::applyWideAngleEffect(ImageData& image) {
-    std::cout << "📝 NOTE: Wide Angle effect moved to frontend" << std::endl;
+void ImageEffects::applyFishEyeEffect(ImageData& image, const EffectParams& params) {
+    std::vector<unsigned char> out(image.data.size());
+    fisheyeImage(image.data.data(), out.data(), image.width, image.height,
+                 static_cast<float>(params.intensity * 0.5), static_cast<float>(params.radius));
+    image.data.swap(out);
+}
+
+void ImageEffects::applyWideAngleEffect(ImageData& image, const EffectParams& params) {
+    std::vector<unsigned char> out(image.data.size());
+    wideAngleImage(image.data.data(), out.data(), image.width, image.height, static_cast<float>(params.intensity * 0.6));
+    image.data.swap(out);
+}
+
+void ImageEffects::applyPointEffect(ImageData& image, EffectType effect, const EffectParams& params) {
+    pointOpsImage(image.data.data(), image.width, image.height, {pointOpFor(effect, params)});
+}
+
+// ============ EFFECT PIPELINE ============
+EffectPipeline::EffectPipeline(const std::vector<EffectStep>& steps) {
+    for (const auto& step : steps) {
+        if (step.type == EffectType::NONE || (step.type == EffectType::LUT && !step.params.lutTable)) continue;
+        if (effectSteps.size() == kMaxSteps) break;
+        effectSteps.push_back(step);
+    }
+    for (size_t i = 0; i < effectSteps.size(); ++i) {
+        const bool point = isPointOp(effectSteps[i].type);
+        if (point && !stages.empty() && stages.back().fused) {
+            stages.back().steps.push_back(i);
+        } else {
+            stages.push_back(Stage{point, {i}});
+        }
+    }
+}
+
+std::string EffectPipeline::describe() const {
+    if (stages.empty()) return "none";
+    std::string out;
+    for (const auto& stage : stages) {
+        if (!out.empty()) out += " -> ";
+        if (stage.fused && stage.steps.size() > 1) out += "[";
+        for (size_t i = 0; i < stage.steps.size(); ++i) {
+            const EffectStep& step = effectSteps[stage.steps[i]];
+            if (i > 0) out += "+";
+            out += effectName(step.type);
+            if (step.type == EffectType::LUT) out += ":" + step.params.lut;
+        }
+        if (stage.fused && stage.steps.size() > 1) out += "]";
+    }
+    return out;
+}
+
+std::string EffectPipeline::signature() const {
+    std::string out;
+    for (const auto& step : effectSteps) {
+        char buf[96];
+        snprintf(buf, sizeof(buf), ":%g:%g:%d", step.params.intensity, step.params.radius, step.params.pixelSize);
+        if (!out.empty()) out += ",";
+        out += effectName(step.type);
+        if (step.type == EffectType::LUT) out += "=" + step.params.lut;
+        out += buf;
+    }
+    return out;
+}
+
+void EffectPipeline::run(ImageData& image, double sizeScale) const {
+    if (image.width <= 0 || image.height <= 0 ||
+        image.data.size() != static_cast<size_t>(image.width) * image.height * 3) {
+        return;
+    }
+    for (const auto& stage : stages) {
+        if (stage.fused) {
+            std::vector<PointOp> ops;
+            for (size_t i : stage.steps) ops.push_back(pointOpFor(effectSteps[i].type, effectSteps[i].params));
+            pointOpsImage(image.data.data(), image.width, image.height, ops);
+        } else {
+            const EffectStep& step = effectSteps[stage.steps.front()];
+            ImageEffects::applyEffectTo(image, step.type, step.params, sizeScale);
+        }
+    }
+}
+
+void EffectPipeline::runTiled(ImageData& image, double sizeScale, unsigned maxThreads) const {
+    if (image.width <= 0 || image.height <= 0 ||
+        image.data.size() != static_cast<size_t>(image.width) * image.height * 3) {
+        return;
+    }
+    const double scale = sizeScale > 0.0 ? sizeScale : ImageEffects::previewScale(image.width, image.height);
+    size_t first = 0;
+    for (size_t i = 0; i <= stages.size(); ++i) {
+        if (i < stages.size() && !isGeometry(stages[i])) continue;
+        if (first < i) runTileSegment(image, first, i, scale, maxThreads);
+        if (i < stages.size()) {
+            const EffectStep& step = effectSteps[stages[i].steps.front()];
+            ImageEffects::applyEffectTo(image, step.type, step.params, scale);
+        }
+        first = i + 1;
+    }
+}
+
+bool EffectPipeline::isGeometry(const Stage& stage) const {
+    const EffectType type = effectSteps[stage.steps.front()].type;
+    return type == EffectType::FISHEYE || type == EffectType::WIDE_ANGLE;
+}
+
+void EffectPipeline::inputRows(const Stage& stage, double scale, int height, int& y0, int& y1) const {
+    if (stage.fused) return;
+    const EffectStep& step = effectSteps[stage.steps.front()];
+    int halo = 0;
+    switch (step.type) {
+        case EffectType::BLUR: halo = gaussianBlurSupport(blurSigmaFor(step.params, scale)); break;
+        case EffectType::SHARPEN: halo = gaussianBlurSupport(sharpenSigmaFor(scale)); break;
+        case EffectType::PIXELATE: {
+            // Grid blok mengikuti baris 0 gambar penuh: tile mencakup blok utuh
+            const int block = std::min(256, pixelBlockSize(scale, step.params));
+            if (block > 1) {
+                y0 = y0 / block * block;
+                y1 = (y1 + block - 1) / block * block;
+            }
+            break;
+        }
+        default: break;
+    }
+    y0 = std::max(0, y0 - halo);
+    y1 = std::min(height, y1 + halo);
+}
+
+void EffectPipeline::runStageRows(const Stage& stage, unsigned char* rows, int width, int height, int y0, int y1,
+                                  double scale) const {
+    if (stage.fused) {
+        std::vector<PointOp> ops;
+        for (size_t i : stage.steps) ops.push_back(pointOpFor(effectSteps[i].type, effectSteps[i].params));
+        pointOpsRows(rows, width, height, y0, y1, ops, 1);
+        return;
+    }
+    const EffectStep& step = effectSteps[stage.steps.front()];
+    switch (step.type) {
+        case EffectType::BLUR: gaussianBlurImage(rows, width, y1 - y0, blurSigmaFor(step.params, scale), 1); break;
+        case EffectType::SHARPEN:
+            unsharpMaskImage(rows, width, y1 - y0, sharpenSigmaFor(scale), amountOf(step.params) * 2, 1);
+            break;
+        case EffectType::PIXELATE: pixelateImage(rows, width, y1 - y0, pixelBlockSize(scale, step.params), 1); break;
+        default: break;
+    }
+}
+
+void EffectPipeline::runTileSegment(ImageData& image, size_t firstStage, size_t lastStage, double scale,
+                                    unsigned maxThreads) const {
+    const int width = image.width, height = image.height;
+    const size_t stride = static_cast<size_t>(width) * 3;
+    const unsigned threads = maxThreads == 0 ? parallelThreads() : maxThreads;
+
+    // Halo total rantai (blur/sharpen) tanpa pembulatan blok pixelate
+    int halo = 0;
+    int block = 1;
+    for (size_t s = firstStage; s < lastStage; ++s) {
+        const EffectStep& step = effectSteps[stages[s].steps.front()];
+        if (!stages[s].fused && step.type == EffectType::PIXELATE) {
+            block = std::max(block, std::min(256, pixelBlockSize(scale, step.params)));
+            continue;
+        }
+        int y0 = height / 2, y1 = height / 2;
+        inputRows(stages[s], scale, height, y0, y1);
+        halo += std::max(height / 2 - y0, y1 - height / 2);
+    }
+    // Tanpa halo: tile seukuran cache, diproses in-place. Dengan halo, baris halo dihitung ulang
+    // oleh kedua tile tetangganya; pada tile seukuran cache itu melebihi baris intinya (halo blur
+    // capture bisa puluhan baris), jadi rantai blur/sharpen memakai satu tile per core
+    int tileRows = std::max(16, static_cast<int>(kTileBytes / stride));
+    if (halo > 0) {
+        tileRows = std::max(8 * (halo + block), (height + static_cast<int>(threads) - 1) / static_cast<int>(threads));
+    }
+    // Kelipatan blok pixelate: tanpa halo, tile pixelate tidak saling tumpang tindih
+    tileRows = (tileRows + block - 1) / block * block;
+    const int tiles = (height + tileRows - 1) / tileRows;
+
+    // Baris yang harus dihasilkan setiap stage, dihitung mundur dari baris inti tile
+    auto tileRanges = [&](int t, std::vector<std::pair<int, int>>& ranges) {
+        ranges.resize(lastStage - firstStage + 1);
+        ranges.back() = {t * tileRows, std::min(height, (t + 1) * tileRows)};
+        for (size_t s = lastStage; s-- > firstStage;) {
+            std::pair<int, int> r = ranges[s - firstStage + 1];
+            inputRows(stages[s], scale, height, r.first, r.second);
+            ranges[s - firstStage] = r;
+        }
+    };
+    // Tile yang membaca halo dari tetangganya butuh sumber utuh: hasil ditulis ke buffer terpisah
+    bool needsSource = false;
+    std::vector<std::pair<int, int>> ranges;
+    for (int t = 0; t < tiles && !needsSource; ++t) {
+        tileRanges(t, ranges);
+        needsSource = ranges.front() != ranges.back();
+    }
+    std::vector<unsigned char> output;
+    if (needsSource) output.resize(image.data.size());
+
+    parallelFor(static_cast<size_t>(tiles), [&](size_t t) {
+        std::vector<std::pair<int, int>> ranges;
+        tileRanges(static_cast<int>(t), ranges);
+        const int core0 = ranges.back().first, core1 = ranges.back().second;
+        const int top = ranges.front().first;
+        unsigned char* tile;
+        std::vector<unsigned char> buffer;
+        if (needsSource) {
+            buffer.assign(image.data.begin() + top * stride, image.data.begin() + ranges.front().second * stride);
+            tile = buffer.data();
+        } else {
+            tile = image.data.data() + top * stride;
+        }
+        for (size_t s = firstStage; s < lastStage; ++s) {
+            const std::pair<int, int>& r = ranges[s - firstStage];
+            runStageRows(stages[s], tile + (r.first - top) * stride, width, height, r.first, r.second, scale);
+        }
+        if (needsSource) {
+            std::memcpy(output.data() + core0 * stride, tile + (core0 - top) * stride, (core1 - core0) * stride);
+        }
+    }, threads);
+
+    if (needsSource) image.data.swap(output);
+}
+
+bool EffectPipeline::coefficientTransform(int width, int height, JpegCoefTransform& transform) const {
+    for (const auto& step : effectSteps) {
+        if (step.type == EffectType::GRAYSCALE && amountOf(step.params) == 128) {
+            transform.grayscale = true;
+        } else if (step.type == EffectType::PIXELATE && transform.pixelate <= 0) {
+            // Sel dibulatkan ke kelipatan iMCU (8/16 px) oleh jpegTransformCoefficients
+            transform.pixelate = pixelBlockSize(ImageEffects::previewScale(width, height), step.params);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EffectPipeline::isPointOp(EffectType type) {
+    return type == EffectType::GRAYSCALE || type == EffectType::SEPIA || type == EffectType::INVERT ||
+           type == EffectType::VIGNETTE || type == EffectType::LUT;
+}
+
+bool EffectPipeline::parseEffectName(const std::string& name, EffectType& type) {
+    static const std::map<std::string, EffectType> names = {
+        {"none", EffectType::NONE}, {"fisheye", EffectType::FISHEYE}, {"wideangle", EffectType::WIDE_ANGLE},
+        {"wide_angle", EffectType::WIDE_ANGLE}, {"grayscale", EffectType::GRAYSCALE}, {"sepia", EffectType::SEPIA},
+        {"vignette", EffectType::VIGNETTE}, {"blur", EffectType::BLUR}, {"sharpen", EffectType::SHARPEN},
+        {"invert", EffectType::INVERT}, {"pixelate", EffectType::PIXELATE}, {"lut", EffectType::LUT}};
+    auto it = names.find(name);
+    if (it == names.end()) return false;
+    type = it->second;
+    return true;
+}
+
+std::string EffectPipeline::effectName(EffectType type) {
+    switch (type) {
+        case EffectType::FISHEYE: return "fisheye";
+        case EffectType::WIDE_ANGLE: return "wideangle";
+        case EffectType::GRAYSCALE: return "grayscale";
+        case EffectType::SEPIA: return "sepia";
+        case EffectType::VIGNETTE: return "vignette";
+        case EffectType::BLUR: return "blur";
+        case EffectType::SHARPEN: return "sharpen";
+        case EffectType::INVERT: return "invert";
+        case EffectType::PIXELATE: return "pixelate";
+        case EffectType::LUT: return "lut";
+        case EffectType::NONE: break;
+    }
+    return "none";
+}
+
+bool EffectPipeline::parseSteps(const std::string& spec, std::vector<EffectStep>& steps, std::string& error) {
+    steps.clear();
+    auto addStep = [&](const std::map<std::string, std::string>& fields) {
+        auto nameIt = fields.count("effect") ? fields.find("effect") : fields.find("name");
+        EffectStep step;
+        if (nameIt == fields.end() || !parseEffectName(nameIt->second, step.type)) {
+            error = "unknown effect: " + (nameIt == fields.end() ? std::string() : nameIt->second);
+            return false;
+        }
+        try {
+            if (fields.count("intensity")) step.params.intensity = std::min(1.0, std::max(0.0, std::stod(fields.at("intensity"))));
+            if (fields.count("radius")) step.params.radius = std::max(0.0, std::stod(fields.at("radius")));
+            if (fields.count("pixelSize")) step.params.pixelSize = std::max(1, std::stoi(fields.at("pixelSize")));
+        } catch (...) {
+            error = "invalid parameter for " + nameIt->second;
+            return false;
+        }
+        if (fields.count("lut")) step.params.lut = fields.at("lut");
+        if (step.type == EffectType::LUT && step.params.lut.empty()) {
+            error = "lut step without lut name";
+            return false;
+        }
+        if (step.type == EffectType::NONE) return true;
+        if (steps.size() == kMaxSteps) {
+            error = "too many effects (max " + std::to_string(kMaxSteps) + ")";
+            return false;
+        }
+        steps.push_back(step);
+        return true;
+    };
+
+    size_t start = spec.find_first_not_of(" \t");
+    if (start != std::string::npos && spec[start] == '[') {
+        // Objek tingkat atas di dalam array, masing-masing diratakan dengan parseJsonObject
+        int depth = 0;
+        size_t objectStart = 0;
+        for (size_t i = start + 1; i < spec.size(); ++i) {
+            if (spec[i] == '{') {
+                if (depth++ == 0) objectStart = i;
+            } else if (spec[i] == '}' && depth > 0 && --depth == 0) {
+                std::map<std::string, std::string> fields;
+                parseJsonObject(spec.substr(objectStart, i - objectStart + 1), fields, "");
+                if (!addStep(fields)) return false;
+            }
+        }
+        return true;
+    }
+    for (const std::string& item : splitString(spec, ',')) {
+        if (item.empty()) continue;
+        std::vector<std::string> parts = splitString(item, ':');
+        std::map<std::string, std::string> fields;
+        fields["effect"] = parts[0];
+        size_t next = 1;
+        if (parts[0] == "lut" && parts.size() > 1) fields["lut"] = parts[next++];
+        if (parts.size() > next) fields["intensity"] = parts[next];
+        if (!addStep(fields)) return false;
+    }
+    return true;
+}
+
+bool EffectPipeline::resolveLuts(std::vector<EffectStep>& steps, LutLibrary& library, std::string& error) {
+    for (auto& step : steps) {
+        if (step.type != EffectType::LUT) continue;
+        step.params.lutTable = library.get(step.params.lut, error);
+        if (!step.params.lutTable) return false;
+    }
+    return true;
 }
 
 // ============ GENERIC FILE IO (JPEG/PNG/BMP) ============
 ImageData ImageEffects::decodeFile(const std::string& filePath) {
     ImageData out;
+    std::vector<unsigned char> bytes;
+    if (readFileBytes(filePath, bytes) && isJpegData(bytes.data(), bytes.size()) &&
+        jpegDecodeScaled(bytes.data(), bytes.size(), 1, 3, out.data, out.width, out.height)) {
+        // libjpeg-turbo; original kamera dengan restart marker di-decode paralel
+        return out;
+    }
+    out = ImageData();
     int w=0,h=0,c=0;
     unsigned char* data = stbi_load(filePath.c_str(), &w, &h, &c, 3);
     if (!data || w<=0 || h<=0) return out;
@@ -290,6 +741,11 @@ bool ImageEffects::encodeFile(const std::string& filePath, const ImageData& imag
     } else if (endsWith(".bmp")) {
         return stbi_write_bmp(filePath.c_str(), image.width, image.height, 3, image.data.data()) != 0;
     } else {
-        return stbi_write_jpg(filePath.c_str(), image.width, image.height, 3, image.data.data(), 85) != 0;
+        std::vector<unsigned char> jpeg;
+        if (!jpegEncodeParallel(image.data.data(), image.width, image.height, 3,
+                                static_cast<size_t>(image.width) * 3, 85, jpeg)) return false;
+        std::ofstream ofs(filePath, std::ios::binary);
+        ofs.write(reinterpret_cast<const char*>(jpeg.data()), static_cast<std::streamsize>(jpeg.size()));
+        return static_cast<bool>(ofs);
     }
 }
\ No newline at end of file
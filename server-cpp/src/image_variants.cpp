@@ -0,0 +1,250 @@
+#include "../include/image_variants.h"
+#include "../include/template_renderer.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const int kMinWidth = 16;
+const int kMaxWidth = 2560;
+const int kDefaultQuality = 75;
+
+std::string baseName(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+bool parseInt(const std::string& s, int& out) {
+    if (s.empty() || s.size() > 6) return false;
+    out = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+        out = out * 10 + (c - '0');
+    }
+    return true;
+}
+
+bool writeFileAtomic(const std::string& path, const std::vector<unsigned char>& bytes) {
+    const std::string tmp = path + ".part";
+    std::ofstream ofs(tmp, std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+    ofs.close();
+    if (!ofs || std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+}
+
+ImageVariantStore::ImageVariantStore(const std::string& dir, const std::vector<int>& eagerWidths, int eagerQuality)
+    : dir(dir), eagerWidths(eagerWidths), eagerQuality(eagerQuality) {
+    mkdir(dir.c_str(), 0755);
+    worker = std::thread(&ImageVariantStore::workerLoop, this);
+}
+
+ImageVariantStore::~ImageVariantStore() {
+    shutdown();
+}
+
+void ImageVariantStore::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        stopping = true;
+    }
+    cv.notify_all();
+    if (worker.joinable()) worker.join();
+    // Task yang belum sempat jalan tetap menjawab waiter-nya (gagal) supaya respons HTTP
+    // yang ditahan tidak menggantung, sama seperti RenderJobManager::shutdown
+    std::map<std::string, std::vector<Ready>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        pending.swap(inflight);
+        queue.clear();
+    }
+    for (const auto& entry : pending) {
+        for (const auto& ready : entry.second) {
+            if (ready) ready("");
+        }
+    }
+}
+
+bool ImageVariantStore::isStopping() {
+    std::lock_guard<std::mutex> lock(mu);
+    return stopping;
+}
+
+bool ImageVariantStore::normalize(const std::string& widthParam, const std::string& qualityParam, int& width, int& quality) {
+    width = 0;
+    quality = kDefaultQuality;
+    if (!widthParam.empty()) {
+        if (!parseInt(widthParam, width)) return false;
+        width = std::min(kMaxWidth, std::max(kMinWidth, (width + 15) / 16 * 16));
+    }
+    if (!qualityParam.empty()) {
+        if (!parseInt(qualityParam, quality)) return false;
+        quality = std::min(95, std::max(30, (quality + 2) / 5 * 5));
+    }
+    return true;
+}
+
+std::string ImageVariantStore::variantPath(const std::string& sourcePath, int width, int quality) const {
+    struct stat st;
+    if (stat(sourcePath.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return "";
+    unsigned long long h = 1469598103934665603ULL;
+    const unsigned long long parts[4] = {
+        (unsigned long long)st.st_ino, (unsigned long long)st.st_size,
+        (unsigned long long)st.st_mtim.tv_sec, (unsigned long long)st.st_mtim.tv_nsec
+    };
+    for (unsigned long long v : parts) {
+        for (int i = 0; i < 8; ++i, v >>= 8) {
+            h ^= v & 0xff;
+            h *= 1099511628211ULL;
+        }
+    }
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), ".%016llx.w%dq%d.jpg", h, width, quality);
+    return dir + "/" + baseName(sourcePath) + suffix;
+}
+
+bool ImageVariantStore::lookup(const std::string& sourcePath, int width, int quality, std::string& path) {
+    path = variantPath(sourcePath, width, quality);
+    if (path.empty()) return false;
+    return access(path.c_str(), F_OK) == 0;
+}
+
+void ImageVariantStore::generate(const std::string& sourcePath, int width, int quality, const Ready& ready) {
+    const std::string path = variantPath(sourcePath, width, quality);
+    if (path.empty()) {
+        if (ready) ready("");
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mu);
+        if (stopping) {
+            // Store sedang ditutup: tidak akan ada worker yang menjawab
+            lock.unlock();
+            if (ready) ready("");
+            return;
+        }
+        auto it = inflight.find(path);
+        if (it != inflight.end()) {
+            // Sudah diantrikan (on-demand lain atau warm): cukup ikut menunggu
+            if (ready) it->second.push_back(ready);
+            return;
+        }
+        inflight[path].push_back(ready);
+    }
+    Task task;
+    task.sourcePath = sourcePath;
+    Target target;
+    target.path = path;
+    target.width = width;
+    target.quality = quality;
+    task.targets.push_back(target);
+    enqueue(std::move(task), true);
+}
+
+void ImageVariantStore::warm(const std::string& sourcePath) {
+    Task task;
+    task.sourcePath = sourcePath;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        if (stopping) return;
+        for (int width : eagerWidths) {
+            Target target;
+            target.path = variantPath(sourcePath, width, eagerQuality);
+            if (target.path.empty()) return;
+            if (inflight.count(target.path) || access(target.path.c_str(), F_OK) == 0) continue;
+            target.width = width;
+            target.quality = eagerQuality;
+            inflight[target.path];
+            task.targets.push_back(target);
+        }
+    }
+    if (!task.targets.empty()) enqueue(std::move(task), false);
+}
+
+void ImageVariantStore::removeFor(const std::string& sourcePath) {
+    const std::string prefix = baseName(sourcePath) + ".";
+    DIR* d = opendir(dir.c_str());
+    if (!d) return;
+    int removed = 0;
+    while (struct dirent* e = readdir(d)) {
+        const std::string name = e->d_name;
+        if (name.compare(0, prefix.size(), prefix) == 0 && unlink((dir + "/" + name).c_str()) == 0) ++removed;
+    }
+    closedir(d);
+    if (removed > 0) std::cout << "🧹 Removed " << removed << " image variants of " << baseName(sourcePath) << std::endl;
+}
+
+void ImageVariantStore::enqueue(Task&& task, bool urgent) {
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        if (urgent) queue.push_front(std::move(task));
+        else queue.push_back(std::move(task));
+    }
+    cv.notify_one();
+}
+
+void ImageVariantStore::workerLoop() {
+    for (;;) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            cv.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        runTask(task);
+    }
+}
+
+void ImageVariantStore::runTask(const Task& task) {
+    std::vector<OutputLevel> levels;
+    for (const auto& target : task.targets) {
+        OutputLevel level;
+        level.width = target.width;
+        level.quality = target.quality;
+        levels.push_back(level);
+    }
+
+    std::vector<std::vector<unsigned char>> jpegs;
+    bool ok = false;
+    try {
+        TemplateRenderer renderer;
+        ok = renderer.renderPhotoVariants(task.sourcePath, levels, jpegs);
+    } catch (const std::exception& e) {
+        std::cerr << "Error generating image variants: " << e.what() << std::endl;
+    }
+
+    for (size_t i = 0; i < task.targets.size(); ++i) {
+        const Target& target = task.targets[i];
+        const bool stored = ok && writeFileAtomic(target.path, jpegs[i]);
+        std::vector<Ready> waiters;
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            auto it = inflight.find(target.path);
+            if (it != inflight.end()) {
+                waiters.swap(it->second);
+                inflight.erase(it);
+            }
+        }
+        if (stored) {
+            std::cout << "🖼️ Image variant ready: " << target.path << " (" << jpegs[i].size() << " bytes)" << std::endl;
+        } else {
+            std::cerr << "❌ Failed to build image variant: " << target.path << std::endl;
+        }
+        for (const auto& ready : waiters) {
+            if (ready) ready(stored ? target.path : "");
+        }
+    }
+}
@@ -0,0 +1,832 @@
+#include "../include/jpeg_codec.h"
+#include "../include/parallel.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <csetjmp>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <jpeglib.h>
+
+namespace {
+
+struct JpegErrorManager {
+    jpeg_error_mgr pub;
+    jmp_buf setjmpBuffer;
+};
+
+void jpegErrorExit(j_common_ptr cinfo) {
+    JpegErrorManager* err = reinterpret_cast<JpegErrorManager*>(cinfo->err);
+    char msg[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(cinfo, msg);
+    std::cerr << "❌ libjpeg error: " << msg << std::endl;
+    longjmp(err->setjmpBuffer, 1);
+}
+
+void jpegSilentOutput(j_common_ptr) {}
+
+// Destination manager yang menulis langsung ke std::vector
+const size_t kDestChunk = 256 * 1024;
+
+struct VectorDestination {
+    jpeg_destination_mgr pub;
+    std::vector<unsigned char>* out;
+};
+
+void vectorInitDestination(j_compress_ptr cinfo) {
+    VectorDestination* dest = reinterpret_cast<VectorDestination*>(cinfo->dest);
+    dest->out->resize(kDestChunk);
+    dest->pub.next_output_byte = dest->out->data();
+    dest->pub.free_in_buffer = dest->out->size();
+}
+
+boolean vectorEmptyOutputBuffer(j_compress_ptr cinfo) {
+    VectorDestination* dest = reinterpret_cast<VectorDestination*>(cinfo->dest);
+    size_t used = dest->out->size();
+    dest->out->resize(used + kDestChunk);
+    dest->pub.next_output_byte = dest->out->data() + used;
+    dest->pub.free_in_buffer = kDestChunk;
+    return TRUE;
+}
+
+void vectorTermDestination(j_compress_ptr cinfo) {
+    VectorDestination* dest = reinterpret_cast<VectorDestination*>(cinfo->dest);
+    dest->out->resize(dest->out->size() - dest->pub.free_in_buffer);
+}
+
+}
+
+bool readFileBytes(const std::string& path, std::vector<unsigned char>& out) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) return false;
+    std::streamsize size = file.tellg();
+    if (size <= 0) return false;
+    file.seekg(0, std::ios::beg);
+    out.resize(static_cast<size_t>(size));
+    if (!file.read(reinterpret_cast<char*>(out.data()), size)) {
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+bool isJpegData(const unsigned char* data, size_t size) {
+    return size >= 3 && data[0] == 0xFF && data[1] == 0xD8 && data[2] == 0xFF;
+}
+
+bool jpegReadDimensions(const unsigned char* data, size_t size, int& width, int& height) {
+    JpegScanlineReader reader;
+    if (!reader.openMemory(data, size)) return false;
+    width = reader.imageWidth();
+    height = reader.imageHeight();
+    return width > 0 && height > 0;
+}
+
+int jpegChooseScaleDenom(int width, int height, int minW, int minH) {
+    if (width <= 0 || height <= 0) return 1;
+    for (int denom = 8; denom > 1; denom /= 2) {
+        int sw = (width + denom - 1) / denom;
+        int sh = (height + denom - 1) / denom;
+        if ((minW <= 0 || sw >= minW) && (minH <= 0 || sh >= minH)) {
+            return denom;
+        }
+    }
+    return 1;
+}
+
+namespace {
+
+// Posisi restart marker di scan tunggal JPEG baseline, diindeks dalam satu lintasan
+struct RestartIndex {
+    size_t sosStart = 0;     // awal marker SOS
+    size_t scanStart = 0;    // awal data entropy
+    size_t scanEnd = 0;      // marker non-RST pertama setelah data (biasanya EOI)
+    size_t heightPos = 0;    // field tinggi di SOF
+    int width = 0;
+    int height = 0;
+    int mcuHeight = 8;
+    int mcusPerRow = 0;
+    int mcuRows = 0;
+    unsigned interval = 0;
+    std::vector<size_t> markers;
+};
+
+bool buildRestartIndex(const unsigned char* data, size_t size, RestartIndex& idx) {
+    size_t pos = 2;
+    int components = 0, maxH = 1, maxV = 1;
+    for (;;) {
+        while (pos + 1 < size && data[pos] == 0xFF && data[pos + 1] == 0xFF) ++pos;  // fill byte
+        if (pos + 4 > size || data[pos] != 0xFF) return false;
+        const unsigned char marker = data[pos + 1];
+        const size_t length = (static_cast<size_t>(data[pos + 2]) << 8) | data[pos + 3];
+        if (length < 2 || pos + 2 + length > size) return false;
+        const unsigned char* seg = data + pos + 4;
+        if (marker == 0xDD && length >= 4) {
+            idx.interval = (static_cast<unsigned>(seg[0]) << 8) | seg[1];
+        } else if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            // Hanya baseline/extended Huffman sekuensial; progressive & lossless ditangani libjpeg biasa
+            if ((marker != 0xC0 && marker != 0xC1) || length < 8) return false;
+            idx.heightPos = pos + 5;
+            idx.height = (seg[1] << 8) | seg[2];
+            idx.width = (seg[3] << 8) | seg[4];
+            components = seg[5];
+            if (components <= 0 || length < 8 + 3 * static_cast<size_t>(components)) return false;
+            for (int c = 0; c < components; ++c) {
+                maxH = std::max(maxH, seg[7 + c * 3] >> 4);
+                maxV = std::max(maxV, seg[7 + c * 3] & 15);
+            }
+        } else if (marker == 0xDA) {
+            // Satu scan berisi semua komponen; file multi-scan tidak bisa dipotong per baris
+            if (idx.heightPos == 0 || seg[0] != components) return false;
+            idx.sosStart = pos;
+            idx.scanStart = pos + 2 + length;
+            break;
+        }
+        pos += 2 + length;
+    }
+    if (idx.interval == 0 || idx.width <= 0 || idx.height <= 0) return false;
+    const int mcuW = components == 1 ? 8 : 8 * maxH;
+    idx.mcuHeight = components == 1 ? 8 : 8 * maxV;
+    idx.mcusPerRow = (idx.width + mcuW - 1) / mcuW;
+    idx.mcuRows = (idx.height + idx.mcuHeight - 1) / idx.mcuHeight;
+
+    // 0xFF di data entropy selalu diikuti 00 (stuffing) atau marker
+    for (pos = idx.scanStart; pos + 1 < size; ++pos) {
+        if (data[pos] != 0xFF) continue;
+        const unsigned char next = data[pos + 1];
+        if (next == 0x00 || next == 0xFF) continue;
+        if (next >= 0xD0 && next <= 0xD7) {
+            idx.markers.push_back(pos);
+            ++pos;
+            continue;
+        }
+        idx.scanEnd = pos;
+        break;
+    }
+    if (idx.scanEnd == 0) return false;
+    const size_t totalMcus = static_cast<size_t>(idx.mcusPerRow) * idx.mcuRows;
+    return idx.markers.size() == (totalMcus - 1) / idx.interval;
+}
+
+size_t gcdSize(size_t a, size_t b) {
+    while (b) {
+        size_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// JPEG mandiri untuk baris MCU [r0, r1): header asli dengan tinggi di-patch, data entropy
+// dari restart marker yang bersangkutan dengan RSTn dinomori ulang dari 0
+void buildChunk(const unsigned char* data, const RestartIndex& idx, int r0, int r1, std::vector<unsigned char>& chunk) {
+    const size_t rowMcus = static_cast<size_t>(idx.mcusPerRow);
+    const size_t from = r0 == 0 ? idx.scanStart : idx.markers[r0 * rowMcus / idx.interval - 1] + 2;
+    const size_t to = r1 == idx.mcuRows ? idx.scanEnd : idx.markers[r1 * rowMcus / idx.interval - 1];
+    const int height = r1 == idx.mcuRows ? idx.height - r0 * idx.mcuHeight : (r1 - r0) * idx.mcuHeight;
+
+    chunk.clear();
+    chunk.reserve(idx.scanStart + (to - from) + 2);
+    chunk.insert(chunk.end(), data, data + idx.scanStart);
+    chunk[idx.heightPos] = static_cast<unsigned char>((height >> 8) & 0xFF);
+    chunk[idx.heightPos + 1] = static_cast<unsigned char>(height & 0xFF);
+    const size_t base = chunk.size();
+    chunk.insert(chunk.end(), data + from, data + to);
+    unsigned restartIndex = 0;
+    for (size_t k = base; k + 1 < chunk.size(); ++k) {
+        if (chunk[k] == 0xFF && chunk[k + 1] >= 0xD0 && chunk[k + 1] <= 0xD7) {
+            chunk[k + 1] = static_cast<unsigned char>(0xD0 + (restartIndex++ & 7));
+            ++k;
+        }
+    }
+    chunk.push_back(0xFF);
+    chunk.push_back(0xD9);
+}
+
+// Kelompok baris MCU di-decode paralel. Tiap kelompok ikut men-decode satu langkah restart
+// di atas & bawahnya sebagai konteks fancy upsampling chroma, jadi hasilnya identik dengan decode penuh
+bool decodeRestartSegments(const unsigned char* data, size_t size, int scaleDenom, int channels, unsigned threads,
+                           std::vector<unsigned char>& out, int& outW, int& outH) {
+    RestartIndex idx;
+    if (!buildRestartIndex(data, size, idx)) return false;
+    const size_t rowMcus = static_cast<size_t>(idx.mcusPerRow);
+    // Batas kelompok hanya boleh jatuh di baris MCU yang diawali restart marker
+    const int rowStep = static_cast<int>(idx.interval / gcdSize(rowMcus, idx.interval));
+    const int boundaries = (idx.mcuRows - 1) / rowStep;
+    const int chunks = std::min<int>(static_cast<int>(threads) * 2, boundaries + 1);
+    if (chunks < 2) return false;
+    const int chunkRows = ((idx.mcuRows + chunks - 1) / chunks + rowStep - 1) / rowStep * rowStep;
+
+    const int denom = scaleDenom > 0 ? scaleDenom : 1;
+    if (idx.mcuHeight % denom != 0) return false;
+    outW = (idx.width + denom - 1) / denom;
+    outH = (idx.height + denom - 1) / denom;
+    const size_t stride = static_cast<size_t>(outW) * channels;
+    out.resize(stride * outH);
+    const int scaledMcuHeight = idx.mcuHeight / denom;
+
+    const size_t count = static_cast<size_t>((idx.mcuRows + chunkRows - 1) / chunkRows);
+    std::vector<char> ok(count, 0);
+    parallelFor(count, [&](size_t c) {
+        const int r0 = static_cast<int>(c) * chunkRows;
+        const int r1 = std::min(idx.mcuRows, r0 + chunkRows);
+        const int s0 = std::max(0, r0 - rowStep);
+        const int s1 = std::min(idx.mcuRows, r1 + rowStep);
+        std::vector<unsigned char> chunk;
+        buildChunk(data, idx, s0, s1, chunk);
+        JpegScanlineReader reader;
+        if (!reader.openMemory(chunk.data(), chunk.size()) || !reader.start(denom, channels) || reader.width() != outW) return;
+        const int keepFrom = r0 * scaledMcuHeight;
+        const int keepTo = std::min(outH, r1 * scaledMcuHeight);
+        std::vector<unsigned char> scratch(stride);
+        for (int y = s0 * scaledMcuHeight; y < keepTo; ++y) {
+            unsigned char* row = y < keepFrom ? scratch.data() : out.data() + stride * y;
+            if (!reader.readRow(row)) return;
+        }
+        ok[c] = 1;
+    }, threads);
+    for (char c : ok) {
+        if (!c) return false;
+    }
+    return true;
+}
+
+}
+
+bool jpegDecodeScaled(const unsigned char* data, size_t size, int scaleDenom, int channels,
+                      std::vector<unsigned char>& out, int& outW, int& outH, unsigned maxThreads) {
+    const unsigned threads = maxThreads == 0 ? parallelThreads() : maxThreads;
+    if (threads > 1 && isJpegData(data, size) &&
+        decodeRestartSegments(data, size, scaleDenom, channels, threads, out, outW, outH)) {
+        return true;
+    }
+    JpegScanlineReader reader;
+    if (!reader.openMemory(data, size) || !reader.start(scaleDenom, channels)) return false;
+    outW = reader.width();
+    outH = reader.height();
+    const size_t stride = static_cast<size_t>(outW) * channels;
+    out.resize(stride * outH);
+    for (int y = 0; y < outH; ++y) {
+        if (!reader.readRow(out.data() + stride * y)) {
+            out.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+// ============ JpegScanlineReader ============
+struct JpegScanlineReader::Impl {
+    jpeg_decompress_struct cinfo;
+    JpegErrorManager jerr;
+    FILE* file = nullptr;
+    bool created = false;
+    bool headerRead = false;
+    bool started = false;
+    bool expandAlpha = false;
+
+    ~Impl() {
+        if (created) jpeg_destroy_decompress(&cinfo);
+        if (file) fclose(file);
+    }
+};
+
+JpegScanlineReader::JpegScanlineReader() : impl(new Impl()) {}
+JpegScanlineReader::~JpegScanlineReader() {}
+
+bool JpegScanlineReader::open(const std::string& path) {
+    impl.reset(new Impl());
+    impl->file = fopen(path.c_str(), "rb");
+    if (!impl->file) return false;
+    unsigned char magic[3] = {0, 0, 0};
+    if (fread(magic, 1, 3, impl->file) != 3 || !isJpegData(magic, 3)) return false;
+    rewind(impl->file);
+    Impl* d = impl.get();
+    d->cinfo.err = jpeg_std_error(&d->jerr.pub);
+    d->jerr.pub.error_exit = jpegErrorExit;
+    d->jerr.pub.output_message = jpegSilentOutput;
+    if (setjmp(d->jerr.setjmpBuffer)) {
+        return false;
+    }
+    jpeg_create_decompress(&d->cinfo);
+    d->created = true;
+    jpeg_stdio_src(&d->cinfo, d->file);
+    jpeg_read_header(&d->cinfo, TRUE);
+    d->headerRead = true;
+    return true;
+}
+
+bool JpegScanlineReader::openMemory(const unsigned char* data, size_t size) {
+    impl.reset(new Impl());
+    if (!isJpegData(data, size)) return false;
+    Impl* d = impl.get();
+    d->cinfo.err = jpeg_std_error(&d->jerr.pub);
+    d->jerr.pub.error_exit = jpegErrorExit;
+    d->jerr.pub.output_message = jpegSilentOutput;
+    if (setjmp(d->jerr.setjmpBuffer)) {
+        return false;
+    }
+    jpeg_create_decompress(&d->cinfo);
+    d->created = true;
+    jpeg_mem_src(&d->cinfo, const_cast<unsigned char*>(data), static_cast<unsigned long>(size));
+    jpeg_read_header(&d->cinfo, TRUE);
+    d->headerRead = true;
+    return true;
+}
+
+int JpegScanlineReader::imageWidth() const {
+    return impl->headerRead ? static_cast<int>(impl->cinfo.image_width) : 0;
+}
+
+int JpegScanlineReader::imageHeight() const {
+    return impl->headerRead ? static_cast<int>(impl->cinfo.image_height) : 0;
+}
+
+int JpegScanlineReader::restartInterval() const {
+    return impl->headerRead ? static_cast<int>(impl->cinfo.restart_interval) : 0;
+}
+
+bool JpegScanlineReader::start(int scaleDenom, int channels) {
+    Impl* d = impl.get();
+    if (!d->headerRead || d->started || (channels != 3 && channels != 4)) return false;
+    if (setjmp(d->jerr.setjmpBuffer)) {
+        return false;
+    }
+    d->cinfo.scale_num = 1;
+    d->cinfo.scale_denom = static_cast<unsigned int>(scaleDenom > 0 ? scaleDenom : 1);
+#ifdef JCS_EXTENSIONS
+    d->cinfo.out_color_space = (channels == 4) ? JCS_EXT_RGBA : JCS_RGB;
+#else
+    d->cinfo.out_color_space = JCS_RGB;
+    d->expandAlpha = (channels == 4);
+#endif
+    jpeg_start_decompress(&d->cinfo);
+    d->started = true;
+    return true;
+}
+
+int JpegScanlineReader::width() const {
+    return impl->started ? static_cast<int>(impl->cinfo.output_width) : 0;
+}
+
+int JpegScanlineReader::height() const {
+    return impl->started ? static_cast<int>(impl->cinfo.output_height) : 0;
+}
+
+bool JpegScanlineReader::readRow(unsigned char* row) {
+    Impl* d = impl.get();
+    if (!d->started || d->cinfo.output_scanline >= d->cinfo.output_height) return false;
+    if (setjmp(d->jerr.setjmpBuffer)) {
+        d->started = false;
+        return false;
+    }
+    JSAMPROW rows[1] = { row };
+    jpeg_read_scanlines(&d->cinfo, rows, 1);
+    if (d->expandAlpha) {
+        // RGB -> RGBA in-place, dari belakang supaya tidak menimpa data
+        for (int x = static_cast<int>(d->cinfo.output_width) - 1; x >= 0; --x) {
+            row[x * 4 + 3] = 255;
+            row[x * 4 + 2] = row[x * 3 + 2];
+            row[x * 4 + 1] = row[x * 3 + 1];
+            row[x * 4 + 0] = row[x * 3 + 0];
+        }
+    }
+    return true;
+}
+
+// ============ JpegScanlineWriter ============
+struct JpegScanlineWriter::Impl {
+    jpeg_compress_struct cinfo;
+    JpegErrorManager jerr;
+    VectorDestination dest;
+    bool created = false;
+    bool started = false;
+    int channels = 3;
+    std::vector<unsigned char> rgbRow;
+
+    ~Impl() {
+        if (created) jpeg_destroy_compress(&cinfo);
+    }
+};
+
+JpegScanlineWriter::JpegScanlineWriter() : impl(new Impl()) {}
+JpegScanlineWriter::~JpegScanlineWriter() {}
+
+bool JpegScanlineWriter::begin(std::vector<unsigned char>& out, int width, int height, int channels, int quality, int restartRows) {
+    impl.reset(new Impl());
+    if (width <= 0 || height <= 0 || (channels != 3 && channels != 4)) return false;
+    Impl* d = impl.get();
+    d->cinfo.err = jpeg_std_error(&d->jerr.pub);
+    d->jerr.pub.error_exit = jpegErrorExit;
+    d->jerr.pub.output_message = jpegSilentOutput;
+    if (setjmp(d->jerr.setjmpBuffer)) {
+        return false;
+    }
+    jpeg_create_compress(&d->cinfo);
+    d->created = true;
+
+    out.clear();
+    d->dest.out = &out;
+    d->dest.pub.init_destination = vectorInitDestination;
+    d->dest.pub.empty_output_buffer = vectorEmptyOutputBuffer;
+    d->dest.pub.term_destination = vectorTermDestination;
+    d->cinfo.dest = &d->dest.pub;
+
+    d->cinfo.image_width = static_cast<JDIMENSION>(width);
+    d->cinfo.image_height = static_cast<JDIMENSION>(height);
+    d->channels = channels;
+#ifdef JCS_EXTENSIONS
+    d->cinfo.input_components = channels;
+    d->cinfo.in_color_space = (channels == 4) ? JCS_EXT_RGBA : JCS_RGB;
+#else
+    d->cinfo.input_components = 3;
+    d->cinfo.in_color_space = JCS_RGB;
+    if (channels == 4) d->rgbRow.resize(static_cast<size_t>(width) * 3);
+#endif
+    jpeg_set_defaults(&d->cinfo);
+    jpeg_set_quality(&d->cinfo, quality, TRUE);
+    if (restartRows > 0) d->cinfo.restart_in_rows = restartRows;
+    jpeg_start_compress(&d->cinfo, TRUE);
+    d->started = true;
+    return true;
+}
+
+bool JpegScanlineWriter::writeRows(const unsigned char* rows, int count, size_t stride) {
+    Impl* d = impl.get();
+    if (!d->started) return false;
+    if (setjmp(d->jerr.setjmpBuffer)) {
+        d->started = false;
+        return false;
+    }
+    for (int i = 0; i < count && d->cinfo.next_scanline < d->cinfo.image_height; ++i) {
+        const unsigned char* src = rows + stride * i;
+        JSAMPROW row[1] = { const_cast<unsigned char*>(src) };
+        if (!d->rgbRow.empty()) {
+            // Tanpa JCS_EXTENSIONS: buang alpha per baris, bukan per gambar
+            const int w = static_cast<int>(d->cinfo.image_width);
+            for (int x = 0; x < w; ++x) {
+                d->rgbRow[x * 3 + 0] = src[x * 4 + 0];
+                d->rgbRow[x * 3 + 1] = src[x * 4 + 1];
+                d->rgbRow[x * 3 + 2] = src[x * 4 + 2];
+            }
+            row[0] = d->rgbRow.data();
+        }
+        jpeg_write_scanlines(&d->cinfo, row, 1);
+    }
+    return true;
+}
+
+bool JpegScanlineWriter::finish() {
+    Impl* d = impl.get();
+    if (!d->started) return false;
+    if (setjmp(d->jerr.setjmpBuffer)) {
+        d->started = false;
+        return false;
+    }
+    jpeg_finish_compress(&d->cinfo);
+    d->started = false;
+    return true;
+}
+
+// ============ ParallelJpegWriter ============
+namespace {
+
+// Semua segmen memakai tabel default yang sama (quant dari quality, Huffman standar, 4:2:0),
+// jadi cukup header segmen pertama yang dipakai untuk seluruh gambar
+bool encodeSegment(const unsigned char* rows, size_t stride, int width, int height, int channels,
+                   int quality, std::vector<unsigned char>& out) {
+    JpegScanlineWriter writer;
+    return writer.begin(out, width, height, channels, quality, 1) &&
+           writer.writeRows(rows, height, stride) &&
+           writer.finish();
+}
+
+// Cari offset field tinggi di SOF dan awal data entropy (setelah header SOS)
+bool locateScan(const std::vector<unsigned char>& jpeg, size_t& heightPos, size_t& scanStart) {
+    size_t pos = 2;
+    heightPos = 0;
+    while (pos + 4 <= jpeg.size()) {
+        if (jpeg[pos] != 0xFF) return false;
+        const unsigned char marker = jpeg[pos + 1];
+        const size_t length = (static_cast<size_t>(jpeg[pos + 2]) << 8) | jpeg[pos + 3];
+        if (marker == 0xC0 || marker == 0xC1) heightPos = pos + 5;
+        if (marker == 0xDA) {
+            scanStart = pos + 2 + length;
+            return heightPos != 0 && scanStart + 2 <= jpeg.size();
+        }
+        pos += 2 + length;
+    }
+    return false;
+}
+
+// Sambung segmen: header segmen pertama (tinggi di-patch), entropy data tiap segmen dengan
+// RSTn dinomori ulang secara global, RSTn di antara segmen, lalu EOI
+bool joinSegments(const std::vector<std::vector<unsigned char>>& parts, int height, std::vector<unsigned char>& out) {
+    size_t heightPos = 0, scanStart = 0;
+    if (parts.empty() || !locateScan(parts[0], heightPos, scanStart)) return false;
+    size_t total = scanStart + 2;
+    for (const auto& part : parts) total += part.size();
+    out.clear();
+    out.reserve(total);
+    out.insert(out.end(), parts[0].begin(), parts[0].begin() + scanStart);
+    out[heightPos] = static_cast<unsigned char>((height >> 8) & 0xFF);
+    out[heightPos + 1] = static_cast<unsigned char>(height & 0xFF);
+
+    unsigned restartIndex = 0;
+    for (size_t i = 0; i < parts.size(); ++i) {
+        const std::vector<unsigned char>& part = parts[i];
+        size_t hp = 0, start = 0;
+        if (!locateScan(part, hp, start)) return false;
+        const size_t end = part.size() - 2;  // tanpa EOI
+        if (part[end] != 0xFF || part[end + 1] != 0xD9) return false;
+        const size_t base = out.size();
+        out.insert(out.end(), part.begin() + start, part.begin() + end);
+        // Di data entropy 0xFF selalu di-stuff jadi FF00, jadi FFD0..FFD7 pasti marker restart
+        for (size_t k = base; k + 1 < out.size(); ++k) {
+            if (out[k] == 0xFF && out[k + 1] >= 0xD0 && out[k + 1] <= 0xD7) {
+                out[k + 1] = static_cast<unsigned char>(0xD0 + (restartIndex++ & 7));
+                ++k;
+            }
+        }
+        if (i + 1 < parts.size()) {
+            out.push_back(0xFF);
+            out.push_back(static_cast<unsigned char>(0xD0 + (restartIndex++ & 7)));
+        }
+    }
+    out.push_back(0xFF);
+    out.push_back(0xD9);
+    return true;
+}
+
+unsigned encoderThreads(unsigned maxThreads, int height) {
+    const unsigned threads = maxThreads == 0 ? parallelThreads() : maxThreads;
+    const unsigned segments = static_cast<unsigned>((height + kJpegSegmentRows - 1) / kJpegSegmentRows);
+    return std::min(threads, segments);
+}
+
+}
+
+bool jpegEncodeParallel(const unsigned char* pixels, int width, int height, int channels, size_t stride,
+                        int quality, std::vector<unsigned char>& out, unsigned maxThreads) {
+    if (!pixels || width <= 0 || height <= 0) return false;
+    const unsigned threads = encoderThreads(maxThreads, height);
+    if (threads <= 1) {
+        JpegScanlineWriter writer;
+        return writer.begin(out, width, height, channels, quality) &&
+               writer.writeRows(pixels, height, stride) &&
+               writer.finish();
+    }
+    const size_t segments = static_cast<size_t>((height + kJpegSegmentRows - 1) / kJpegSegmentRows);
+    std::vector<std::vector<unsigned char>> parts(segments);
+    std::vector<char> ok(segments, 0);
+    parallelFor(segments, [&](size_t i) {
+        const int y0 = static_cast<int>(i) * kJpegSegmentRows;
+        const int rows = std::min(kJpegSegmentRows, height - y0);
+        ok[i] = encodeSegment(pixels + stride * y0, stride, width, rows, channels, quality, parts[i]);
+    }, threads);
+    for (char s : ok) {
+        if (!s) return false;
+    }
+    return joinSegments(parts, height, out);
+}
+
+struct ParallelJpegWriter::Impl {
+    struct Segment {
+        std::vector<unsigned char> pixels;
+        int rows = 0;
+    };
+
+    std::vector<unsigned char>* out = nullptr;
+    int width = 0;
+    int height = 0;
+    int channels = 3;
+    int quality = 90;
+    int rowsWritten = 0;
+    bool started = false;
+
+    // Jalur satu thread
+    std::unique_ptr<JpegScanlineWriter> single;
+
+    // Jalur paralel: segmen penuh diantre ke worker; antrean dibatasi supaya memori tetap kecil
+    std::vector<std::vector<unsigned char>> parts;
+    std::vector<char> partOk;
+    std::unique_ptr<Segment> current;
+    size_t nextIndex = 0;
+    std::mutex mu;
+    std::condition_variable workReady;
+    std::condition_variable spaceReady;
+    std::deque<std::pair<size_t, std::unique_ptr<Segment>>> queue;
+    size_t inFlight = 0;
+    size_t maxInFlight = 0;
+    bool closing = false;
+    std::vector<std::thread> workers;
+
+    ~Impl() { stopWorkers(); }
+
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mu);
+        for (;;) {
+            workReady.wait(lock, [&] { return closing || !queue.empty(); });
+            if (queue.empty()) return;
+            size_t index = queue.front().first;
+            std::unique_ptr<Segment> seg = std::move(queue.front().second);
+            queue.pop_front();
+            lock.unlock();
+            std::vector<unsigned char> jpeg;
+            const bool ok = encodeSegment(seg->pixels.data(), static_cast<size_t>(width) * channels,
+                                          width, seg->rows, channels, quality, jpeg);
+            seg.reset();
+            lock.lock();
+            parts[index].swap(jpeg);
+            partOk[index] = ok;
+            --inFlight;
+            spaceReady.notify_one();
+        }
+    }
+
+    void submitCurrent() {
+        if (!current || current->rows == 0) return;
+        std::unique_lock<std::mutex> lock(mu);
+        spaceReady.wait(lock, [&] { return inFlight < maxInFlight; });
+        ++inFlight;
+        queue.emplace_back(nextIndex++, std::move(current));
+        workReady.notify_one();
+    }
+
+    void stopWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            closing = true;
+        }
+        workReady.notify_all();
+        for (auto& t : workers) t.join();
+        workers.clear();
+    }
+};
+
+ParallelJpegWriter::ParallelJpegWriter() : impl(new Impl()) {}
+ParallelJpegWriter::~ParallelJpegWriter() {}
+
+bool ParallelJpegWriter::begin(std::vector<unsigned char>& out, int width, int height, int channels, int quality,
+                               unsigned maxThreads) {
+    impl.reset(new Impl());
+    if (width <= 0 || height <= 0 || (channels != 3 && channels != 4)) return false;
+    Impl* d = impl.get();
+    d->out = &out;
+    d->width = width;
+    d->height = height;
+    d->channels = channels;
+    d->quality = quality;
+    const unsigned threads = encoderThreads(maxThreads, height);
+    if (threads <= 1) {
+        d->single.reset(new JpegScanlineWriter());
+        if (!d->single->begin(out, width, height, channels, quality)) return false;
+    } else {
+        const size_t segments = static_cast<size_t>((height + kJpegSegmentRows - 1) / kJpegSegmentRows);
+        d->parts.resize(segments);
+        d->partOk.assign(segments, 0);
+        d->maxInFlight = threads * 2;
+        for (unsigned t = 0; t < threads; ++t) d->workers.emplace_back([d] { d->workerLoop(); });
+    }
+    d->started = true;
+    return true;
+}
+
+bool ParallelJpegWriter::writeRows(const unsigned char* rows, int count, size_t stride) {
+    Impl* d = impl.get();
+    if (!d->started) return false;
+    if (d->single) {
+        d->rowsWritten += count;
+        return d->single->writeRows(rows, count, stride);
+    }
+    const size_t rowBytes = static_cast<size_t>(d->width) * d->channels;
+    for (int i = 0; i < count && d->rowsWritten < d->height; ++i, ++d->rowsWritten) {
+        if (!d->current) {
+            d->current.reset(new Impl::Segment());
+            const int rowsLeft = d->height - d->rowsWritten;
+            d->current->pixels.resize(rowBytes * std::min(kJpegSegmentRows, rowsLeft));
+        }
+        std::copy(rows + stride * i, rows + stride * i + rowBytes,
+                  d->current->pixels.begin() + rowBytes * d->current->rows);
+        if (++d->current->rows == kJpegSegmentRows) d->submitCurrent();
+    }
+    return true;
+}
+
+bool ParallelJpegWriter::finish() {
+    Impl* d = impl.get();
+    if (!d->started) return false;
+    d->started = false;
+    if (d->single) return d->single->finish();
+    d->submitCurrent();
+    d->stopWorkers();
+    if (d->rowsWritten != d->height) return false;
+    for (char ok : d->partOk) {
+        if (!ok) return false;
+    }
+    return joinSegments(d->parts, d->height, *d->out);
+}
+
+// ============ JpegFrameCodec ============
+struct JpegFrameCodec::Impl {
+    jpeg_decompress_struct dinfo;
+    jpeg_compress_struct cinfo;
+    JpegErrorManager derr;
+    JpegErrorManager cerr;
+    VectorDestination dest;
+    bool decoderCreated = false;
+    bool encoderCreated = false;
+    std::vector<JSAMPROW> rows;
+
+    ~Impl() {
+        if (decoderCreated) jpeg_destroy_decompress(&dinfo);
+        if (encoderCreated) jpeg_destroy_compress(&cinfo);
+    }
+};
+
+JpegFrameCodec::JpegFrameCodec() : impl(new Impl()) {}
+JpegFrameCodec::~JpegFrameCodec() {}
+
+bool JpegFrameCodec::decode(const unsigned char* data, size_t size, int scaleDenom, std::vector<unsigned char>& rgb,
+                            int& width, int& height) {
+    Impl* d = impl.get();
+    if (!isJpegData(data, size)) return false;
+    if (!d->decoderCreated) {
+        d->dinfo.err = jpeg_std_error(&d->derr.pub);
+        d->derr.pub.error_exit = jpegErrorExit;
+        d->derr.pub.output_message = jpegSilentOutput;
+        if (setjmp(d->derr.setjmpBuffer)) {
+            return false;
+        }
+        jpeg_create_decompress(&d->dinfo);
+        d->decoderCreated = true;
+    }
+    if (setjmp(d->derr.setjmpBuffer)) {
+        // Handle tetap hidup; abort mengembalikannya ke state awal untuk frame berikutnya
+        jpeg_abort_decompress(&d->dinfo);
+        return false;
+    }
+    jpeg_mem_src(&d->dinfo, const_cast<unsigned char*>(data), static_cast<unsigned long>(size));
+    jpeg_read_header(&d->dinfo, TRUE);
+    d->dinfo.scale_num = 1;
+    d->dinfo.scale_denom = static_cast<unsigned int>(scaleDenom > 0 ? scaleDenom : 1);
+    d->dinfo.out_color_space = JCS_RGB;
+    d->dinfo.dct_method = JDCT_IFAST;
+    d->dinfo.do_fancy_upsampling = FALSE;
+    jpeg_start_decompress(&d->dinfo);
+    width = static_cast<int>(d->dinfo.output_width);
+    height = static_cast<int>(d->dinfo.output_height);
+    const size_t stride = static_cast<size_t>(width) * 3;
+    rgb.resize(stride * height);
+    while (d->dinfo.output_scanline < d->dinfo.output_height) {
+        JSAMPROW row[1] = { rgb.data() + stride * d->dinfo.output_scanline };
+        jpeg_read_scanlines(&d->dinfo, row, 1);
+    }
+    jpeg_finish_decompress(&d->dinfo);
+    return true;
+}
+
+bool JpegFrameCodec::encode(const unsigned char* rgb, int width, int height, int quality, std::vector<unsigned char>& out) {
+    Impl* d = impl.get();
+    if (width <= 0 || height <= 0) return false;
+    if (!d->encoderCreated) {
+        d->cinfo.err = jpeg_std_error(&d->cerr.pub);
+        d->cerr.pub.error_exit = jpegErrorExit;
+        d->cerr.pub.output_message = jpegSilentOutput;
+        if (setjmp(d->cerr.setjmpBuffer)) {
+            return false;
+        }
+        jpeg_create_compress(&d->cinfo);
+        d->encoderCreated = true;
+        d->dest.pub.init_destination = vectorInitDestination;
+        d->dest.pub.empty_output_buffer = vectorEmptyOutputBuffer;
+        d->dest.pub.term_destination = vectorTermDestination;
+        d->cinfo.dest = &d->dest.pub;
+    }
+    if (setjmp(d->cerr.setjmpBuffer)) {
+        jpeg_abort_compress(&d->cinfo);
+        return false;
+    }
+    d->dest.out = &out;
+    d->cinfo.image_width = static_cast<JDIMENSION>(width);
+    d->cinfo.image_height = static_cast<JDIMENSION>(height);
+    d->cinfo.input_components = 3;
+    d->cinfo.in_color_space = JCS_RGB;
+    // Tabel komponen & kuantisasi dialokasikan sekali di pool permanen, di sini hanya diisi ulang
+    jpeg_set_defaults(&d->cinfo);
+    jpeg_set_quality(&d->cinfo, quality, TRUE);
+    d->cinfo.dct_method = JDCT_IFAST;
+    jpeg_start_compress(&d->cinfo, TRUE);
+    const size_t stride = static_cast<size_t>(width) * 3;
+    d->rows.resize(height);
+    for (int y = 0; y < height; ++y) d->rows[y] = const_cast<unsigned char*>(rgb) + stride * y;
+    while (d->cinfo.next_scanline < d->cinfo.image_height) {
+        jpeg_write_scanlines(&d->cinfo, d->rows.data() + d->cinfo.next_scanline,
+                             d->cinfo.image_height - d->cinfo.next_scanline);
+    }
+    jpeg_finish_compress(&d->cinfo);
+    return true;
+}
@@ -0,0 +1,397 @@
+#include "../include/jpeg_transform.h"
+#include "../include/jpeg_codec.h"
+#include <algorithm>
+#include <csetjmp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <jpeglib.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+struct TransformErrorManager {
+    jpeg_error_mgr pub;
+    jmp_buf setjmpBuffer;
+};
+
+void transformErrorExit(j_common_ptr cinfo) {
+    TransformErrorManager* err = reinterpret_cast<TransformErrorManager*>(cinfo->err);
+    char msg[JMSG_LENGTH_MAX];
+    (*cinfo->err->format_message)(cinfo, msg);
+    std::cerr << "❌ libjpeg transform error: " << msg << std::endl;
+    longjmp(err->setjmpBuffer, 1);
+}
+
+void transformSilentOutput(j_common_ptr) {}
+
+// State di heap supaya tetap valid setelah longjmp; dibersihkan oleh destruktor
+struct Session {
+    jpeg_decompress_struct src;
+    jpeg_compress_struct dst;
+    TransformErrorManager jerr;
+    bool srcCreated = false;
+    bool dstCreated = false;
+    unsigned char* buffer = nullptr;
+    unsigned long bufferSize = 0;
+
+    ~Session() {
+        if (dstCreated) jpeg_destroy_compress(&dst);
+        if (srcCreated) jpeg_destroy_decompress(&src);
+        free(buffer);
+    }
+};
+
+// Blok output (ox, oy) diambil dari blok lokal sumber (oy, ox) bila transpose, lalu dibalik di
+// ruang sumber. Mirror diterapkan ke sumber sebelum rotasi, jadi cukup meng-XOR flipX
+struct Orientation {
+    bool transpose = false;
+    bool flipX = false;
+    bool flipY = false;
+
+    bool any() const { return transpose || flipX || flipY; }
+};
+
+Orientation orientationOf(bool mirror, int rotate) {
+    Orientation o;
+    if (rotate == 90) {
+        o.transpose = true;
+        o.flipY = true;
+    } else if (rotate == 180) {
+        o.flipX = true;
+        o.flipY = true;
+    } else if (rotate == 270) {
+        o.transpose = true;
+        o.flipX = true;
+    }
+    o.flipX = o.flipX != mirror;
+    return o;
+}
+
+// JBLOCK dalam urutan natural (baris = frekuensi vertikal). Membalik sumbu x menegasikan
+// koefisien dengan frekuensi horizontal ganjil; transpose menukar indeks baris/kolom.
+// Dihitung sekali per transformasi: out[i] = ±in[index[i]], negate 0 / -1 per koefisien
+struct BlockMap {
+    bool transpose = false;
+    unsigned char index[DCTSIZE2];
+    JCOEF negate[DCTSIZE2];
+};
+
+BlockMap blockMapOf(const Orientation& o) {
+    BlockMap map;
+    map.transpose = o.transpose;
+    for (int v = 0; v < DCTSIZE; ++v) {
+        for (int u = 0; u < DCTSIZE; ++u) {
+            const int su = o.transpose ? v : u;
+            const int sv = o.transpose ? u : v;
+            map.index[v * DCTSIZE + u] = static_cast<unsigned char>(sv * DCTSIZE + su);
+            map.negate[v * DCTSIZE + u] = (o.flipX && (su & 1)) != (o.flipY && (sv & 1)) ? -1 : 0;
+        }
+    }
+    return map;
+}
+
+// (x ^ m) - m = -x untuk m = -1, x untuk m = 0. in == out boleh
+void transformBlock(const JCOEF* in, JCOEF* out, const BlockMap& map) {
+    if (map.transpose) {
+        JBLOCK block;
+        std::memcpy(block, in, sizeof(JBLOCK));
+        for (int i = 0; i < DCTSIZE2; ++i) {
+            out[i] = static_cast<JCOEF>((block[map.index[i]] ^ map.negate[i]) - map.negate[i]);
+        }
+        return;
+    }
+#ifdef __SSE2__
+    for (int i = 0; i < DCTSIZE2; i += 8) {
+        const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(map.negate + i));
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_sub_epi16(_mm_xor_si128(v, m), m));
+    }
+#else
+    for (int i = 0; i < DCTSIZE2; ++i) out[i] = static_cast<JCOEF>((in[i] ^ map.negate[i]) - map.negate[i]);
+#endif
+}
+
+int divRoundUp(long a, long b) {
+    return static_cast<int>((a + b - 1) / b);
+}
+
+int roundUp(int a, int b) {
+    return divRoundUp(a, b) * b;
+}
+
+JBLOCKROW blockRow(j_common_ptr cinfo, jvirt_barray_ptr array, int row, bool writable) {
+    return (*cinfo->mem->access_virt_barray)(cinfo, array, static_cast<JDIMENSION>(row), 1, writable ? TRUE : FALSE)[0];
+}
+
+// Tanpa transpose grid blok tidak berubah: area crop digeser ke (0, 0) lalu dibalik di array
+// sumber sendiri, tanpa array kedua. Array libjpeg-turbo selalu resident (jmemnobs, tanpa backing
+// store), jadi dua baris boleh dipegang bersamaan
+const int kTransposeRows = 16;
+
+void reorientInPlace(j_common_ptr cinfo, jvirt_barray_ptr array, int bx0, int by0, int regionBW, int regionBH,
+                     const Orientation& o, const BlockMap& map) {
+    if (bx0 > 0 || by0 > 0) {
+        for (int y = 0; y < regionBH; ++y) {
+            JBLOCKROW from = blockRow(cinfo, array, by0 + y, false);
+            JBLOCKROW to = blockRow(cinfo, array, y, true);
+            std::memmove(to, from + bx0, sizeof(JBLOCK) * regionBW);
+        }
+    }
+    if (!o.flipX && !o.flipY) return;
+    std::vector<JBLOCK> saved(regionBW);
+    const int rows = o.flipY ? (regionBH + 1) / 2 : regionBH;
+    for (int y = 0; y < rows; ++y) {
+        JBLOCKROW top = blockRow(cinfo, array, y, true);
+        JBLOCKROW bottom = o.flipY ? blockRow(cinfo, array, regionBH - 1 - y, true) : top;
+        std::memcpy(saved.data(), top, sizeof(JBLOCK) * regionBW);
+        const JBLOCK* from = bottom == top ? saved.data() : bottom;
+        for (int x = 0; x < regionBW; ++x) transformBlock(from[o.flipX ? regionBW - 1 - x : x], top[x], map);
+        if (bottom == top) continue;
+        for (int x = 0; x < regionBW; ++x) transformBlock(saved[o.flipX ? regionBW - 1 - x : x], bottom[x], map);
+    }
+}
+
+// Sel cellW x cellH blok diisi rata-rata DC-nya, AC dinolkan: tiap sel jadi satu warna rata
+void pixelateComponent(j_common_ptr cinfo, jvirt_barray_ptr array, int widthBlocks, int heightBlocks,
+                       int cellW, int cellH) {
+    const int cellsX = divRoundUp(widthBlocks, cellW);
+    std::vector<long> sums(cellsX);
+    std::vector<int> counts(cellsX);
+    for (int y0 = 0; y0 < heightBlocks; y0 += cellH) {
+        const int y1 = std::min(heightBlocks, y0 + cellH);
+        std::fill(sums.begin(), sums.end(), 0);
+        std::fill(counts.begin(), counts.end(), 0);
+        for (int y = y0; y < y1; ++y) {
+            JBLOCKROW row = blockRow(cinfo, array, y, false);
+            for (int x = 0; x < widthBlocks; ++x) {
+                sums[x / cellW] += row[x][0];
+                ++counts[x / cellW];
+            }
+        }
+        for (int i = 0; i < cellsX; ++i) {
+            const long half = counts[i] / 2;
+            sums[i] = sums[i] >= 0 ? (sums[i] + half) / counts[i] : -((-sums[i] + half) / counts[i]);
+        }
+        for (int y = y0; y < y1; ++y) {
+            JBLOCKROW row = blockRow(cinfo, array, y, true);
+            for (int x = 0; x < widthBlocks; ++x) {
+                std::memset(row[x], 0, sizeof(JBLOCK));
+                row[x][0] = static_cast<JCOEF>(sums[x / cellW]);
+            }
+        }
+    }
+}
+
+}
+
+bool JpegCoefTransform::identity() const {
+    return !grayscale && !mirror && rotate % 360 == 0 && !(cropWidth > 0 && cropHeight > 0) && pixelate <= 0;
+}
+
+JpegCoefTransform JpegCoefTransform::fromExifOrientation(int orientation) {
+    JpegCoefTransform t;
+    switch (orientation) {
+        case 2: t.mirror = true; break;
+        case 3: t.rotate = 180; break;
+        case 4: t.mirror = true; t.rotate = 180; break;   // flip vertikal
+        case 5: t.mirror = true; t.rotate = 270; break;   // transpose
+        case 6: t.rotate = 90; break;
+        case 7: t.mirror = true; t.rotate = 90; break;    // transverse
+        case 8: t.rotate = 270; break;
+        default: break;
+    }
+    return t;
+}
+
+int jpegExifOrientation(const unsigned char* data, size_t size) {
+    if (!isJpegData(data, size)) return 1;
+    size_t pos = 2;
+    while (pos + 4 <= size && data[pos] == 0xFF) {
+        const unsigned char marker = data[pos + 1];
+        if (marker == 0xFF) {  // fill byte
+            ++pos;
+            continue;
+        }
+        if (marker == 0xDA || marker == 0xD9) break;
+        const size_t length = (static_cast<size_t>(data[pos + 2]) << 8) | data[pos + 3];
+        if (length < 2 || pos + 2 + length > size) break;
+        const unsigned char* seg = data + pos + 4;
+        const size_t segLength = length - 2;
+        if (marker == 0xE1 && segLength >= 14 && std::memcmp(seg, "Exif\0\0", 6) == 0) {
+            const unsigned char* tiff = seg + 6;
+            const size_t tiffLength = segLength - 6;
+            const bool little = tiff[0] == 'I' && tiff[1] == 'I';
+            if (!little && !(tiff[0] == 'M' && tiff[1] == 'M')) return 1;
+            auto u16 = [&](size_t o) -> unsigned {
+                return little ? tiff[o] | (tiff[o + 1] << 8) : (tiff[o] << 8) | tiff[o + 1];
+            };
+            auto u32 = [&](size_t o) -> size_t {
+                return little ? static_cast<size_t>(u16(o)) | (static_cast<size_t>(u16(o + 2)) << 16)
+                              : (static_cast<size_t>(u16(o)) << 16) | u16(o + 2);
+            };
+            if (u16(2) != 42) return 1;
+            const size_t ifd = u32(4);
+            if (ifd + 2 > tiffLength) return 1;
+            const unsigned entries = u16(ifd);
+            for (unsigned i = 0; i < entries; ++i) {
+                const size_t e = ifd + 2 + static_cast<size_t>(i) * 12;
+                if (e + 12 > tiffLength) break;
+                if (u16(e) == 0x0112) {
+                    const unsigned value = u16(e + 8);
+                    return u16(e + 2) == 3 && value >= 1 && value <= 8 ? static_cast<int>(value) : 1;
+                }
+            }
+            return 1;
+        }
+        pos += 2 + length;
+    }
+    return 1;
+}
+
+bool jpegTransformCoefficients(const unsigned char* data, size_t size, const JpegCoefTransform& transform,
+                               std::vector<unsigned char>& out, int* outWidth, int* outHeight) {
+    out.clear();
+    if (!isJpegData(data, size) || transform.rotate % 90 != 0) return false;
+
+    std::unique_ptr<Session> s(new Session());
+    s->src.err = jpeg_std_error(&s->jerr.pub);
+    s->dst.err = &s->jerr.pub;
+    s->jerr.pub.error_exit = transformErrorExit;
+    s->jerr.pub.output_message = transformSilentOutput;
+    if (setjmp(s->jerr.setjmpBuffer)) {
+        out.clear();
+        return false;
+    }
+    jpeg_create_decompress(&s->src);
+    s->srcCreated = true;
+    jpeg_mem_src(&s->src, const_cast<unsigned char*>(data), static_cast<unsigned long>(size));
+    jpeg_read_header(&s->src, TRUE);
+    j_common_ptr srcCommon = reinterpret_cast<j_common_ptr>(&s->src);
+
+    const int width = static_cast<int>(s->src.image_width);
+    const int height = static_cast<int>(s->src.image_height);
+    const int mcuW = s->src.max_h_samp_factor * DCTSIZE;
+    const int mcuH = s->src.max_v_samp_factor * DCTSIZE;
+    const Orientation o = orientationOf(transform.mirror, ((transform.rotate % 360) + 360) % 360);
+
+    // Area sumber: crop mulai di batas iMCU, sumbu yang dibalik dipangkas ke iMCU penuh
+    int x0 = 0, y0 = 0, regionW = width, regionH = height;
+    if (transform.cropWidth > 0 && transform.cropHeight > 0) {
+        const int cx = std::min(std::max(transform.cropX, 0), width - 1);
+        const int cy = std::min(std::max(transform.cropY, 0), height - 1);
+        x0 = cx / mcuW * mcuW;
+        y0 = cy / mcuH * mcuH;
+        regionW = std::min(width, cx + transform.cropWidth) - x0;
+        regionH = std::min(height, cy + transform.cropHeight) - y0;
+    }
+    if (o.flipX) regionW = regionW / mcuW * mcuW;
+    if (o.flipY) regionH = regionH / mcuH * mcuH;
+    if (regionW <= 0 || regionH <= 0) return false;
+
+    // Grayscale hanya untuk YCbCr dengan luma di sampling penuh (4:2:0, 4:2:2, 4:4:4); CMYK/YCCK
+    // ditolak supaya pemanggil jatuh ke jalur piksel
+    const int components = s->src.num_components;
+    const bool dropChroma = transform.grayscale && s->src.jpeg_color_space == JCS_YCbCr && components == 3;
+    if (transform.grayscale && !dropChroma && s->src.jpeg_color_space != JCS_GRAYSCALE) return false;
+    if (dropChroma && (s->src.comp_info[0].h_samp_factor != s->src.max_h_samp_factor ||
+                       s->src.comp_info[0].v_samp_factor != s->src.max_v_samp_factor)) {
+        return false;
+    }
+    const int outComponents = dropChroma ? 1 : components;
+    const int outW = o.transpose ? regionH : regionW;
+    const int outH = o.transpose ? regionW : regionH;
+    // Hanya rotasi 90/270 yang butuh array tujuan sendiri (dimensi blok tertukar)
+    const bool inPlace = !o.transpose;
+
+    int hOut[MAX_COMPONENTS], vOut[MAX_COMPONENTS], maxH = 1, maxV = 1;
+    for (int c = 0; c < outComponents; ++c) {
+        const jpeg_component_info& comp = s->src.comp_info[c];
+        hOut[c] = dropChroma ? 1 : (o.transpose ? comp.v_samp_factor : comp.h_samp_factor);
+        vOut[c] = dropChroma ? 1 : (o.transpose ? comp.h_samp_factor : comp.v_samp_factor);
+        maxH = std::max(maxH, hOut[c]);
+        maxV = std::max(maxV, vOut[c]);
+    }
+    int widthBlocks[MAX_COMPONENTS], heightBlocks[MAX_COMPONENTS];
+    jvirt_barray_ptr dstArrays[MAX_COMPONENTS];
+    for (int c = 0; c < outComponents; ++c) {
+        widthBlocks[c] = divRoundUp(static_cast<long>(outW) * hOut[c], maxH * DCTSIZE);
+        heightBlocks[c] = divRoundUp(static_cast<long>(outH) * vOut[c], maxV * DCTSIZE);
+        // Diminta lewat memory manager decompressor sebelum jpeg_read_coefficients, jadi ikut
+        // direalisasi di sana dan hidup sampai jpeg_finish_decompress
+        if (!inPlace) {
+            dstArrays[c] = (*s->src.mem->request_virt_barray)(
+                srcCommon, JPOOL_IMAGE, TRUE, static_cast<JDIMENSION>(roundUp(widthBlocks[c], hOut[c])),
+                static_cast<JDIMENSION>(roundUp(heightBlocks[c], vOut[c])), static_cast<JDIMENSION>(vOut[c]));
+        }
+    }
+
+    jvirt_barray_ptr* srcArrays = jpeg_read_coefficients(&s->src);
+    const BlockMap map = blockMapOf(o);
+    for (int c = 0; c < outComponents; ++c) {
+        const jpeg_component_info& comp = s->src.comp_info[c];
+        const int bx0 = x0 / mcuW * comp.h_samp_factor;
+        const int by0 = y0 / mcuH * comp.v_samp_factor;
+        const int regionBW = divRoundUp(static_cast<long>(regionW) * comp.h_samp_factor, mcuW);
+        const int regionBH = divRoundUp(static_cast<long>(regionH) * comp.v_samp_factor, mcuH);
+        if (inPlace) {
+            reorientInPlace(srcCommon, srcArrays[c], bx0, by0, regionBW, regionBH, o, map);
+            dstArrays[c] = srcArrays[c];
+            continue;
+        }
+        // Transpose per pita kTransposeRows baris output: tiap baris sumber menyumbang satu
+        // potongan blok yang berurutan, bukan satu blok per baris
+        JBLOCKROW dstRows[kTransposeRows];
+        for (int oy0 = 0; oy0 < heightBlocks[c]; oy0 += kTransposeRows) {
+            const int rows = std::min(kTransposeRows, heightBlocks[c] - oy0);
+            for (int k = 0; k < rows; ++k) dstRows[k] = blockRow(srcCommon, dstArrays[c], oy0 + k, true);
+            for (int ox = 0; ox < widthBlocks[c]; ++ox) {
+                const int ly = o.flipY ? regionBH - 1 - ox : ox;
+                JBLOCKROW srcRow = blockRow(srcCommon, srcArrays[c], by0 + ly, false) + bx0;
+                for (int k = 0; k < rows; ++k) {
+                    const int lx = o.flipX ? regionBW - 1 - (oy0 + k) : oy0 + k;
+                    transformBlock(srcRow[lx], dstRows[k][ox], map);
+                }
+            }
+        }
+    }
+
+    if (transform.pixelate > 0) {
+        const int cellsX = std::max(1, (transform.pixelate + maxH * DCTSIZE / 2) / (maxH * DCTSIZE));
+        const int cellsY = std::max(1, (transform.pixelate + maxV * DCTSIZE / 2) / (maxV * DCTSIZE));
+        for (int c = 0; c < outComponents; ++c) {
+            pixelateComponent(srcCommon, dstArrays[c], widthBlocks[c], heightBlocks[c], cellsX * hOut[c], cellsY * vOut[c]);
+        }
+    }
+
+    jpeg_create_compress(&s->dst);
+    s->dstCreated = true;
+    jpeg_copy_critical_parameters(&s->src, &s->dst);
+    if (dropChroma) {
+        const int quantTable = s->dst.comp_info[0].quant_tbl_no;
+        jpeg_set_colorspace(&s->dst, JCS_GRAYSCALE);
+        s->dst.comp_info[0].quant_tbl_no = quantTable;
+    }
+    s->dst.image_width = static_cast<JDIMENSION>(outW);
+    s->dst.image_height = static_cast<JDIMENSION>(outH);
+    for (int c = 0; c < outComponents; ++c) {
+        s->dst.comp_info[c].h_samp_factor = hOut[c];
+        s->dst.comp_info[c].v_samp_factor = vOut[c];
+    }
+    s->dst.restart_in_rows = 1;
+    jpeg_mem_dest(&s->dst, &s->buffer, &s->bufferSize);
+    jpeg_write_coefficients(&s->dst, dstArrays);
+    jpeg_finish_compress(&s->dst);
+    // dstArrays milik pool decompressor: baru boleh dilepas setelah encode selesai
+    jpeg_finish_decompress(&s->src);
+
+    out.assign(s->buffer, s->buffer + s->bufferSize);
+    if (outWidth) *outWidth = outW;
+    if (outHeight) *outHeight = outH;
+    return true;
+}
@@ -0,0 +1,163 @@
+// live_view.cpp - Efek pada live view MJPEG dengan anggaran waktu per frame
+
+#include "../include/server.h"
+#include "../include/jpeg_codec.h"
+#include "../include/jpeg_transform.h"
+#include <cmath>
+
+namespace {
+
+const int kLiveQuality = 80;
+const double kMinBudgetMs = 15.0;
+const double kMaxBudgetMs = 100.0;
+const double kDefaultBudgetMs = 33.0;   // ~30 fps sebelum interval kamera terukur
+
+double millisecondsBetween(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+    return std::chrono::duration<double, std::milli>(to - from).count();
+}
+
+void mirrorRows(ImageData& image) {
+    for (int y = 0; y < image.height; y++) {
+        unsigned char* left = image.data.data() + static_cast<size_t>(y) * image.width * 3;
+        unsigned char* right = left + static_cast<size_t>(image.width - 1) * 3;
+        for (; left < right; left += 3, right -= 3) {
+            std::swap(left[0], right[0]);
+            std::swap(left[1], right[1]);
+            std::swap(left[2], right[2]);
+        }
+    }
+}
+
+} // namespace
+
+LiveViewRenderer::LiveViewRenderer(const ImageEffects& effects)
+    : effects(effects), codec(new JpegFrameCodec()), scaleDenom(1), pixelMs(0.0),
+      frameIntervalMs(0.0), overBudgetFrames(0), budgetOverrideMs(0.0) {
+    image.width = 0;
+    image.height = 0;
+}
+
+LiveViewRenderer::~LiveViewRenderer() {}
+
+void LiveViewRenderer::setBudgetMs(double ms) {
+    budgetOverrideMs = std::max(0.0, ms);
+}
+
+LiveViewRenderer::Stats LiveViewRenderer::stats() const {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    return current;
+}
+
+double LiveViewRenderer::currentBudgetMs() const {
+    const double fixedMs = budgetOverrideMs;
+    if (fixedMs > 0.0) return fixedMs;
+    if (frameIntervalMs <= 0.0) return kDefaultBudgetMs;
+    return std::max(kMinBudgetMs, std::min(kMaxBudgetMs, frameIntervalMs));
+}
+
+void LiveViewRenderer::noteDropped(uint64_t count) {
+    if (count == 0) return;
+    std::lock_guard<std::mutex> lock(statsMutex);
+    current.dropped += count;
+}
+
+bool LiveViewRenderer::render(const std::vector<unsigned char>& frame, std::chrono::steady_clock::time_point arrival,
+                              std::vector<unsigned char>& out) {
+    if (lastArrival != std::chrono::steady_clock::time_point()) {
+        const double interval = millisecondsBetween(lastArrival, arrival);
+        if (interval > 0.0 && interval < 1000.0) {
+            frameIntervalMs = frameIntervalMs > 0.0 ? frameIntervalMs * 0.9 + interval * 0.1 : interval;
+        }
+    }
+    lastArrival = arrival;
+    const double budget = currentBudgetMs();
+
+    const auto pipeline = effects.getPipeline();
+    const bool mirror = effects.isMirrored();
+    if ((!pipeline || pipeline->empty()) && !mirror) {
+        out = frame;
+        std::lock_guard<std::mutex> lock(statsMutex);
+        current.frames++;
+        current.passthrough++;
+        current.budgetMs = budget;
+        return true;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Mirror, grayscale penuh dan pixelate cukup di koefisien DCT: biayanya kecil dan tetap
+    bool done = false;
+    int width = 0, height = 0;
+    JpegCoefTransform transform;
+    transform.mirror = mirror;
+    if (jpegReadDimensions(frame.data(), frame.size(), width, height) &&
+        (!pipeline || pipeline->coefficientTransform(width, height, transform))) {
+        done = jpegTransformCoefficients(frame.data(), frame.size(), transform, out);
+    }
+
+    bool pixelPath = false;
+    if (!done) {
+        // Di skala terkecil pun masih lewat anggaran: hanya setiap frame ke-N yang diberi efek
+        // (N = perkiraan biaya / anggaran), sisanya dibuang. Setiap frame yang dirender memperbarui
+        // pixelMs, jadi begitu muat lagi di anggaran semua frame kembali dirender
+        if (scaleDenom == kMaxScaleDenom && pixelMs > budget) {
+            const unsigned stride = static_cast<unsigned>(std::ceil(pixelMs / budget));
+            if (++overBudgetFrames % stride != 0) {
+                std::lock_guard<std::mutex> lock(statsMutex);
+                current.dropped++;
+                current.budgetMs = budget;
+                return false;
+            }
+        }
+        overBudgetFrames = 0;
+        pixelPath = true;
+        done = renderPixels(frame, pipeline.get(), mirror, out);
+    }
+    if (!done) {
+        out = frame;
+    }
+
+    const double elapsed = millisecondsBetween(start, std::chrono::steady_clock::now());
+    if (pixelPath && done) {
+        pixelMs = pixelMs > 0.0 ? pixelMs * 0.8 + elapsed * 0.2 : elapsed;
+        // Skala turun setengah = ~1/4 biaya decode, efek dan encode. Naik lagi hanya bila
+        // perkiraan biaya pada skala lebih besar masih muat di anggaran (histeresis)
+        if (pixelMs > budget && scaleDenom < kMaxScaleDenom) {
+            scaleDenom *= 2;
+            pixelMs /= 4.0;
+        } else if (pixelMs * 4.0 < budget * 0.8 && scaleDenom > 1) {
+            scaleDenom /= 2;
+            pixelMs *= 4.0;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    current.frames++;
+    if (!done) current.passthrough++;
+    current.avgMs = current.avgMs > 0.0 ? current.avgMs * 0.8 + elapsed * 0.2 : elapsed;
+    current.scaleDenom = scaleDenom;
+    current.budgetMs = budget;
+    return true;
+}
+
+bool LiveViewRenderer::renderPixels(const std::vector<unsigned char>& frame, const EffectPipeline* pipeline,
+                                    bool mirror, std::vector<unsigned char>& out) {
+    if (!codec->decode(frame.data(), frame.size(), scaleDenom, image.data, image.width, image.height)) {
+        return false;
+    }
+    if (mirror) {
+        mirrorRows(image);
+    }
+    if (pipeline) {
+        // Radius blur dan blok pixelate mengikuti ukuran frame asli, bukan frame yang diperkecil
+        const double sizeScale =
+            ImageEffects::previewScale(image.width * scaleDenom, image.height * scaleDenom) / scaleDenom;
+        pipeline->run(image, sizeScale);
+    }
+    std::vector<unsigned char> encoded;
+    if (!codec->encode(image.data.data(), image.width, image.height, kLiveQuality, encoded)) {
+        return false;
+    }
+    out.swap(encoded);
+    return true;
+}
@@ -1,7 +1,8 @@
 #include "../include/server.h"
 
 MJPEGServer::MJPEGServer(int port) 
-    : port(port), isStreaming(false), serverSocket(-1), streamProcessPid(-1), stdoutFd(-1), stderrFd(-1) {
+    : port(port), isStreaming(false), liveView(new LiveViewRenderer(effects)), serverSocket(-1), streamProcessPid(-1),
+      stdoutFd(-1), stderrFd(-1) {
     frameBuffer.reserve(1024 * 512);
 }
 
@@ -122,7 +123,9 @@ std::tuple<bool, std::string, std::string> MJPEGServer::startStream() {
         const unsigned char startMarker[2] = {0xFF, 0xD8};
         const unsigned char endMarker[2] = {0xFF, 0xD9};
         std::vector<unsigned char> readBuf(64 * 1024);
-        int frameCount = 0;
+        std::vector<unsigned char> frame;
+        std::vector<unsigned char> processedFrame;
+        uint64_t frameCount = 0;
         while (isStreaming && stdoutFd != -1) {
             ssize_t n = read(stdoutFd, readBuf.data(), readBuf.size());
             if (n > 0) {
@@ -130,59 +133,39 @@ std::tuple<bool, std::string, std::string> MJPEGServer::startStream() {
                 if (frameBuffer.size() > 1024 * 1024) {
                     frameBuffer.erase(frameBuffer.begin(), frameBuffer.end() - (1024 * 512));
                 }
-                for (;;) {
-                    auto itStart = std::search(frameBuffer.begin(), frameBuffer.end(), startMarker, startMarker + 2);
+                // Hanya frame lengkap terbaru yang diproses; frame lebih lama di buffer sudah basi
+                auto frameStart = frameBuffer.end();
+                auto frameEnd = frameBuffer.end();
+                int completeFrames = 0;
+                for (auto it = frameBuffer.begin();;) {
+                    auto itStart = std::search(it, frameBuffer.end(), startMarker, startMarker + 2);
                     if (itStart == frameBuffer.end()) break;
                     auto itEnd = std::search(itStart + 2, frameBuffer.end(), endMarker, endMarker + 2);
                     if (itEnd == frameBuffer.end()) break;
-                    std::vector<unsigned char> frame(itStart, itEnd + 2);
-                    std::vector<unsigned char> processedFrame = effects.applyEffect(frame);
-                    
-                    // Log frame processing
-                    if (frameCount % 30 == 0) {
-                        auto currentEffect = effects.getEffect();
-                        std::cout << "📹 Processing frame " << frameCount
-                                  << " | Original size: " << frame.size()
-                                  << " | Processed size: " << processedFrame.size()
-                                  << " | Current effect: ";
-                        switch (currentEffect.first) {
-                            case EffectType::NONE:
-                                std::cout << "NONE";
-                                break;
-                            case EffectType::FISHEYE:
-                                std::cout << "FISHEYE";
-                                break;
-                            case EffectType::GRAYSCALE:
-                                std::cout << "GRAYSCALE";
-                                break;
-                            case EffectType::SEPIA:
-                                std::cout << "SEPIA";
-                                break;
-                            case EffectType::VIGNETTE:
-                                std::cout << "VIGNETTE";
-                                break;
-                            case EffectType::BLUR:
-                                std::cout << "BLUR";
-                                break;
-                            case EffectType::SHARPEN:
-                                std::cout << "SHARPEN";
-                                break;
-                            case EffectType::INVERT:
-                                std::cout << "INVERT";
-                                break;
-                            case EffectType::PIXELATE:
-                                std::cout << "PIXELATE";
-                                break;
-                            default:
-                                std::cout << "UNKNOWN";
-                                break;
-                        }
-                        std::cout << std::endl;
-                    }
-                    
-                    sendFrameToClients(processedFrame);
-                    frameBuffer.erase(frameBuffer.begin(), itEnd + 2);
-                    frameCount++;
+                    frameStart = itStart;
+                    frameEnd = itEnd + 2;
+                    completeFrames++;
+                    it = frameEnd;
+                }
+                if (completeFrames == 0) continue;
+                const auto arrival = std::chrono::steady_clock::now();
+                frame.assign(frameStart, frameEnd);
+                frameBuffer.erase(frameBuffer.begin(), frameEnd);
+                
+                // Tanpa penonton tidak ada yang perlu di-decode/encode
+                if (getClientCount() == 0) continue;
+                liveView->noteDropped(completeFrames - 1);
+                if (!liveView->render(frame, arrival, processedFrame)) continue;
+                // Satu encode untuk semua penonton
+                sendFrameToClients(processedFrame);
+                
+                if (++frameCount % 30 == 0) {
+                    const LiveViewRenderer::Stats stats = liveView->stats();
+                    std::cout << "📹 Live view: " << frameCount << " frames | effects: " << describeEffects()
+                              << " | " << std::fixed << std::setprecision(1) << stats.avgMs << " ms/frame (budget "
+                              << stats.budgetMs << " ms) | scale 1/" << stats.scaleDenom
+                              << " | dropped " << stats.dropped
+                              << std::defaultfloat << std::endl;
                 }
             } else {
                 std::this_thread::sleep_for(std::chrono::milliseconds(10));
@@ -281,6 +264,34 @@ std::pair<EffectType, EffectParams> MJPEGServer::getCurrentEffect() const {
     return effects.getEffect();
 }
 
+void MJPEGServer::setEffects(const std::vector<EffectStep>& steps) {
+    effects.setEffects(steps);
+    std::cout << "✅ MJPEG effects set: " << describeEffects() << std::endl;
+}
+
+std::vector<EffectStep> MJPEGServer::getEffects() const {
+    return effects.getEffects();
+}
+
+std::string MJPEGServer::describeEffects() const {
+    const auto pipeline = effects.getPipeline();
+    return pipeline && !pipeline->empty() ? pipeline->describe() : "none";
+}
+
+void MJPEGServer::setFrameBudget(double ms) {
+    liveView->setBudgetMs(ms);
+    std::cout << "⏱️ MJPEG frame budget: " << (ms > 0 ? std::to_string(static_cast<int>(ms)) + " ms" : "auto") << std::endl;
+}
+
+void MJPEGServer::setMirror(bool enabled) {
+    effects.setMirror(enabled);
+    std::cout << "🪞 MJPEG mirror: " << (enabled ? "ON" : "OFF") << std::endl;
+}
+
+bool MJPEGServer::isMirrored() const {
+    return effects.isMirrored();
+}
+
 void MJPEGServer::setupRoutes() {
     std::cout << "🌐 MJPEG server setupRoutes started, waiting for connections on port " << port << std::endl;
     while (serverSocket != -1) {
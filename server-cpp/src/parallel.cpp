@@ -0,0 +1,30 @@
+#include "../include/parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+unsigned parallelThreads() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+void parallelFor(size_t count, const std::function<void(size_t)>& fn, unsigned maxThreads) {
+    if (count == 0) return;
+    unsigned threads = maxThreads == 0 ? parallelThreads() : maxThreads;
+    threads = static_cast<unsigned>(std::min<size_t>(threads, count));
+    if (threads <= 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+    // Indeks dibagikan dinamis supaya item yang lebih berat tidak menahan thread lain
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < count; i = next++) fn(i);
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+}
@@ -0,0 +1,533 @@
+#include "../include/photo_catalog.h"
+#include <algorithm>
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
+namespace {
+
+bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() > suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// photo_<ms>.jpg dari GPhotoWrapper::captureImage; nama lain memakai mtime
+int64_t timestampFromName(const std::string& filename, int64_t fallbackMs) {
+    if (filename.compare(0, 6, "photo_") != 0) return fallbackMs;
+    int64_t ts = 0;
+    size_t i = 6;
+    for (; i < filename.size() && i < 6 + 18 && filename[i] >= '0' && filename[i] <= '9'; ++i) {
+        ts = ts * 10 + (filename[i] - '0');
+    }
+    return (i > 6 && i < filename.size() && filename[i] == '.') ? ts : fallbackMs;
+}
+
+bool statPhoto(const std::string& dir, const std::string& filename, PhotoRecord& record) {
+    struct stat st;
+    if (stat((dir + "/" + filename).c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    record.filename = filename;
+    record.size = static_cast<uint64_t>(st.st_size);
+    record.mtime = static_cast<int64_t>(st.st_mtime);
+    record.timestamp = timestampFromName(filename, record.mtime * 1000);
+    return true;
+}
+
+// Transaksi untuk satu batch perubahan; dipegang selama caller memegang mu supaya thread lain
+// yang memakai koneksi yang sama tidak ikut masuk. Tanpa commit() yang berhasil di-rollback
+class CatalogTransaction {
+public:
+    explicit CatalogTransaction(sqlite3* db) : db(db) {
+        if (db && sqlite3_exec(db, "BEGIN", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            std::cerr << "❌ Failed to begin catalog transaction: " << sqlite3_errmsg(db) << std::endl;
+            this->db = nullptr;
+        }
+    }
+    ~CatalogTransaction() {
+        if (db) sqlite3_exec(db, "ROLLBACK", nullptr, nullptr, nullptr);
+    }
+    bool commit() {
+        if (!db) return true;
+        if (sqlite3_exec(db, "COMMIT", nullptr, nullptr, nullptr) != SQLITE_OK) {
+            std::cerr << "❌ Failed to commit catalog transaction: " << sqlite3_errmsg(db) << std::endl;
+            return false;
+        }
+        db = nullptr;
+        return true;
+    }
+private:
+    sqlite3* db;
+};
+
+}
+
+PhotoCatalog::PhotoCatalog()
+    : db(nullptr), currentVersion(0), tombstoneFloor(0), inotifyFd(-1), running(false) {
+    wakePipe[0] = wakePipe[1] = -1;
+}
+
+PhotoCatalog::~PhotoCatalog() {
+    stop();
+    if (db != nullptr) {
+        sqlite3_close(db);
+        db = nullptr;
+    }
+}
+
+bool PhotoCatalog::isPhotoName(const std::string& filename) {
+    if (filename.empty() || filename[0] == '.') return false;
+    // Nama dikirim apa adanya di JSON listing
+    for (char c : filename) {
+        if (c == '/' || c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20) return false;
+    }
+    return endsWith(filename, ".jpg") || endsWith(filename, ".jpeg");
+}
+
+bool PhotoCatalog::openDatabase(const std::string& path) {
+    if (sqlite3_open(path.c_str(), &db) != SQLITE_OK) {
+        std::cerr << "❌ Cannot open photo catalog: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_close(db);
+        db = nullptr;
+        return false;
+    }
+    const char* sql = "PRAGMA journal_mode = WAL;"
+                      "PRAGMA synchronous = NORMAL;"
+                      "CREATE TABLE IF NOT EXISTS photos ("
+                      "filename TEXT PRIMARY KEY,"
+                      "timestamp INTEGER NOT NULL,"
+                      "size INTEGER NOT NULL,"
+                      "mtime INTEGER NOT NULL,"
+                      "version INTEGER NOT NULL DEFAULT 0"
+                      ");"
+                      "CREATE TABLE IF NOT EXISTS photo_tombstones ("
+                      "filename TEXT PRIMARY KEY,"
+                      "version INTEGER NOT NULL"
+                      ");"
+                      "CREATE TABLE IF NOT EXISTS catalog_meta ("
+                      "key TEXT PRIMARY KEY,"
+                      "value INTEGER NOT NULL"
+                      ");";
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "❌ SQL error: " << (errMsg ? errMsg : "") << std::endl;
+        sqlite3_free(errMsg);
+        sqlite3_close(db);
+        db = nullptr;
+        return false;
+    }
+
+    // Katalog lama tanpa kolom version
+    bool hasVersion = false;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "PRAGMA table_info(photos)", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char* column = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
+            if (column && std::strcmp(column, "version") == 0) hasVersion = true;
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (!hasVersion && !execLocked("ALTER TABLE photos ADD COLUMN version INTEGER NOT NULL DEFAULT 0")) {
+        sqlite3_close(db);
+        db = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool PhotoCatalog::execLocked(const std::string& sql, const std::string& text, int64_t a, int64_t b) {
+    if (!db) return false;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "❌ Failed to prepare SQL: " << sqlite3_errmsg(db) << std::endl;
+        std::cerr << "❌ SQL statement: " << sql << std::endl;
+        return false;
+    }
+    // Parameter berurutan: ?1 teks, ?2 dan ?3 integer
+    const int params = sqlite3_bind_parameter_count(stmt);
+    if (params >= 1) sqlite3_bind_text(stmt, 1, text.c_str(), -1, SQLITE_TRANSIENT);
+    if (params >= 2) sqlite3_bind_int64(stmt, 2, a);
+    if (params >= 3) sqlite3_bind_int64(stmt, 3, b);
+    const int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    if (rc != SQLITE_DONE && rc != SQLITE_ROW) {
+        std::cerr << "❌ SQL execution error: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool PhotoCatalog::init(const std::string& dir, const std::string& dataDir) {
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        if (!photoDir.empty()) return true;
+        photoDir = dir;
+        // Tanpa DB katalog tetap jalan di memori, hanya tidak persist antar restart
+        if (openDatabase(dataDir + "/photo_catalog.db")) loadLocked();
+    }
+    reconcile();
+
+#ifdef __linux__
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd >= 0 && pipe(wakePipe) == 0 &&
+        inotify_add_watch(inotifyFd, photoDir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE) >= 0) {
+        running = true;
+        watcher = std::thread(&PhotoCatalog::watchLoop, this);
+    } else {
+        std::cerr << "⚠️ inotify unavailable for " << photoDir << ": " << strerror(errno) << std::endl;
+    }
+#endif
+
+    std::cout << "🗂️ Photo catalog: " << size() << " photos in " << photoDir << std::endl;
+    return true;
+}
+
+void PhotoCatalog::stop() {
+    if (running.exchange(false)) {
+        const char c = 0;
+        if (write(wakePipe[1], &c, 1) < 0) {
+            std::cerr << "⚠️ Failed to wake photo catalog watcher" << std::endl;
+        }
+    }
+    if (watcher.joinable()) watcher.join();
+    for (int* fd : {&inotifyFd, &wakePipe[0], &wakePipe[1]}) {
+        if (*fd >= 0) close(*fd);
+        *fd = -1;
+    }
+}
+
+void PhotoCatalog::loadLocked() {
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT filename, timestamp, size, mtime, version FROM photos", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            PhotoRecord record;
+            const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            if (!name) continue;
+            record.filename = name;
+            record.timestamp = sqlite3_column_int64(stmt, 1);
+            record.size = static_cast<uint64_t>(sqlite3_column_int64(stmt, 2));
+            record.mtime = sqlite3_column_int64(stmt, 3);
+            record.version = static_cast<uint64_t>(sqlite3_column_int64(stmt, 4));
+            putLocked(record);
+            currentVersion = std::max(currentVersion, record.version);
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (sqlite3_prepare_v2(db, "SELECT filename, version FROM photo_tombstones", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char* name = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            if (!name) continue;
+            const uint64_t version = static_cast<uint64_t>(sqlite3_column_int64(stmt, 1));
+            tombstones[version] = name;
+            tombstoneByName[name] = version;
+            currentVersion = std::max(currentVersion, version);
+        }
+        sqlite3_finalize(stmt);
+    }
+    if (sqlite3_prepare_v2(db, "SELECT key, value FROM catalog_meta", -1, &stmt, nullptr) == SQLITE_OK) {
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            const char* key = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
+            const uint64_t value = static_cast<uint64_t>(sqlite3_column_int64(stmt, 1));
+            if (!key) continue;
+            if (std::strcmp(key, "version") == 0) currentVersion = std::max(currentVersion, value);
+            if (std::strcmp(key, "tombstone_floor") == 0) tombstoneFloor = value;
+        }
+        sqlite3_finalize(stmt);
+    }
+}
+
+// Satu readdir saat startup (dan setelah IN_Q_OVERFLOW): foto yang masuk, hilang, atau diganti
+// selama server mati. Semua file di-stat di luar lock; perubahannya ditulis dalam satu transaksi
+void PhotoCatalog::reconcile() {
+    std::vector<PhotoRecord> onDisk;
+    if (DIR* d = opendir(photoDir.c_str())) {
+        while (struct dirent* e = readdir(d)) {
+            PhotoRecord record;
+            if (isPhotoName(e->d_name) && statPhoto(photoDir, e->d_name, record)) onDisk.push_back(record);
+        }
+        closedir(d);
+    }
+
+    PhotoDelta delta;
+    size_t changed = 0;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        CatalogTransaction tx(db);
+        bool persisted = true;
+        std::set<std::string> present;
+        for (const auto& record : onDisk) {
+            present.insert(record.filename);
+            auto it = byName.find(record.filename);
+            if (it != byName.end() && it->second.size == record.size && it->second.mtime == record.mtime) continue;
+            if (it != byName.end()) ++changed;
+            persisted = upsertLocked(record, delta) && persisted;
+        }
+        std::vector<std::string> missing;
+        for (const auto& entry : byName) {
+            if (!present.count(entry.first)) missing.push_back(entry.first);
+        }
+        for (const auto& name : missing) persisted = removeLocked(name, delta) && persisted;
+        if (delta.upserts.empty() && delta.deleted.empty()) return;
+        saveMetaLocked();
+        if (db && !(persisted && tx.commit())) {
+            // Memori tetap mengikuti disk; DB menyusul di rekonsiliasi berikutnya
+            std::cerr << "❌ Photo catalog reconcile rolled back" << std::endl;
+        }
+        delta.version = currentVersion;
+    }
+    std::sort(delta.upserts.begin(), delta.upserts.end(), [](const PhotoRecord& a, const PhotoRecord& b) {
+        return Newer()(TimeKey(a.timestamp, a.filename), TimeKey(b.timestamp, b.filename));
+    });
+    std::cout << "🗂️ Photo catalog reconciled: +" << (delta.upserts.size() - changed) << " ~" << changed
+              << " -" << delta.deleted.size() << std::endl;
+    notify(delta);
+}
+
+bool PhotoCatalog::add(const std::string& filename) {
+    PhotoRecord record;
+    if (!isPhotoName(filename) || !statPhoto(photoDir, filename, record)) return false;
+
+    PhotoDelta delta;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        auto it = byName.find(filename);
+        if (it != byName.end() && it->second.size == record.size && it->second.mtime == record.mtime) {
+            return true;
+        }
+        upsertLocked(record, delta);
+        saveMetaLocked();
+        delta.version = currentVersion;
+    }
+    notify(delta);
+    return true;
+}
+
+bool PhotoCatalog::remove(const std::string& filename) {
+    PhotoDelta delta;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        if (!byName.count(filename)) return false;
+        removeLocked(filename, delta);
+        saveMetaLocked();
+        delta.version = currentVersion;
+    }
+    notify(delta);
+    return true;
+}
+
+bool PhotoCatalog::upsertLocked(PhotoRecord record, PhotoDelta& delta) {
+    record.version = ++currentVersion;
+    dropTombstoneLocked(record.filename);
+    putLocked(record);
+    delta.upserts.push_back(record);
+    return persistLocked(record);
+}
+
+bool PhotoCatalog::removeLocked(const std::string& filename, PhotoDelta& delta) {
+    const uint64_t version = ++currentVersion;
+    eraseLocked(filename);
+    addTombstoneLocked(filename, version);
+    delta.deleted.push_back(filename);
+    return unpersistLocked(filename, version);
+}
+
+std::vector<PhotoRecord> PhotoCatalog::list(size_t limit) const {
+    std::lock_guard<std::mutex> lock(mu);
+    std::vector<PhotoRecord> out;
+    out.reserve(limit > 0 ? std::min(limit, byTime.size()) : byTime.size());
+    for (const auto& key : byTime) {
+        if (limit > 0 && out.size() >= limit) break;
+        out.push_back(byName.find(key.second)->second);
+    }
+    return out;
+}
+
+std::string PhotoCatalog::cursorFor(const PhotoRecord& record) {
+    return std::to_string(record.timestamp) + ":" + record.filename;
+}
+
+bool PhotoCatalog::page(const std::string& cursor, size_t limit, PhotoPage& out) const {
+    TimeKey after;
+    if (!cursor.empty()) {
+        const size_t colon = cursor.find(':');
+        if (colon == std::string::npos || colon == 0 || colon > 19) return false;
+        int64_t ts = 0;
+        for (size_t i = 0; i < colon; ++i) {
+            if (cursor[i] < '0' || cursor[i] > '9') return false;
+            ts = ts * 10 + (cursor[i] - '0');
+        }
+        after = TimeKey(ts, cursor.substr(colon + 1));
+    }
+
+    std::lock_guard<std::mutex> lock(mu);
+    out.photos.clear();
+    out.nextCursor.clear();
+    out.version = currentVersion;
+    // Cursor = posisi di urutan, bukan offset: foto baru di depan tidak menggeser halaman berikutnya
+    auto it = cursor.empty() ? byTime.begin() : byTime.upper_bound(after);
+    for (; it != byTime.end() && (limit == 0 || out.photos.size() < limit); ++it) {
+        out.photos.push_back(byName.find(it->second)->second);
+    }
+    if (it != byTime.end() && !out.photos.empty()) out.nextCursor = cursorFor(out.photos.back());
+    return true;
+}
+
+PhotoDelta PhotoCatalog::changesSince(uint64_t version) const {
+    std::lock_guard<std::mutex> lock(mu);
+    PhotoDelta delta;
+    delta.version = currentVersion;
+    // since=0: klien belum punya apa-apa (termasuk entri migrasi tanpa versi), kirim ulang penuh
+    if (version == 0 || version < tombstoneFloor || version > currentVersion) {
+        delta.reset = true;
+        return delta;
+    }
+    for (auto it = byVersion.upper_bound(version); it != byVersion.end(); ++it) {
+        delta.upserts.push_back(byName.find(it->second)->second);
+    }
+    std::sort(delta.upserts.begin(), delta.upserts.end(), [](const PhotoRecord& a, const PhotoRecord& b) {
+        return Newer()(TimeKey(a.timestamp, a.filename), TimeKey(b.timestamp, b.filename));
+    });
+    for (auto it = tombstones.upper_bound(version); it != tombstones.end(); ++it) {
+        delta.deleted.push_back(it->second);
+    }
+    return delta;
+}
+
+std::vector<PhotoRecord> PhotoCatalog::newerThan(int64_t timestamp, size_t limit) const {
+    std::lock_guard<std::mutex> lock(mu);
+    std::vector<PhotoRecord> out;
+    for (const auto& key : byTime) {
+        if (key.first <= timestamp || (limit > 0 && out.size() >= limit)) break;
+        out.push_back(byName.find(key.second)->second);
+    }
+    return out;
+}
+
+uint64_t PhotoCatalog::version() const {
+    std::lock_guard<std::mutex> lock(mu);
+    return currentVersion;
+}
+
+size_t PhotoCatalog::size() const {
+    std::lock_guard<std::mutex> lock(mu);
+    return byName.size();
+}
+
+void PhotoCatalog::setListener(const Listener& l) {
+    std::lock_guard<std::mutex> lock(listenerMu);
+    listener = l;
+}
+
+void PhotoCatalog::notify(const PhotoDelta& delta) {
+    std::lock_guard<std::mutex> lock(listenerMu);
+    if (listener) listener(delta);
+}
+
+void PhotoCatalog::putLocked(const PhotoRecord& record) {
+    auto it = byName.find(record.filename);
+    if (it != byName.end()) {
+        byTime.erase(TimeKey(it->second.timestamp, it->first));
+        byVersion.erase(it->second.version);
+    }
+    byName[record.filename] = record;
+    byTime.insert(TimeKey(record.timestamp, record.filename));
+    // Entri hasil migrasi (versi 0) tidak masuk index versi; since=0 selalu reset
+    if (record.version > 0) byVersion[record.version] = record.filename;
+}
+
+void PhotoCatalog::eraseLocked(const std::string& filename) {
+    auto it = byName.find(filename);
+    if (it == byName.end()) return;
+    byTime.erase(TimeKey(it->second.timestamp, it->first));
+    byVersion.erase(it->second.version);
+    byName.erase(it);
+}
+
+void PhotoCatalog::addTombstoneLocked(const std::string& filename, uint64_t version) {
+    dropTombstoneLocked(filename);
+    tombstones[version] = filename;
+    tombstoneByName[filename] = version;
+    while (tombstones.size() > kMaxTombstones) {
+        auto oldest = tombstones.begin();
+        tombstoneFloor = oldest->first;
+        execLocked("DELETE FROM photo_tombstones WHERE filename = ?1", oldest->second);
+        tombstoneByName.erase(oldest->second);
+        tombstones.erase(oldest);
+    }
+}
+
+void PhotoCatalog::dropTombstoneLocked(const std::string& filename) {
+    auto it = tombstoneByName.find(filename);
+    if (it == tombstoneByName.end()) return;
+    tombstones.erase(it->second);
+    tombstoneByName.erase(it);
+    execLocked("DELETE FROM photo_tombstones WHERE filename = ?1", filename);
+}
+
+bool PhotoCatalog::persistLocked(const PhotoRecord& record) {
+    if (!db) return false;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO photos (filename, timestamp, size, mtime, version) VALUES (?, ?, ?, ?, ?)",
+                           -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "❌ Failed to prepare SQL: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    sqlite3_bind_text(stmt, 1, record.filename.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, record.timestamp);
+    sqlite3_bind_int64(stmt, 3, static_cast<sqlite3_int64>(record.size));
+    sqlite3_bind_int64(stmt, 4, record.mtime);
+    sqlite3_bind_int64(stmt, 5, static_cast<sqlite3_int64>(record.version));
+    const bool ok = sqlite3_step(stmt) == SQLITE_DONE;
+    if (!ok) std::cerr << "❌ SQL execution error: " << sqlite3_errmsg(db) << std::endl;
+    sqlite3_finalize(stmt);
+    return ok;
+}
+
+bool PhotoCatalog::unpersistLocked(const std::string& filename, uint64_t version) {
+    return execLocked("DELETE FROM photos WHERE filename = ?1", filename) &&
+           execLocked("INSERT OR REPLACE INTO photo_tombstones (filename, version) VALUES (?1, ?2)",
+                      filename, static_cast<int64_t>(version));
+}
+
+void PhotoCatalog::saveMetaLocked() {
+    execLocked("INSERT OR REPLACE INTO catalog_meta (key, value) VALUES (?1, ?2)", "version",
+               static_cast<int64_t>(currentVersion));
+    execLocked("INSERT OR REPLACE INTO catalog_meta (key, value) VALUES (?1, ?2)", "tombstone_floor",
+               static_cast<int64_t>(tombstoneFloor));
+}
+
+void PhotoCatalog::watchLoop() {
+#ifdef __linux__
+    alignas(struct inotify_event) char buf[16 * 1024];
+    while (running) {
+        struct pollfd fds[2] = {{inotifyFd, POLLIN, 0}, {wakePipe[0], POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+        ssize_t n = read(inotifyFd, buf, sizeof(buf));
+        if (n <= 0) continue;
+        for (char* p = buf; p < buf + n;) {
+            const struct inotify_event* ev = reinterpret_cast<const struct inotify_event*>(p);
+            p += sizeof(struct inotify_event) + ev->len;
+            if (ev->mask & IN_Q_OVERFLOW) {
+                // Event hilang: bangun ulang dari direktori
+                reconcile();
+                continue;
+            }
+            if (ev->len == 0 || !isPhotoName(ev->name)) continue;
+            if (ev->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+                add(ev->name);
+            } else if (ev->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                remove(ev->name);
+            }
+        }
+    }
+#endif
+}
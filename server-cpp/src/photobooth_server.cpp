@@ -1,5 +1,9 @@
 #include "../include/server.h"
+#include "../include/image_variants.h"
 #include "../include/booth_identity.h"
+#include "../include/photo_catalog.h"
+#include "../include/color_lut.h"
+#include "../include/effect_variants.h"
 
   PhotoBoothServer::PhotoBoothServer(int apiPort, int mjpegPort)
     : apiPort(apiPort), mjpegPort(mjpegPort), running(false) {
@@ -12,14 +16,29 @@
     identityStore = new BoothIdentityStore();
     createDirectories("data");
     identityStore->init("data");
+    photoCatalog = new PhotoCatalog();
+    photoCatalog->init("uploads", "data");
+    photoCatalog->setListener([this](const PhotoDelta& delta) {
+        if (webSocketServer) webSocketServer->publishPhotoDelta(delta);
+    });
+    createDirectories("luts");
+    lutLibrary = new LutLibrary("luts");
+    effectVariants = new EffectVariantStore("uploads/effects");
 }
 
 PhotoBoothServer::~PhotoBoothServer() {
     stop();
+    // Worker varian efek dan watcher katalog memanggil webSocketServer; dihentikan lebih dulu
+    delete effectVariants;
+    effectVariants = nullptr;
+    delete photoCatalog;
+    photoCatalog = nullptr;
     delete gphoto;
     delete mjpegServer;
     delete webSocketServer;
+    webSocketServer = nullptr;
     delete identityStore;
+    delete lutLibrary;
 }
 
 bool PhotoBoothServer::start() {
@@ -42,7 +61,12 @@ bool PhotoBoothServer::stop() {
     if (!running) {
         return true;
     }
+    // Lepas listener (menunggu callback yang sedang jalan) sebelum server WS berhenti
+    photoCatalog->setListener(nullptr);
+    photoCatalog->stop();
     mjpegServer->stop();
+    // Render varian efek yang masih antri dijawab gagal selagi koneksi WS/HTTP masih hidup
+    effectVariants->shutdown();
     webSocketServer->stop();
     running = false;
     return true;
@@ -58,45 +82,16 @@ bool PhotoBoothServer::identityRegistered() const {
 }
 
 std::vector<Photo> PhotoBoothServer::getPhotosList() {
-    std::cout << "🔍 DEBUG: getPhotosList() called" << std::endl;
+    // Dari katalog di memori (sudah terurut terbaru dulu), tanpa readdir per request
     std::vector<Photo> photos;
-    try {
-        std::cout << "🔍 DEBUG: Reading uploads directory..." << std::endl;
-        auto entries = filesystem_compat::directory_entries("uploads");
-        std::cout << "🔍 DEBUG: Found " << entries.size() << " files in uploads directory" << std::endl;
-        
-        for (const auto& filename : entries) {
-            std::cout << "🔍 DEBUG: Processing file: " << filename << std::endl;
-            if (filename.size() > 4 &&
-                (filename.substr(filename.size() - 4) == ".jpg" ||
-                 filename.substr(filename.size() - 5) == ".jpeg")) {
-                Photo photo;
-                photo.filename = filename;
-                photo.path = "/uploads/" + filename;
-                if (filename.find("photo_") == 0) {
-                    std::string timestampStr = filename.substr(6, filename.size() - 10);
-                    try { photo.timestamp = std::stoll(timestampStr); } catch (...) { photo.timestamp = std::time(nullptr); }
-                } else {
-                    photo.timestamp = std::time(nullptr);
-                }
-                photo.simulated = false;
-                photos.push_back(photo);
-            }
-        }
-    } catch (const std::exception& e) {
-        std::cerr << "Error reading uploads directory: " << e.what() << std::endl;
+    for (const auto& record : photoCatalog->list()) {
+        Photo photo;
+        photo.filename = record.filename;
+        photo.path = "/uploads/" + record.filename;
+        photo.timestamp = record.timestamp;
+        photo.simulated = false;
+        photos.push_back(photo);
     }
-    
-    std::cout << "🔍 DEBUG: Total photos processed: " << photos.size() << std::endl;
-    for (const auto& photo : photos) {
-        std::cout << "🔍 DEBUG: Photo - filename: " << photo.filename
-                  << ", path: " << photo.path
-                  << ", timestamp: " << photo.timestamp
-                  << ", simulated: " << (photo.simulated ? "true" : "false") << std::endl;
-    }
-    
-    std::sort(photos.begin(), photos.end(), [](const Photo& a, const Photo& b) { return a.timestamp > b.timestamp; });
-    std::cout << "🔍 DEBUG: Photos sorted, returning " << photos.size() << " photos" << std::endl;
     return photos;
 }
 
@@ -112,7 +107,14 @@ bool PhotoBoothServer::deletePhoto(const std::string& filename) {
     }
     std::string filePath = "uploads/" + filename;
     try {
-        return filesystem_compat::remove(filePath);
+        if (webSocketServer && webSocketServer->getImageVariants()) {
+            webSocketServer->getImageVariants()->removeFor(filePath);
+        }
+        if (!filesystem_compat::remove(filePath)) return false;
+        // Setelah sumber hilang: render yang sedang jalan membuang hasilnya sendiri
+        effectVariants->removeFor(filePath);
+        photoCatalog->remove(filename);
+        return true;
     } catch (const std::exception& e) {
         std::cerr << "Error deleting photo: " << e.what() << std::endl;
         return false;
@@ -288,9 +290,22 @@ void PhotoBoothServer::handleCapturePhotoEvent(connection_hdl hdl) {
         return;
     }
     std::cout << "✅ Photo captured successfully: " << result["filename"] << std::endl;
+    photoCatalog->add(result["filename"]);
+    // Efek capture tidak menahan respons: foto asli dikirim sekarang, versi berefek menyusul
+    // lewat "photo-effect-ready"
+    auto pipeline = gphoto->getPipeline();
+    if (pipeline && !pipeline->empty()) {
+        result["effects"] = pipeline->describe();
+        result["effectPending"] = "true";
+    }
     if (webSocketServer) {
+        // Thumbnail galeri dibuat di latar belakang sebelum ada yang memintanya
+        if (auto* variants = webSocketServer->getImageVariants()) variants->warm(result["filepath"]);
         webSocketServer->emitToClient(hdl, "photo-captured", result);
     }
+    if (pipeline && !pipeline->empty()) {
+        renderEffectVariant(hdl, result["filename"], pipeline);
+    }
     std::map<std::string, std::string> broadcastData;
     broadcastData["filename"] = result["filename"];
     broadcastData["path"] = result["url"];
@@ -305,68 +320,109 @@ void PhotoBoothServer::handleCapturePhotoEvent(connection_hdl hdl) {
     }
 }
 
-void PhotoBoothServer::handleSetEffectEvent(connection_hdl hdl, const std::map<std::string, std::string>& data) {
-    std::cout << "📝 NOTE: handleSetEffectEvent called - effects moved to frontend" << std::endl;
+bool PhotoBoothServer::parseEffectSteps(const std::map<std::string, std::string>& data, std::vector<EffectStep>& steps,
+                                        std::string& effectName, EffectParams& params, std::string& error) {
+    // Rantai efek ("effects": array JSON atau "sepia:0.8,vignette") atau satu efek + parameter
+    steps.clear();
+    params.intensity = 0.5;
+    params.radius = 1.0;
+    params.pixelSize = 10;
     
-    auto effectIt = data.find("effect");
-    if (effectIt == data.end()) {
+    auto effectsIt = data.find("effects");
+    if (effectsIt != data.end() && !effectsIt->second.empty()) {
+        if (!EffectPipeline::parseSteps(effectsIt->second, steps, error)) {
+            return false;
+        }
+        effectName = steps.empty() ? "none" : EffectPipeline::effectName(steps.front().type);
+    } else {
+        auto effectIt = data.find("effect");
+        EffectType effect = EffectType::NONE;
+        if (effectIt == data.end() || !EffectPipeline::parseEffectName(effectIt->second, effect)) {
+            error = "Invalid effect name";
+            return false;
+        }
+        effectName = effectIt->second;
+        
+        auto pIntensityIt = data.find("params.intensity");
+        if (pIntensityIt != data.end()) {
+            try { params.intensity = std::stod(pIntensityIt->second); if (params.intensity < 0) params.intensity = 0; if (params.intensity > 1) params.intensity = 1; } catch (...) {}
+        }
+        auto pRadiusIt = data.find("params.radius");
+        if (pRadiusIt != data.end()) {
+            try { params.radius = std::stod(pRadiusIt->second); if (params.radius < 0) params.radius = 0; } catch (...) {}
+        }
+        auto pPixelSizeIt = data.find("params.pixelSize");
+        if (pPixelSizeIt != data.end()) {
+            try { params.pixelSize = std::stoi(pPixelSizeIt->second); if (params.pixelSize < 1) params.pixelSize = 1; } catch (...) {}
+        }
+        auto intensityIt = data.find("intensity");
+        if (intensityIt != data.end()) {
+            try { params.intensity = std::stod(intensityIt->second); if (params.intensity < 0) params.intensity = 0; if (params.intensity > 1) params.intensity = 1; } catch (...) {}
+        }
+        auto radiusIt = data.find("radius");
+        if (radiusIt != data.end()) {
+            try { params.radius = std::stod(radiusIt->second); if (params.radius < 0) params.radius = 0; } catch (...) {}
+        }
+        auto pixelSizeIt = data.find("pixelSize");
+        if (pixelSizeIt != data.end()) {
+            try { params.pixelSize = std::stoi(pixelSizeIt->second); if (params.pixelSize < 1) params.pixelSize = 1; } catch (...) {}
+        }
+        auto lutIt = data.count("params.lut") ? data.find("params.lut") : data.find("lut");
+        if (lutIt != data.end()) {
+            params.lut = lutIt->second;
+        }
+        if (effect != EffectType::NONE) {
+            EffectStep step;
+            step.type = effect;
+            step.params = params;
+            steps.push_back(step);
+        }
+    }
+    return EffectPipeline::resolveLuts(steps, *lutLibrary, error);
+}
+
+std::shared_ptr<const EffectPipeline> PhotoBoothServer::effectPipelineFor(const std::map<std::string, std::string>& query) {
+    if (!query.count("effect") && !query.count("effects")) return nullptr;
+    std::vector<EffectStep> steps;
+    std::string effectName;
+    std::string error;
+    EffectParams params;
+    if (!parseEffectSteps(query, steps, effectName, params, error) || steps.empty()) return nullptr;
+    return std::make_shared<const EffectPipeline>(steps);
+}
+
+void PhotoBoothServer::handleSetEffectEvent(connection_hdl hdl, const std::map<std::string, std::string>& data) {
+    std::vector<EffectStep> steps;
+    std::string effectName;
+    std::string error;
+    EffectParams params;
+    if (!parseEffectSteps(data, steps, effectName, params, error)) {
         std::map<std::string, std::string> response;
         response["success"] = "false";
-        response["error"] = "Invalid effect name";
+        response["error"] = error;
         if (webSocketServer) {
             webSocketServer->emitToClient(hdl, "effect-changed", response);
         }
         return;
     }
     
-    std::string effectName = effectIt->second;
-    std::cout << "📝 NOTE: Effect " << effectName << " requested but processing moved to frontend" << std::endl;
-    
-    // Parse parameters for compatibility
-    EffectParams params;
-    params.intensity = 0.5;
-    params.radius = 1.0;
-    params.pixelSize = 10;
-    
-    auto pIntensityIt = data.find("params.intensity");
-    if (pIntensityIt != data.end()) {
-        try { params.intensity = std::stod(pIntensityIt->second); if (params.intensity < 0) params.intensity = 0; if (params.intensity > 1) params.intensity = 1; } catch (...) {}
-    }
-    auto pRadiusIt = data.find("params.radius");
-    if (pRadiusIt != data.end()) {
-        try { params.radius = std::stod(pRadiusIt->second); if (params.radius < 0) params.radius = 0; } catch (...) {}
-    }
-    auto pPixelSizeIt = data.find("params.pixelSize");
-    if (pPixelSizeIt != data.end()) {
-        try { params.pixelSize = std::stoi(pPixelSizeIt->second); if (params.pixelSize < 1) params.pixelSize = 1; } catch (...) {}
-    }
-    auto intensityIt = data.find("intensity");
-    if (intensityIt != data.end()) {
-        try { params.intensity = std::stod(intensityIt->second); if (params.intensity < 0) params.intensity = 0; if (params.intensity > 1) params.intensity = 1; } catch (...) {}
-    }
-    auto radiusIt = data.find("radius");
-    if (radiusIt != data.end()) {
-        try { params.radius = std::stod(radiusIt->second); if (params.radius < 0) params.radius = 0; } catch (...) {}
+    // Live view: decode diperkecil + rantai terkompilasi, satu encode untuk semua penonton.
+    // Capture: foto asli disimpan, versi berefek dirender terpisah
+    mjpegServer->setEffects(steps);
+    gphoto->setEffects(steps);
+    auto budgetIt = data.find("frameBudgetMs");
+    if (budgetIt != data.end()) {
+        try { mjpegServer->setFrameBudget(std::stod(budgetIt->second)); } catch (...) {}
     }
-    auto pixelSizeIt = data.find("pixelSize");
-    if (pixelSizeIt != data.end()) {
-        try { params.pixelSize = std::stoi(pixelSizeIt->second); if (params.pixelSize < 1) params.pixelSize = 1; } catch (...) {}
-    }
-    
-    // NOTE: Effects are now processed in frontend, but we keep the calls for backward compatibility
-    mjpegServer->setEffect(EffectType::NONE, params);
-    gphoto->setEffect(EffectType::NONE, params);
     
-    std::cout << "📝 NOTE: Effect " << effectName << " with params: intensity=" << params.intensity
-              << ", radius=" << params.radius << ", pixelSize=" << params.pixelSize << " - processing moved to frontend" << std::endl;
-              
     std::map<std::string, std::string> response;
     response["success"] = "true";
     response["effect"] = effectName;
+    response["pipeline"] = mjpegServer->describeEffects();
     response["intensity"] = std::to_string(params.intensity);
     response["radius"] = std::to_string(params.radius);
     response["pixelSize"] = std::to_string(params.pixelSize);
-    response["note"] = "Effect processing moved to frontend";
+    if (!params.lut.empty()) response["lut"] = params.lut;
     
     if (webSocketServer) {
         webSocketServer->emitToClient(hdl, "effect-changed", response);
@@ -376,6 +432,52 @@ void PhotoBoothServer::handleSetEffectEvent(connection_hdl hdl, const std::map<s
     }
 }
 
+void PhotoBoothServer::handleRenderPhotoEffectEvent(connection_hdl hdl, const std::map<std::string, std::string>& data) {
+    std::map<std::string, std::string> response;
+    auto filenameIt = data.find("filename");
+    std::vector<EffectStep> steps;
+    std::string effectName;
+    std::string error;
+    EffectParams params;
+    if (filenameIt == data.end() || !PhotoCatalog::isPhotoName(filenameIt->second) ||
+        filenameIt->second.find("..") != std::string::npos) {
+        error = "invalid_filename";
+    } else if (parseEffectSteps(data, steps, effectName, params, error) && steps.empty()) {
+        error = "no_effect";
+    }
+    if (!error.empty()) {
+        response["success"] = "false";
+        response["error"] = error;
+        if (filenameIt != data.end()) response["filename"] = filenameIt->second;
+        if (webSocketServer) {
+            webSocketServer->emitToClient(hdl, "photo-effect-ready", response);
+        }
+        return;
+    }
+    renderEffectVariant(hdl, filenameIt->second, std::make_shared<const EffectPipeline>(steps));
+}
+
+void PhotoBoothServer::renderEffectVariant(connection_hdl hdl, const std::string& filename,
+                                           std::shared_ptr<const EffectPipeline> pipeline, const std::string& event,
+                                           const std::string& effectName) {
+    const std::string effects = pipeline->describe();
+    effectVariants->render("uploads/" + filename, pipeline, [this, hdl, filename, effects, event, effectName](const std::string& path) {
+        std::map<std::string, std::string> response;
+        response["success"] = path.empty() ? "false" : "true";
+        response["filename"] = filename;
+        response["effects"] = effects;
+        if (!effectName.empty()) response["effect"] = effectName;
+        if (path.empty()) {
+            response["error"] = "render_failed";
+        } else {
+            response["url"] = "/" + path;
+        }
+        if (webSocketServer) {
+            webSocketServer->emitToClient(hdl, event, response);
+        }
+    });
+}
+
 void PhotoBoothServer::handleGetEffectEvent(connection_hdl hdl) {
     auto [effect, params] = mjpegServer->getCurrentEffect();
     std::string effectName;
@@ -388,6 +490,8 @@ void PhotoBoothServer::handleGetEffectEvent(connection_hdl hdl) {
         case EffectType::SHARPEN: effectName = "sharpen"; break;
         case EffectType::INVERT: effectName = "invert"; break;
         case EffectType::PIXELATE: effectName = "pixelate"; break;
+        case EffectType::WIDE_ANGLE: effectName = "wideangle"; break;
+        case EffectType::LUT: effectName = "lut"; break;
         default: effectName = "none"; break;
     }
     std::map<std::string, std::string> response;
@@ -395,148 +499,94 @@ void PhotoBoothServer::handleGetEffectEvent(connection_hdl hdl) {
     response["intensity"] = std::to_string(params.intensity);
     response["radius"] = std::to_string(params.radius);
     response["pixelSize"] = std::to_string(params.pixelSize);
+    if (effect == EffectType::LUT) response["lut"] = params.lut;
+    response["pipeline"] = mjpegServer->describeEffects();
     if (webSocketServer) {
         webSocketServer->emitToClient(hdl, "current-effect", response);
     }
 }
 
-void PhotoBoothServer::handleApplyEffectEvent(connection_hdl hdl, const std::map<std::string, std::string>& data) {
-    std::cout << "📝 NOTE: handleApplyEffectEvent called - effects moved to frontend" << std::endl;
-    std::cout << "📋 Received data: ";
-    for (const auto& pair : data) {
-        std::cout << pair.first << "=" << pair.second << " ";
+void PhotoBoothServer::handleGetLutsEvent(connection_hdl hdl) {
+    const std::vector<std::string> names = lutLibrary->list();
+    std::string lutsJson = "[";
+    for (size_t i = 0; i < names.size(); ++i) {
+        if (i > 0) lutsJson += ",";
+        lutsJson += "\"" + names[i] + "\"";
+    }
+    lutsJson += "]";
+    std::map<std::string, std::string> response;
+    response["success"] = "true";
+    response["count"] = std::to_string(names.size());
+    response["luts"] = lutsJson;
+    if (webSocketServer) {
+        webSocketServer->emitToClient(hdl, "luts", response);
     }
-    std::cout << std::endl;
-    
-    auto effectIt = data.find("effect");
-    if (effectIt == data.end()) {
-        std::cout << "❌ No effect name provided in apply-effect request" << std::endl;
+}
+
+// Mirror preview selfie di live view; dikerjakan di koefisien DCT, foto capture tidak ikut dibalik
+void PhotoBoothServer::handleSetMirrorEvent(connection_hdl hdl, const std::map<std::string, std::string>& data) {
+    auto enabledIt = data.find("enabled");
+    const bool enabled = enabledIt != data.end() && (enabledIt->second == "true" || enabledIt->second == "1");
+    mjpegServer->setMirror(enabled);
+    std::map<std::string, std::string> response;
+    response["success"] = "true";
+    response["enabled"] = enabled ? "true" : "false";
+    if (webSocketServer) {
+        webSocketServer->emitToClient(hdl, "mirror-changed", response);
+    }
+}
+
+void PhotoBoothServer::handleApplyEffectEvent(connection_hdl hdl, const std::map<std::string, std::string>& data) {
+    // Event yang dikirim UI saat efek/parameter dipilih: rantai yang sama dipasang ke live view dan
+    // capture (seperti set-effect), foto yang sedang ditampilkan dirender ulang dari aslinya
+    std::vector<EffectStep> steps;
+    std::string effectName;
+    std::string error;
+    EffectParams params;
+    if (!parseEffectSteps(data, steps, effectName, params, error)) {
+        std::cout << "❌ Invalid apply-effect request: " << error << std::endl;
         std::map<std::string, std::string> response;
         response["success"] = "false";
-        response["error"] = "Invalid effect name";
-        response["note"] = "Effect processing moved to frontend";
+        response["error"] = error;
         if (webSocketServer) {
             webSocketServer->emitToClient(hdl, "effect-applied", response);
         }
         return;
     }
     
-    std::string effectName = effectIt->second;
-    std::cout << "📝 NOTE: Effect " << effectName << " requested but processing moved to frontend" << std::endl;
-    
-    // Parse parameters for compatibility
-    EffectParams params;
-    params.intensity = 0.5;
-    params.radius = 1.0;
-    params.pixelSize = 10;
-    
-    auto pIntensityIt2 = data.find("params.intensity");
-    if (pIntensityIt2 != data.end()) {
-        try { params.intensity = std::stod(pIntensityIt2->second); if (params.intensity < 0) params.intensity = 0; if (params.intensity > 1) params.intensity = 1; } catch (...) {}
-    }
-    auto pRadiusIt2 = data.find("params.radius");
-    if (pRadiusIt2 != data.end()) {
-        try { params.radius = std::stod(pRadiusIt2->second); if (params.radius < 0) params.radius = 0; } catch (...) {}
-    }
-    auto pPixelSizeIt2 = data.find("params.pixelSize");
-    if (pPixelSizeIt2 != data.end()) {
-        try { params.pixelSize = std::stoi(pPixelSizeIt2->second); if (params.pixelSize < 1) params.pixelSize = 1; } catch (...) {}
-    }
-    
-    // Parse JSON params string if present
-    auto paramsIt = data.find("params");
-    if (paramsIt != data.end()) {
-        std::string paramsStr = paramsIt->second;
-        size_t intensityPos = paramsStr.find("\"intensity\":");
-        if (intensityPos != std::string::npos) {
-            size_t valueStart = paramsStr.find(":", intensityPos) + 1;
-            size_t valueEnd = paramsStr.find(",", valueStart);
-            if (valueEnd == std::string::npos) valueEnd = paramsStr.find("}", valueStart);
-            if (valueEnd != std::string::npos) {
-                std::string intensityStr = paramsStr.substr(valueStart, valueEnd - valueStart);
-                intensityStr.erase(std::remove(intensityStr.begin(), intensityStr.end(), '"'), intensityStr.end());
-                intensityStr.erase(std::remove(intensityStr.begin(), intensityStr.end(), ' '), intensityStr.end());
-                try { params.intensity = std::stod(intensityStr); if (params.intensity < 0) params.intensity = 0; if (params.intensity > 1) params.intensity = 1; } catch (...) {}
-            }
-        }
-        size_t radiusPos = paramsStr.find("\"radius\":");
-        if (radiusPos != std::string::npos) {
-            size_t valueStart = paramsStr.find(":", radiusPos) + 1;
-            size_t valueEnd = paramsStr.find(",", valueStart);
-            if (valueEnd == std::string::npos) valueEnd = paramsStr.find("}", valueStart);
-            if (valueEnd != std::string::npos) {
-                std::string radiusStr = paramsStr.substr(valueStart, valueEnd - valueStart);
-                radiusStr.erase(std::remove(radiusStr.begin(), radiusStr.end(), '"'), radiusStr.end());
-                radiusStr.erase(std::remove(radiusStr.begin(), radiusStr.end(), ' '), radiusStr.end());
-                try { params.radius = std::stod(radiusStr); if (params.radius < 0) params.radius = 0; } catch (...) {}
-            }
-        }
-        size_t pixelSizePos = paramsStr.find("\"pixelSize\":");
-        if (pixelSizePos != std::string::npos) {
-            size_t valueStart = paramsStr.find(":", pixelSizePos) + 1;
-            size_t valueEnd = paramsStr.find(",", valueStart);
-            if (valueEnd == std::string::npos) valueEnd = paramsStr.find("}", valueStart);
-            if (valueEnd != std::string::npos) {
-                std::string pixelSizeStr = paramsStr.substr(valueStart, valueEnd - valueStart);
-                pixelSizeStr.erase(std::remove(pixelSizeStr.begin(), pixelSizeStr.end(), '"'), pixelSizeStr.end());
-                pixelSizeStr.erase(std::remove(pixelSizeStr.begin(), pixelSizeStr.end(), ' '), pixelSizeStr.end());
-                try { params.pixelSize = std::stoi(pixelSizeStr); if (params.pixelSize < 1) params.pixelSize = 1; } catch (...) {}
-            }
-        }
-    }
+    mjpegServer->setEffects(steps);
+    gphoto->setEffects(steps);
+    std::cout << "🎨 Effect applied: " << mjpegServer->describeEffects() << std::endl;
     
-    auto intensityIt = data.find("intensity");
-    if (intensityIt != data.end()) {
-        try { params.intensity = std::stod(intensityIt->second); if (params.intensity < 0) params.intensity = 0; if (params.intensity > 1) params.intensity = 1; } catch (...) {}
-    }
-    auto radiusIt = data.find("radius");
-    if (radiusIt != data.end()) {
-        try { params.radius = std::stod(radiusIt->second); if (params.radius < 0) params.radius = 0; } catch (...) {}
-    }
-    auto pixelSizeIt = data.find("pixelSize");
-    if (pixelSizeIt != data.end()) {
-        try { params.pixelSize = std::stoi(pixelSizeIt->second); if (params.pixelSize < 1) params.pixelSize = 1; } catch (...) {}
-    }
-    
-    std::cout << "📝 NOTE: Effect " << effectName << " with params: intensity=" << params.intensity
-              << ", radius=" << params.radius << ", pixelSize=" << params.pixelSize << " - processing moved to frontend" << std::endl;
-    
-    // NOTE: Effects are now processed in frontend, but we keep NONE for backward compatibility
-    mjpegServer->setEffect(EffectType::NONE, params);
-    gphoto->setEffect(EffectType::NONE, params);
-    
-    // Check if client is asking for current photo processing
     auto currentPhotoIt = data.find("currentPhoto");
-    if (currentPhotoIt != data.end() && currentPhotoIt->second == "true") {
-        std::cout << "📝 NOTE: Current photo effect requested but processing moved to frontend" << std::endl;
-        
-        auto filenameIt = data.find("filename");
-        if (filenameIt != data.end()) {
-            std::string filename = filenameIt->second;
-            std::cout << "📁 Photo file: " << filename << " - effects now processed in frontend" << std::endl;
-            
-            // Notify client that effect processing has moved to frontend
-            std::map<std::string, std::string> photoUpdateResponse;
-            photoUpdateResponse["success"] = "false";
-            photoUpdateResponse["filename"] = filename;
-            photoUpdateResponse["effect"] = effectName;
-            photoUpdateResponse["message"] = "Effect processing moved to frontend";
-            photoUpdateResponse["note"] = "Please use frontend Canvas API for effect processing";
-            
-            if (webSocketServer) {
-                webSocketServer->emitToClient(hdl, "photo-effect-applied", photoUpdateResponse);
-            }
+    auto filenameIt = data.find("filename");
+    if (currentPhotoIt != data.end() && currentPhotoIt->second == "true" && filenameIt != data.end()) {
+        std::map<std::string, std::string> photoResponse;
+        photoResponse["filename"] = filenameIt->second;
+        photoResponse["effect"] = effectName;
+        if (!PhotoCatalog::isPhotoName(filenameIt->second) || filenameIt->second.find("..") != std::string::npos) {
+            photoResponse["success"] = "false";
+            photoResponse["error"] = "invalid_filename";
+        } else if (steps.empty()) {
+            // Tanpa efek: foto asli yang ditampilkan
+            photoResponse["success"] = "true";
+            photoResponse["url"] = "/uploads/" + filenameIt->second;
+        }
+        if (!photoResponse.count("success")) {
+            renderEffectVariant(hdl, filenameIt->second, gphoto->getPipeline(), "photo-effect-applied", effectName);
+        } else if (webSocketServer) {
+            webSocketServer->emitToClient(hdl, "photo-effect-applied", photoResponse);
         }
     }
     
-    std::cout << "📝 NOTE: Effect " << effectName << " request completed - processing moved to frontend" << std::endl;
     std::map<std::string, std::string> response;
     response["success"] = "true";
     response["effect"] = effectName;
+    response["pipeline"] = mjpegServer->describeEffects();
     response["intensity"] = std::to_string(params.intensity);
     response["radius"] = std::to_string(params.radius);
     response["pixelSize"] = std::to_string(params.pixelSize);
-    response["note"] = "Effect processing moved to frontend";
+    if (!params.lut.empty()) response["lut"] = params.lut;
     
     if (webSocketServer) {
         webSocketServer->emitToClient(hdl, "effect-applied", response);
@@ -0,0 +1,234 @@
+#include "../include/render_cache.h"
+#include "../include/jpeg_codec.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include <sys/stat.h>
+
+namespace {
+
+int64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+void fnvMix(unsigned long long& h, const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+}
+
+template <typename T>
+void fnvMixValue(unsigned long long& h, const T& value) {
+    fnvMix(h, &value, sizeof(value));
+}
+
+bool isCacheKey(const std::string& key) {
+    if (key.size() != 16) return false;
+    return std::all_of(key.begin(), key.end(), [](char c) { return std::isxdigit(static_cast<unsigned char>(c)) != 0; });
+}
+
+}
+
+RenderCache::RenderCache(const std::string& dir, size_t memoryBytes, uint64_t diskBytes)
+    : dir(dir), memoryLimit(memoryBytes), diskLimit(diskBytes) {
+    for (size_t pos = dir.find('/'); pos != std::string::npos; pos = dir.find('/', pos + 1)) {
+        mkdir(dir.substr(0, pos).c_str(), 0755);
+    }
+    mkdir(dir.c_str(), 0755);
+    std::lock_guard<std::mutex> lock(mu);
+    loadIndexLocked();
+    std::cout << "🗃️ Render cache: " << disk.size() << " entries on disk (" << (diskUsed / (1024 * 1024)) << " MB)" << std::endl;
+}
+
+std::string RenderCache::makeKey(const CompiledLayout& layout, const std::vector<std::string>& photoPaths) {
+    if (layout.key.empty()) return "";
+
+    unsigned long long h = 1469598103934665603ULL;
+    fnvMix(h, layout.key.data(), layout.key.size());
+    fnvMixValue(h, layout.quality);
+    // Identitas foto: path + inode + ukuran + mtime (ns). Foto capture tidak pernah diedit di tempat,
+    // jadi ini setara hash konten tanpa membaca file.
+    for (const auto& photoPath : photoPaths) {
+        struct stat st;
+        if (stat(photoPath.c_str(), &st) != 0) return "";
+        fnvMix(h, photoPath.data(), photoPath.size() + 1);
+        fnvMixValue(h, static_cast<uint64_t>(st.st_ino));
+        fnvMixValue(h, static_cast<int64_t>(st.st_size));
+        fnvMixValue(h, static_cast<int64_t>(st.st_mtim.tv_sec));
+        fnvMixValue(h, static_cast<int64_t>(st.st_mtim.tv_nsec));
+    }
+    for (const auto& layer : layout.layers) {
+        if (!layer.asset.path.empty()) fnvMixValue(h, static_cast<int64_t>(layer.asset.mtime));
+        if (!layer.mask.path.empty()) fnvMixValue(h, static_cast<int64_t>(layer.mask.mtime));
+    }
+    for (const auto& t : layout.texts) {
+        // Teks sudah tercakup di hash template, kecuali font yang diganti di disk
+        fnvMix(h, t.fontPath.data(), t.fontPath.size());
+        fnvMixValue(h, static_cast<int64_t>(t.fontMtime));
+    }
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%016llx", h);
+    return buf;
+}
+
+std::string RenderCache::variantKey(const std::string& key, int width, int height, int quality) {
+    if (key.empty()) return "";
+    unsigned long long h = 1469598103934665603ULL;
+    fnvMix(h, key.data(), key.size());
+    fnvMixValue(h, width);
+    fnvMixValue(h, height);
+    fnvMixValue(h, quality);
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%016llx", h);
+    return buf;
+}
+
+std::string RenderCache::pathFor(const std::string& key) const {
+    return dir + "/" + key + ".jpg";
+}
+
+std::string RenderCache::urlFor(const std::string& path) {
+    return "/" + path;
+}
+
+bool RenderCache::lookup(const std::string& key, std::shared_ptr<const std::vector<unsigned char>>* jpeg) {
+    if (key.empty()) return false;
+    std::lock_guard<std::mutex> lock(mu);
+    auto d = disk.find(key);
+    if (d == disk.end()) return false;
+
+    for (auto it = memory.begin(); it != memory.end(); ++it) {
+        if (it->first == key) {
+            memory.splice(memory.begin(), memory, it);
+            d->second.lastAccess = nowSeconds();
+            if (jpeg) *jpeg = memory.front().second;
+            return true;
+        }
+    }
+
+    struct stat st;
+    if (stat(pathFor(key).c_str(), &st) != 0) {
+        // File dihapus dari luar: anggap miss dan rapikan index
+        diskUsed -= d->second.size;
+        disk.erase(d);
+        saveIndexLocked();
+        return false;
+    }
+    d->second.lastAccess = nowSeconds();
+    if (jpeg) {
+        auto bytes = std::make_shared<std::vector<unsigned char>>();
+        if (!readFileBytes(pathFor(key), *bytes)) return false;
+        rememberLocked(key, bytes);
+        *jpeg = bytes;
+    }
+    return true;
+}
+
+bool RenderCache::store(const std::string& key, const std::vector<unsigned char>& jpeg) {
+    if (!isCacheKey(key) || jpeg.empty()) return false;
+    const std::string path = pathFor(key);
+    // Nama tmp unik per thread supaya dua job identik tidak saling menimpa file sementara
+    std::ostringstream tmp;
+    tmp << path << "." << std::hash<std::thread::id>()(std::this_thread::get_id()) << ".part";
+    {
+        std::ofstream ofs(tmp.str(), std::ios::binary);
+        ofs.write(reinterpret_cast<const char*>(jpeg.data()), (std::streamsize)jpeg.size());
+        ofs.close();
+        if (!ofs || std::rename(tmp.str().c_str(), path.c_str()) != 0) {
+            std::remove(tmp.str().c_str());
+            return false;
+        }
+    }
+
+    auto bytes = std::make_shared<const std::vector<unsigned char>>(jpeg);
+    std::lock_guard<std::mutex> lock(mu);
+    auto d = disk.find(key);
+    if (d != disk.end()) diskUsed -= d->second.size;
+    DiskEntry& entry = disk[key];
+    entry.size = jpeg.size();
+    entry.lastAccess = nowSeconds();
+    diskUsed += entry.size;
+    rememberLocked(key, bytes);
+    evictDiskLocked();
+    saveIndexLocked();
+    return true;
+}
+
+void RenderCache::rememberLocked(const std::string& key, const Bytes& bytes) {
+    if (bytes->size() > memoryLimit / 4) return;  // render raksasa cukup di disk
+    for (auto it = memory.begin(); it != memory.end(); ++it) {
+        if (it->first == key) {
+            memoryUsed -= it->second->size();
+            memory.erase(it);
+            break;
+        }
+    }
+    memory.emplace_front(key, bytes);
+    memoryUsed += bytes->size();
+    while (memoryUsed > memoryLimit && !memory.empty()) {
+        memoryUsed -= memory.back().second->size();
+        memory.pop_back();
+    }
+}
+
+void RenderCache::evictDiskLocked() {
+    if (diskUsed <= diskLimit) return;
+    std::vector<std::pair<int64_t, std::string>> order;
+    for (const auto& e : disk) order.emplace_back(e.second.lastAccess, e.first);
+    std::sort(order.begin(), order.end());
+    for (const auto& o : order) {
+        if (diskUsed <= diskLimit) break;
+        auto d = disk.find(o.second);
+        std::remove(pathFor(o.second).c_str());
+        diskUsed -= d->second.size;
+        disk.erase(d);
+        memory.remove_if([&](const std::pair<std::string, Bytes>& m) {
+            if (m.first != o.second) return false;
+            memoryUsed -= m.second->size();
+            return true;
+        });
+    }
+}
+
+void RenderCache::loadIndexLocked() {
+    std::ifstream in(dir + "/index.txt");
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream iss(line);
+        std::string key;
+        DiskEntry entry;
+        if (!(iss >> key >> entry.size >> entry.lastAccess) || !isCacheKey(key)) continue;
+        struct stat st;
+        if (stat(pathFor(key).c_str(), &st) != 0 || static_cast<uint64_t>(st.st_size) != entry.size) continue;
+        disk[key] = entry;
+        diskUsed += entry.size;
+    }
+}
+
+void RenderCache::saveIndexLocked() {
+    const std::string path = dir + "/index.txt";
+    std::ofstream out(path + ".tmp");
+    for (const auto& e : disk) {
+        out << e.first << " " << e.second.size << " " << e.second.lastAccess << "\n";
+    }
+    out.close();
+    if (out) std::rename((path + ".tmp").c_str(), path.c_str());
+}
+
+size_t RenderCache::memoryEntries() const {
+    std::lock_guard<std::mutex> lock(mu);
+    return memory.size();
+}
+
+size_t RenderCache::diskEntries() const {
+    std::lock_guard<std::mutex> lock(mu);
+    return disk.size();
+}
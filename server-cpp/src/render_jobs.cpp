@@ -0,0 +1,358 @@
+#include "../include/render_jobs.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <unistd.h>
+
+namespace {
+
+const size_t kMaxFinishedJobs = 100;
+
+int64_t nowMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+}
+
+RenderJobManager::RenderJobManager(const std::string& outputDir, int workers, size_t maxQueued, Emitter emit,
+                                   RenderCache* cache)
+    : outputDir(outputDir), maxQueued(maxQueued), emit(emit), cache(cache), stopping(false), sequence(0) {
+    if (workers < 1) workers = 1;
+    for (int i = 0; i < workers; ++i) {
+        threads.emplace_back([this]() { this->workerLoop(false); });
+    }
+    threads.emplace_back([this]() { this->workerLoop(true); });
+    std::cout << "🧵 Render job pool started: " << workers << " workers + preview lane, max queued " << maxQueued << std::endl;
+}
+
+RenderJobManager::~RenderJobManager() {
+    shutdown();
+}
+
+void RenderJobManager::shutdown() {
+    std::deque<std::shared_ptr<RenderJob>> pending;
+    std::vector<RenderJobInfo> pendingInfo;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        if (stopping) return;
+        stopping = true;
+        for (auto& entry : jobs) {
+            entry.second->cancelRequested = true;
+        }
+        pending.swap(queue);
+        for (auto& job : pending) {
+            job->state = RenderJobState::Cancelled;
+            job->finishedAt = nowMillis();
+            pendingInfo.push_back(snapshotLocked(*job));
+        }
+    }
+    cv.notify_all();
+    for (auto& t : threads) {
+        if (t.joinable()) t.join();
+    }
+    threads.clear();
+    // Job yang belum sempat jalan tetap mendapat completion supaya request yang menunggu tidak menggantung
+    const std::vector<unsigned char> none;
+    for (size_t i = 0; i < pending.size(); ++i) {
+        finishJob(pending[i], pendingInfo[i], none);
+    }
+}
+
+std::string RenderJobManager::nextJobId() {
+    char buf[48];
+    snprintf(buf, sizeof(buf), "%lld-%llu", (long long)nowMillis(), ++sequence);
+    return buf;
+}
+
+std::vector<RenderOutput> RenderJobManager::resolveOutputs(const CompiledLayout& layout, const std::string& cacheKey,
+                                                          const std::vector<RenderOutput>& outputs) {
+    std::vector<RenderOutput> resolved;
+    for (RenderOutput out : outputs) {
+        if (out.width <= 0 && out.height <= 0) continue;
+        if (out.width <= 0) out.width = (int)((long long)layout.width * out.height / layout.height);
+        if (out.height <= 0) out.height = (int)((long long)layout.height * out.width / layout.width);
+        out.width = std::max(1, std::min(out.width, layout.width));
+        out.height = std::max(1, std::min(out.height, layout.height));
+        out.quality = std::max(1, std::min(out.quality, 100));
+        out.cacheKey = RenderCache::variantKey(cacheKey, out.width, out.height, out.quality);
+        resolved.push_back(out);
+    }
+    return resolved;
+}
+
+bool RenderJobManager::submit(const std::shared_ptr<const CompiledLayout>& layout, const std::vector<std::string>& photoPaths, std::string& jobId,
+                              Completion onFinished, const std::vector<RenderOutput>& outputs, bool preview) {
+    std::shared_ptr<RenderJob> job;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        if (stopping || queue.size() >= maxQueued) {
+            return false;
+        }
+        pruneFinishedLocked();
+        job = std::make_shared<RenderJob>();
+        job->cacheKey = cache ? RenderCache::makeKey(*layout, photoPaths) : "";
+        do {
+            job->id = nextJobId();
+            // Dengan cache, path output = alamat konten; render identik menghasilkan file yang sama
+            job->outputPath = job->cacheKey.empty() ? outputDir + "/render_" + job->id + ".jpg" : cache->pathFor(job->cacheKey);
+        } while (jobs.count(job->id) || (job->cacheKey.empty() && access(job->outputPath.c_str(), F_OK) == 0));
+        job->outputs = resolveOutputs(*layout, job->cacheKey, outputs);
+        for (auto& out : job->outputs) {
+            out.path = out.cacheKey.empty() ? outputDir + "/render_" + job->id + "_" + out.name + ".jpg" : cache->pathFor(out.cacheKey);
+        }
+        job->layout = layout;
+        job->photoPaths = photoPaths;
+        job->onFinished = onFinished;
+        job->createdAt = nowMillis();
+        job->preview = preview;
+        jobs[job->id] = job;
+        if (preview) {
+            // Di belakang preview lain, di depan semua render penuh
+            auto pos = std::find_if(queue.begin(), queue.end(), [](const std::shared_ptr<RenderJob>& q) { return !q->preview; });
+            queue.insert(pos, job);
+        } else {
+            queue.push_back(job);
+        }
+        jobId = job->id;
+    }
+    // Semua worker dibangunkan: notify_one bisa jatuh ke worker preview yang tidak boleh mengambil job ini
+    cv.notify_all();
+    return true;
+}
+
+bool RenderJobManager::get(const std::string& jobId, RenderJobInfo& info) const {
+    std::lock_guard<std::mutex> lock(mu);
+    auto it = jobs.find(jobId);
+    if (it == jobs.end()) return false;
+    info = snapshotLocked(*it->second);
+    return true;
+}
+
+bool RenderJobManager::cancel(const std::string& jobId) {
+    std::shared_ptr<RenderJob> job;
+    RenderJobInfo info;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        auto it = jobs.find(jobId);
+        if (it == jobs.end()) return false;
+        job = it->second;
+        if (job->state == RenderJobState::Queued) {
+            // Belum jalan: langsung keluarkan dari antrian
+            for (auto q = queue.begin(); q != queue.end(); ++q) {
+                if (*q == job) { queue.erase(q); break; }
+            }
+            job->state = RenderJobState::Cancelled;
+            job->finishedAt = nowMillis();
+            info = snapshotLocked(*job);
+            pruneFinishedLocked();
+        } else if (job->state == RenderJobState::Running) {
+            job->cancelRequested = true;
+            return true;
+        } else {
+            return false;
+        }
+    }
+    finishJob(job, info, std::vector<unsigned char>());
+    return true;
+}
+
+void RenderJobManager::workerLoop(bool previewLane) {
+    for (;;) {
+        std::shared_ptr<RenderJob> job;
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            cv.wait(lock, [this, previewLane]() {
+                return stopping || (!queue.empty() && (!previewLane || queue.front()->preview));
+            });
+            if (stopping) return;
+            job = queue.front();
+            queue.pop_front();
+            job->state = RenderJobState::Running;
+        }
+        runJob(job);
+    }
+}
+
+void RenderJobManager::runJob(const std::shared_ptr<RenderJob>& job) {
+    auto started = std::chrono::steady_clock::now();
+    float lastEmitted = 0.0f;
+    auto progress = [this, &job, &lastEmitted](float fraction) {
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            job->progress = fraction;
+        }
+        if (emit && !job->preview && fraction - lastEmitted >= 0.1f) {
+            lastEmitted = fraction;
+            emit("render-progress", {{"jobId", job->id}, {"progress", std::to_string(static_cast<int>(fraction * 100.0f))}});
+        }
+        return !job->cancelRequested.load();
+    };
+
+    TemplateRenderer renderer;
+    std::vector<unsigned char> jpeg;
+    std::vector<std::vector<unsigned char>> extra;
+    bool ok;
+    if (job->outputs.empty()) {
+        ok = renderer.renderLayout(*job->layout, job->photoPaths, jpeg, progress);
+    } else {
+        // Satu kanvas untuk semua ukuran: level 0 = output utama, sisanya output tambahan
+        std::vector<OutputLevel> levels(1);
+        levels[0].width = job->layout->width;
+        levels[0].height = job->layout->height;
+        levels[0].quality = job->layout->quality;
+        for (const auto& out : job->outputs) {
+            OutputLevel level;
+            level.width = out.width;
+            level.height = out.height;
+            level.quality = out.quality;
+            levels.push_back(level);
+        }
+        std::vector<std::vector<unsigned char>> encoded;
+        ok = renderer.renderPyramid(*job->layout, job->photoPaths, levels, encoded, progress);
+        if (ok) {
+            jpeg.swap(encoded[0]);
+            extra.assign(std::make_move_iterator(encoded.begin() + 1), std::make_move_iterator(encoded.end()));
+        }
+    }
+    std::string error;
+    if (job->cancelRequested) {
+        ok = false;
+    } else if (!ok) {
+        error = "render_failed";
+    } else {
+        ok = writeOutput(job->outputPath, job->cacheKey, jpeg);
+        for (size_t i = 0; ok && i < extra.size(); ++i) {
+            ok = writeOutput(job->outputs[i].path, job->outputs[i].cacheKey, extra[i]);
+        }
+        if (!ok) error = "write_failed";
+    }
+
+    RenderJobInfo info;
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        if (ok) {
+            job->state = RenderJobState::Done;
+            job->progress = 1.0f;
+        } else if (job->cancelRequested) {
+            job->state = RenderJobState::Cancelled;
+        } else {
+            job->state = RenderJobState::Failed;
+            job->error = error;
+        }
+        job->finishedAt = nowMillis();
+        job->layout.reset();
+        info = snapshotLocked(*job);
+        pruneFinishedLocked();
+    }
+
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - started).count();
+    std::cout << "🖼️ Render job " << info.id << " " << stateName(info.state) << " in " << ms << "ms" << std::endl;
+    finishJob(job, info, jpeg);
+}
+
+bool RenderJobManager::writeOutput(const std::string& path, const std::string& cacheKey, const std::vector<unsigned char>& jpeg) {
+    if (!cacheKey.empty()) {
+        return cache->store(cacheKey, jpeg);
+    }
+    // Tulis ke file sementara lalu rename supaya klien tidak pernah melihat file setengah jadi
+    std::string tmpPath = path + ".part";
+    std::ofstream ofs(tmpPath, std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(jpeg.data()), (std::streamsize)jpeg.size());
+    ofs.close();
+    if (!ofs || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+void RenderJobManager::finishJob(const std::shared_ptr<RenderJob>& job, const RenderJobInfo& info,
+                                 const std::vector<unsigned char>& jpeg) {
+    if (emit && !job->preview) {
+        std::map<std::string, std::string> data;
+        data["jobId"] = info.id;
+        data["success"] = info.state == RenderJobState::Done ? "true" : "false";
+        data["status"] = stateName(info.state);
+        if (info.state == RenderJobState::Done) {
+            data["url"] = outputUrl(info.outputPath);
+            for (const auto& out : info.outputs) data["outputs." + out.name] = outputUrl(out.path);
+        }
+        if (!info.error.empty()) data["error"] = info.error;
+        emit("render-done", data);
+    }
+    if (job->onFinished) {
+        job->onFinished(info, jpeg);
+        job->onFinished = nullptr;
+    }
+}
+
+void RenderJobManager::pruneFinishedLocked() {
+    std::vector<std::shared_ptr<RenderJob>> finished;
+    for (const auto& entry : jobs) {
+        RenderJobState st = entry.second->state;
+        if (st != RenderJobState::Queued && st != RenderJobState::Running) {
+            finished.push_back(entry.second);
+        }
+    }
+    if (finished.size() <= kMaxFinishedJobs) return;
+    std::sort(finished.begin(), finished.end(), [](const std::shared_ptr<RenderJob>& a, const std::shared_ptr<RenderJob>& b) {
+        return a->finishedAt < b->finishedAt;
+    });
+    for (size_t i = 0; i + kMaxFinishedJobs < finished.size(); ++i) {
+        jobs.erase(finished[i]->id);
+    }
+}
+
+RenderJobInfo RenderJobManager::snapshotLocked(const RenderJob& job) const {
+    RenderJobInfo info;
+    info.id = job.id;
+    info.state = job.state;
+    info.progress = job.progress;
+    info.outputPath = job.outputPath;
+    info.outputs = job.outputs;
+    info.error = job.error;
+    return info;
+}
+
+std::string RenderJobManager::outputUrl(const std::string& outputPath) {
+    return RenderCache::urlFor(outputPath);
+}
+
+const char* RenderJobManager::stateName(RenderJobState state) {
+    switch (state) {
+        case RenderJobState::Queued: return "queued";
+        case RenderJobState::Running: return "running";
+        case RenderJobState::Done: return "done";
+        case RenderJobState::Failed: return "failed";
+        case RenderJobState::Cancelled: return "cancelled";
+    }
+    return "unknown";
+}
+
+std::string RenderJobManager::toJson(const RenderJobInfo& info) {
+    std::ostringstream oss;
+    oss << "{\"jobId\":\"" << info.id << "\",\"status\":\"" << stateName(info.state)
+        << "\",\"progress\":" << static_cast<int>(info.progress * 100.0f);
+    if (info.state == RenderJobState::Done) {
+        oss << ",\"url\":\"" << outputUrl(info.outputPath) << "\"";
+    }
+    if (info.state == RenderJobState::Done && !info.outputs.empty()) {
+        oss << ",\"outputs\":{";
+        for (size_t i = 0; i < info.outputs.size(); ++i) {
+            const RenderOutput& out = info.outputs[i];
+            oss << (i ? "," : "") << "\"" << out.name << "\":{\"url\":\"" << outputUrl(out.path) << "\",\"width\":"
+                << out.width << ",\"height\":" << out.height << ",\"quality\":" << out.quality << "}";
+        }
+        oss << "}";
+    }
+    if (!info.error.empty()) {
+        oss << ",\"error\":\"" << info.error << "\"";
+    }
+    oss << "}";
+    return oss.str();
+}
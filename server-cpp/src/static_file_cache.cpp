@@ -0,0 +1,183 @@
+#include "../include/static_file_cache.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+int64_t mtimeNsOf(const struct stat& st) {
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+std::string httpDate(time_t t) {
+    struct tm tmv;
+    gmtime_r(&t, &tmv);
+    char buf[64];
+    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tmv);
+    return buf;
+}
+
+bool parseDigits(const std::string& s, uint64_t& out) {
+    if (s.empty() || s.size() > 19) return false;
+    out = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+        out = out * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return true;
+}
+
+std::string trim(const std::string& s) {
+    size_t a = s.find_first_not_of(" \t");
+    if (a == std::string::npos) return "";
+    size_t b = s.find_last_not_of(" \t");
+    return s.substr(a, b - a + 1);
+}
+
+}
+
+StaticFileCache::File::~File() {
+    if (fd >= 0) close(fd);
+}
+
+bool StaticFileCache::File::read(uint64_t offset, uint64_t length, std::string& out) const {
+    out.resize(static_cast<size_t>(length));
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = pread(fd, &out[done], static_cast<size_t>(length) - done, static_cast<off_t>(offset + done));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) {
+            out.clear();
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+StaticFileCache::StaticFileCache(size_t maxOpenFiles) : maxOpen(maxOpenFiles > 0 ? maxOpenFiles : 1) {}
+
+std::shared_ptr<const StaticFileCache::File> StaticFileCache::open(const std::string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+        invalidate(path);
+        return nullptr;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        auto it = index.find(path);
+        if (it != index.end()) {
+            const File& f = *it->second->second;
+            if (f.inode == static_cast<uint64_t>(st.st_ino) && f.size == static_cast<uint64_t>(st.st_size) &&
+                f.mtimeNs == mtimeNsOf(st)) {
+                lru.splice(lru.begin(), lru, it->second);
+                return lru.front().second;
+            }
+        }
+    }
+
+    // Versi baru (atau belum pernah dibuka): buka di luar lock, metadata diambil dari fd itu sendiri
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    auto file = std::make_shared<File>();
+    file->fd = fd;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) return nullptr;
+    file->size = static_cast<uint64_t>(st.st_size);
+    file->inode = static_cast<uint64_t>(st.st_ino);
+    file->mtimeNs = mtimeNsOf(st);
+    char etag[64];
+    snprintf(etag, sizeof(etag), "\"%llx-%llx-%llx\"", static_cast<unsigned long long>(file->inode),
+             static_cast<unsigned long long>(file->size), static_cast<unsigned long long>(file->mtimeNs));
+    file->etag = etag;
+    file->lastModified = httpDate(st.st_mtim.tv_sec);
+#ifdef POSIX_FADV_SEQUENTIAL
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    std::lock_guard<std::mutex> lock(mu);
+    auto it = index.find(path);
+    if (it != index.end()) lru.erase(it->second);
+    lru.emplace_front(path, file);
+    index[path] = lru.begin();
+    // fd ditutup saat request terakhir yang memegang entri selesai
+    while (lru.size() > maxOpen) {
+        index.erase(lru.back().first);
+        lru.pop_back();
+    }
+    return file;
+}
+
+void StaticFileCache::invalidate(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mu);
+    auto it = index.find(path);
+    if (it == index.end()) return;
+    lru.erase(it->second);
+    index.erase(it);
+}
+
+size_t StaticFileCache::openFiles() const {
+    std::lock_guard<std::mutex> lock(mu);
+    return lru.size();
+}
+
+ByteRange parseByteRange(const std::string& header, uint64_t size) {
+    ByteRange r;
+    std::string h = trim(header);
+    if (h.compare(0, 6, "bytes=") != 0) return r;
+    std::string spec = trim(h.substr(6));
+    if (spec.find(',') != std::string::npos) return r;
+    size_t dash = spec.find('-');
+    if (dash == std::string::npos) return r;
+    std::string a = trim(spec.substr(0, dash));
+    std::string b = trim(spec.substr(dash + 1));
+
+    uint64_t first = 0, last = 0;
+    if (a.empty()) {
+        // Suffix: n byte terakhir
+        uint64_t n = 0;
+        if (!parseDigits(b, n)) return r;
+        if (n == 0 || size == 0) {
+            r.kind = ByteRange::Unsatisfiable;
+            return r;
+        }
+        r.kind = ByteRange::Satisfiable;
+        r.length = n < size ? n : size;
+        r.first = size - r.length;
+        return r;
+    }
+    if (!parseDigits(a, first)) return r;
+    if (b.empty()) {
+        last = size > 0 ? size - 1 : 0;
+    } else if (!parseDigits(b, last) || last < first) {
+        return r;
+    }
+    if (first >= size) {
+        r.kind = ByteRange::Unsatisfiable;
+        return r;
+    }
+    if (last >= size) last = size - 1;
+    r.kind = ByteRange::Satisfiable;
+    r.first = first;
+    r.length = last - first + 1;
+    return r;
+}
+
+bool etagMatches(const std::string& ifNoneMatch, const std::string& etag) {
+    const std::string opaque = etag.compare(0, 2, "W/") == 0 ? etag.substr(2) : etag;
+    size_t pos = 0;
+    while (pos <= ifNoneMatch.size()) {
+        size_t comma = ifNoneMatch.find(',', pos);
+        if (comma == std::string::npos) comma = ifNoneMatch.size();
+        std::string tag = trim(ifNoneMatch.substr(pos, comma - pos));
+        if (tag == "*") return true;
+        if (tag.compare(0, 2, "W/") == 0) tag = tag.substr(2);
+        if (!tag.empty() && tag == opaque) return true;
+        pos = comma + 1;
+    }
+    return false;
+}
@@ -1,19 +1,46 @@
 #include "../include/template_renderer.h"
 #include "../include/stb_image.h"
-#include "../include/stb_image_write.h"
+#include "../include/jpeg_codec.h"
+#include "../include/glyph_atlas.h"
+#include "../include/parallel.h"
+#include "../include/affine_layer.h"
 #include <fstream>
+#include <iostream>
 #include <cmath>
 #include <algorithm>
+#include <cstdio>
+#include <sys/stat.h>
 
 TemplateRenderer::TemplateRenderer() {}
 TemplateRenderer::~TemplateRenderer() {}
 
 static inline unsigned char clampu8(int v) { return (unsigned char)(v < 0 ? 0 : (v > 255 ? 255 : v)); }
 
-RgbaImage TemplateRenderer::loadImageRGBA(const std::string& path) {
+RgbaImage TemplateRenderer::loadImageRGBA(const std::string& path, int boxW, int boxH, FitMode mode) {
     RgbaImage img;
+    std::vector<unsigned char> bytes;
+    if (!readFileBytes(path, bytes)) {
+        return img;
+    }
+    if (isJpegData(bytes.data(), bytes.size())) {
+        // JPEG: decode langsung di skala DCT terkecil yang masih cukup untuk target,
+        // sisanya diselesaikan resizeImage
+        int w=0,h=0;
+        if (jpegReadDimensions(bytes.data(), bytes.size(), w, h)) {
+            int denom = 1;
+            if (boxW>0 && boxH>0) {
+                int needW=0, needH=0;
+                fitSize(w, h, boxW, boxH, mode, needW, needH);
+                denom = jpegChooseScaleDenom(w, h, needW, needH);
+            }
+            if (jpegDecodeScaled(bytes.data(), bytes.size(), denom, 4, img.data, img.width, img.height)) {
+                return img;
+            }
+        }
+        img = RgbaImage();
+    }
     int x=0,y=0,n=0;
-    unsigned char* data = stbi_load(path.c_str(), &x, &y, &n, 4);
+    unsigned char* data = stbi_load_from_memory(bytes.data(), (int)bytes.size(), &x, &y, &n, 4);
     if (!data) {
         return img;
     }
@@ -24,65 +51,525 @@ RgbaImage TemplateRenderer::loadImageRGBA(const std::string& path) {
     return img;
 }
 
+void TemplateRenderer::fitSize(int srcW, int srcH, int boxW, int boxH, FitMode mode, int& outW, int& outH) {
+    outW = boxW; outH = boxH;
+    if (mode == FitMode::Stretch || srcW<=0 || srcH<=0) return;
+    if (mode == FitMode::Cover) {
+        double scale = std::max((double)boxW / (double)srcW, (double)boxH / (double)srcH);
+        outW = std::max(boxW, (int)std::ceil(srcW * scale - 1e-6));
+        outH = std::max(boxH, (int)std::ceil(srcH * scale - 1e-6));
+        return;
+    }
+    outW = boxW;
+    outH = (int)((double)srcH * ((double)outW / (double)srcW));
+    if (outH > boxH) {
+        outH = boxH;
+        outW = (int)((double)srcW * ((double)outH / (double)srcH));
+    }
+    outW = std::max(outW, 1);
+    outH = std::max(outH, 1);
+}
+
+// Sumber baris RGBA. Sumber streaming hanya menjamin akses dengan y yang tidak mundur
+class RowSource {
+public:
+    virtual ~RowSource() {}
+    virtual int width() const = 0;
+    virtual int height() const = 0;
+    virtual const unsigned char* row(int y) = 0;
+    // true bila decode berhenti di tengah gambar: baris sesudahnya kosong (transparan), render
+    // yang memakainya harus dibatalkan, bukan dikomposit
+    bool failed() const { return decodeFailed; }
+    void markFailed() { decodeFailed = true; }
+private:
+    bool decodeFailed = false;
+};
+
+namespace {
+
+const int kStripRows = 16;
+
+class ImageRowSource : public RowSource {
+public:
+    explicit ImageRowSource(const RgbaImage& img) : img(img) {}
+    int width() const override { return img.width; }
+    int height() const override { return img.height; }
+    const unsigned char* row(int y) override { return img.data.data() + (size_t)y * img.width * 4; }
+private:
+    const RgbaImage& img;
+};
+
+class OwnedImageRowSource : public RowSource {
+public:
+    explicit OwnedImageRowSource(RgbaImage&& img) : img(std::move(img)) {}
+    int width() const override { return img.width; }
+    int height() const override { return img.height; }
+    const unsigned char* row(int y) override { return img.data.data() + (size_t)y * img.width * 4; }
+private:
+    RgbaImage img;
+};
+
+// Bitmap yang dibagi antar render (mis. aset preview yang sudah di-downscale)
+class SharedImageRowSource : public RowSource {
+public:
+    explicit SharedImageRowSource(std::shared_ptr<const RgbaImage> img) : img(std::move(img)) {}
+    int width() const override { return img->width; }
+    int height() const override { return img->height; }
+    const unsigned char* row(int y) override { return img->data.data() + (size_t)y * img->width * 4; }
+private:
+    std::shared_ptr<const RgbaImage> img;
+};
+
+// Decode JPEG sambil jalan: satu baris output libjpeg di memori, bukan seluruh bitmap
+class JpegRowSource : public RowSource {
+public:
+    JpegScanlineReader reader;
+
+    bool start(int scaleDenom) {
+        if (!reader.start(scaleDenom, 4)) return false;
+        buf.assign((size_t)reader.width() * 4, 0);
+        return true;
+    }
+    int width() const override { return reader.width(); }
+    int height() const override { return reader.height(); }
+    const unsigned char* row(int y) override {
+        while (current < y && !failed()) {
+            if (!reader.readRow(buf.data())) {
+                // Jangan kembalikan scanline sebelumnya seolah valid
+                std::fill(buf.begin(), buf.end(), 0);
+                markFailed();
+                break;
+            }
+            ++current;
+        }
+        return buf.data();
+    }
+private:
+    std::vector<unsigned char> buf;
+    int current = -1;
+};
+
+// Bobot filter tenda per sumbu; support melebar saat downscale sehingga
+// setiap piksel output merata-ratakan seluruh area sumbernya (anti-alias)
+struct AxisWeights {
+    std::vector<int> start;
+    std::vector<int> count;
+    std::vector<int> offset;
+    std::vector<float> weights;
+    int maxCount = 0;
+};
+
+AxisWeights computeAxisWeights(int srcLen, int dstLen) {
+    AxisWeights aw;
+    aw.start.resize(dstLen); aw.count.resize(dstLen); aw.offset.resize(dstLen);
+    const double scale = (double)dstLen / (double)srcLen;
+    const double support = scale < 1.0 ? 1.0 / scale : 1.0;
+    for (int i=0;i<dstLen;++i) {
+        double center = (i + 0.5) / scale - 0.5;
+        int lo = std::max((int)std::floor(center - support) + 1, 0);
+        int hi = std::min((int)std::ceil(center + support) - 1, srcLen-1);
+        if (hi < lo) {
+            lo = hi = std::min(std::max((int)std::lround(center), 0), srcLen-1);
+        }
+        aw.offset[i] = (int)aw.weights.size();
+        float sum = 0.0f;
+        for (int x=lo;x<=hi;++x) {
+            float w = (float)(1.0 - std::fabs(x - center) / support);
+            if (w < 0.0f) w = 0.0f;
+            aw.weights.push_back(w);
+            sum += w;
+        }
+        int n = hi - lo + 1;
+        for (int k=0;k<n;++k) {
+            aw.weights[aw.offset[i]+k] = sum > 0.0f ? aw.weights[aw.offset[i]+k] / sum : (k==0 ? 1.0f : 0.0f);
+        }
+        aw.start[i] = lo;
+        aw.count[i] = n;
+        aw.maxCount = std::max(aw.maxCount, n);
+    }
+    return aw;
+}
+
+// Resampler separable yang menghasilkan baris output satu per satu. Baris sumber
+// yang sudah di-resample horizontal disimpan di ring kecil (premultiplied alpha),
+// jadi baris sumber diminta berurutan dan memori tidak bergantung tinggi gambar
+class ScanlineResizer {
+public:
+    ScanlineResizer(RowSource& src, int w, int h)
+        : src(src), w(w), passthrough(src.width() == w && src.height() == h) {
+        if (passthrough) return;
+        xw = computeAxisWeights(src.width(), w);
+        yw = computeAxisWeights(src.height(), h);
+        ring.assign(yw.maxCount, std::vector<float>((size_t)w*4));
+        ringRow.assign(yw.maxCount, -1);
+        accRow.resize((size_t)w*4);
+    }
+
+    void row(int y, unsigned char* out) {
+        if (passthrough) {
+            const unsigned char* sr = src.row(y);
+            std::copy(sr, sr + (size_t)w*4, out);
+            return;
+        }
+        const int s = yw.start[y], n = yw.count[y];
+        const float* wy = &yw.weights[yw.offset[y]];
+        std::fill(accRow.begin(), accRow.end(), 0.0f);
+        for (int k=0;k<n;++k) {
+            const float* hr = horizontalRow(s + k);
+            const float wk = wy[k];
+            for (int i=0;i<w*4;++i) accRow[i] += hr[i] * wk;
+        }
+        for (int i=0;i<w;++i) {
+            const float a = accRow[i*4+3];
+            if (a <= 0.0f) {
+                out[i*4+0] = out[i*4+1] = out[i*4+2] = out[i*4+3] = 0;
+                continue;
+            }
+            const float inv = 1.0f / a;
+            out[i*4+0] = clampu8((int)(accRow[i*4+0] * inv + 0.5f));
+            out[i*4+1] = clampu8((int)(accRow[i*4+1] * inv + 0.5f));
+            out[i*4+2] = clampu8((int)(accRow[i*4+2] * inv + 0.5f));
+            out[i*4+3] = clampu8((int)(a + 0.5f));
+        }
+    }
+
+private:
+    const float* horizontalRow(int sy) {
+        const int slot = sy % (int)ring.size();
+        std::vector<float>& dst = ring[slot];
+        if (ringRow[slot] == sy) return dst.data();
+        const unsigned char* sr = src.row(sy);
+        for (int i=0;i<w;++i) {
+            const float* wx = &xw.weights[xw.offset[i]];
+            const unsigned char* px = sr + (size_t)xw.start[i] * 4;
+            float r=0.0f, g=0.0f, b=0.0f, a=0.0f;
+            for (int k=0;k<xw.count[i];++k, px+=4) {
+                const float wa = wx[k] * px[3];
+                r += px[0] * wa; g += px[1] * wa; b += px[2] * wa; a += wa;
+            }
+            dst[i*4+0] = r; dst[i*4+1] = g; dst[i*4+2] = b; dst[i*4+3] = a;
+        }
+        ringRow[slot] = sy;
+        return dst.data();
+    }
+
+    RowSource& src;
+    int w;
+    bool passthrough;
+    AxisWeights xw;
+    AxisWeights yw;
+    std::vector<std::vector<float>> ring;
+    std::vector<int> ringRow;
+    std::vector<float> accRow;
+};
+
+void copyRow(unsigned char* dst, const unsigned char* src, int n) {
+    std::copy(src, src + (size_t)n*4, dst);
+}
+
+void blendRow(unsigned char* dst, const unsigned char* src, int n) {
+    for (int i=0;i<n;++i, dst+=4, src+=4) {
+        unsigned char sa = src[3];
+        if (sa == 255) {
+            dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = 255;
+        } else if (sa != 0) {
+            float a = sa / 255.0f;
+            dst[0] = clampu8((int)(src[0]*a + dst[0]*(1.0f-a)));
+            dst[1] = clampu8((int)(src[1]*a + dst[1]*(1.0f-a)));
+            dst[2] = clampu8((int)(src[2]*a + dst[2]*(1.0f-a)));
+            dst[3] = 255;
+        }
+    }
+}
+
+// Satu layer komposit: sumber baris + resizer ke kotak tujuannya di kanvas.
+// Clip membatasi layer ke slotnya (mode cover); mask = coverage 8-bit seukuran clip
+struct RenderLayer {
+    std::unique_ptr<RowSource> source;
+    std::unique_ptr<ScanlineResizer> resizer;
+    int x = 0, y = 0, w = 0, h = 0;
+    int clipX0 = 0, clipY0 = 0, clipX1 = 0, clipY1 = 0;
+    bool blend = false;
+    std::shared_ptr<std::vector<unsigned char>> mask;
+    std::unique_ptr<AffineLayer> affine;
+    std::vector<unsigned char> row;
+    std::vector<unsigned char> masked;
+};
+
+RenderLayer* addLayer(std::vector<RenderLayer>& layers, std::unique_ptr<RowSource> source,
+                      int x, int y, int w, int h, bool blend) {
+    if (!source || w<=0 || h<=0) return nullptr;
+    RenderLayer layer;
+    layer.source = std::move(source);
+    layer.resizer.reset(new ScanlineResizer(*layer.source, w, h));
+    layer.x = x; layer.y = y; layer.w = w; layer.h = h;
+    layer.clipX0 = x; layer.clipY0 = y; layer.clipX1 = x + w; layer.clipY1 = y + h;
+    layer.blend = blend;
+    layer.row.resize((size_t)w*4);
+    layers.push_back(std::move(layer));
+    return &layers.back();
+}
+
+// Komposit baris [y0, y0+strip.height) dari setiap layer ke strip. false bila sumber layer
+// gagal di-decode di tengah jalan
+bool composeStrip(std::vector<RenderLayer>& layers, RgbaImage& strip, int y0) {
+    for (auto& layer : layers) {
+        if (layer.affine) {
+            // Sticker: hanya bounding box hasil transform yang disentuh
+            layer.affine->drawRows(strip.data.data(), strip.width, y0, strip.height);
+            continue;
+        }
+        const int from = std::max(y0, std::max(layer.y, layer.clipY0));
+        const int to = std::min(y0 + strip.height, std::min(layer.y + layer.h, layer.clipY1));
+        const int dx0 = std::max(std::max(layer.x, 0), layer.clipX0);
+        const int dx1 = std::min(std::min(layer.x + layer.w, strip.width), layer.clipX1);
+        if (from >= to || dx0 >= dx1) continue;
+        const int clipW = layer.clipX1 - layer.clipX0;
+        for (int cy=from; cy<to; ++cy) {
+            layer.resizer->row(cy - layer.y, layer.row.data());
+            unsigned char* dst = strip.data.data() + ((size_t)(cy - y0) * strip.width + dx0) * 4;
+            const unsigned char* src = layer.row.data() + (size_t)(dx0 - layer.x) * 4;
+            if (layer.mask) {
+                // Alpha sumber dikali coverage mask, lalu di-blend seperti overlay
+                const unsigned char* cov = layer.mask->data() + (size_t)(cy - layer.clipY0) * clipW + (dx0 - layer.clipX0);
+                layer.masked.resize((size_t)(dx1 - dx0) * 4);
+                for (int i=0;i<dx1-dx0;++i) {
+                    layer.masked[i*4+0] = src[i*4+0];
+                    layer.masked[i*4+1] = src[i*4+1];
+                    layer.masked[i*4+2] = src[i*4+2];
+                    layer.masked[i*4+3] = (unsigned char)((src[i*4+3] * cov[i] + 127) / 255);
+                }
+                blendRow(dst, layer.masked.data(), dx1 - dx0);
+            } else if (layer.blend) {
+                blendRow(dst, src, dx1 - dx0);
+            } else {
+                copyRow(dst, src, dx1 - dx0);
+            }
+        }
+        if (layer.source->failed()) return false;
+    }
+    return true;
+}
+
+// Aset background/overlay yang sudah di-resize ke ukuran preview. Preview berikutnya
+// dengan template yang sama tidak perlu decode + resize ulang
+class ScaledAssetCache {
+public:
+    std::shared_ptr<const RgbaImage> get(const std::string& key) {
+        std::lock_guard<std::mutex> lock(mu);
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->first == key) {
+                entries.splice(entries.begin(), entries, it);
+                return it->second;
+            }
+        }
+        return nullptr;
+    }
+    void put(const std::string& key, const std::shared_ptr<const RgbaImage>& img) {
+        std::lock_guard<std::mutex> lock(mu);
+        entries.emplace_front(key, img);
+        bytes += img->data.size();
+        while (bytes > kMaxBytes && entries.size() > 1) {
+            bytes -= entries.back().second->data.size();
+            entries.pop_back();
+        }
+    }
+private:
+    static const size_t kMaxBytes = 48u * 1024 * 1024;
+    std::mutex mu;
+    std::list<std::pair<std::string, std::shared_ptr<const RgbaImage>>> entries;
+    size_t bytes = 0;
+};
+
+ScaledAssetCache& scaledAssetCache() {
+    static ScaledAssetCache cache;
+    return cache;
+}
+
+}
+
+namespace {
+
+// Batas bitmap hasil decode paralel per sumber. Di atas ini (mis. original DSLR pada denom 1/2
+// untuk print) tetap di-stream supaya memori render tetap sebatas strip, juga di template multi-slot
+const size_t kParallelDecodeMaxBytes = 8u * 1024 * 1024;
+
+// JPEG ber-restart marker (umumnya original DSLR) yang hasil skalanya kecil di-decode paralel ke
+// bitmap; tanpa restart marker, hasil besar, atau di mesin satu core tetap di-stream baris per baris
+std::unique_ptr<RowSource> decodeRestartJpeg(const std::string& path, const JpegScanlineReader& header, int denom) {
+    if (header.restartInterval() <= 0 || parallelThreads() <= 1) return nullptr;
+    const int d = denom > 0 ? denom : 1;
+    const size_t scaledBytes = (size_t)((header.imageWidth() + d - 1) / d) * ((header.imageHeight() + d - 1) / d) * 4;
+    if (scaledBytes > kParallelDecodeMaxBytes) return nullptr;
+    std::vector<unsigned char> bytes;
+    RgbaImage img;
+    if (!readFileBytes(path, bytes) ||
+        !jpegDecodeScaled(bytes.data(), bytes.size(), denom, 4, img.data, img.width, img.height)) {
+        return nullptr;
+    }
+    return std::unique_ptr<RowSource>(new OwnedImageRowSource(std::move(img)));
+}
+
+}
+
+std::unique_ptr<RowSource> TemplateRenderer::openRowSource(const std::string& path, int boxW, int boxH, FitMode mode) {
+    std::unique_ptr<JpegRowSource> jpeg(new JpegRowSource());
+    if (jpeg->reader.open(path)) {
+        int denom = 1;
+        if (boxW>0 && boxH>0) {
+            int needW=0, needH=0;
+            fitSize(jpeg->reader.imageWidth(), jpeg->reader.imageHeight(), boxW, boxH, mode, needW, needH);
+            denom = jpegChooseScaleDenom(jpeg->reader.imageWidth(), jpeg->reader.imageHeight(), needW, needH);
+        }
+        if (auto decoded = decodeRestartJpeg(path, jpeg->reader, denom)) {
+            return decoded;
+        }
+        if (jpeg->start(denom)) {
+            return std::unique_ptr<RowSource>(std::move(jpeg));
+        }
+    }
+    RgbaImage img = loadImageRGBA(path);
+    if (img.width<=0) return nullptr;
+    return std::unique_ptr<RowSource>(new OwnedImageRowSource(std::move(img)));
+}
+
+std::unique_ptr<RowSource> TemplateRenderer::openRowSource(const LayoutAsset& asset) {
+    std::unique_ptr<JpegRowSource> jpeg(new JpegRowSource());
+    if (jpeg->reader.open(asset.path)) {
+        if (auto decoded = decodeRestartJpeg(asset.path, jpeg->reader, asset.scaleDenom)) {
+            return decoded;
+        }
+        if (jpeg->start(asset.scaleDenom)) {
+            return std::unique_ptr<RowSource>(std::move(jpeg));
+        }
+    }
+    RgbaImage img = loadImageRGBA(asset.path);
+    if (img.width<=0) return nullptr;
+    return std::unique_ptr<RowSource>(new OwnedImageRowSource(std::move(img)));
+}
+
+std::unique_ptr<RowSource> TemplateRenderer::openScaledAsset(const LayoutAsset& asset, int w, int h) {
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), "|%lld|%dx%d", (long long)asset.mtime, w, h);
+    const std::string cacheKey = asset.path + suffix;
+    auto img = scaledAssetCache().get(cacheKey);
+    if (!img) {
+        auto source = openRowSource(asset);
+        if (!source) return nullptr;
+        auto scaled = std::make_shared<RgbaImage>();
+        scaled->width = w; scaled->height = h;
+        scaled->data.resize((size_t)w * h * 4);
+        ScanlineResizer resizer(*source, w, h);
+        for (int j=0;j<h;++j) {
+            resizer.row(j, scaled->data.data() + (size_t)j*w*4);
+        }
+        if (source->failed()) {
+            // Hasil setengah jadi tidak di-cache; kegagalannya diteruskan ke pemakai
+            std::unique_ptr<RowSource> partial(new OwnedImageRowSource(std::move(*scaled)));
+            partial->markFailed();
+            return partial;
+        }
+        img = scaled;
+        scaledAssetCache().put(cacheKey, img);
+    }
+    return std::unique_ptr<RowSource>(new SharedImageRowSource(img));
+}
+
+std::shared_ptr<std::vector<unsigned char>> TemplateRenderer::buildSlotMask(const CompiledLayer& layer, bool& decodeFailed) {
+    const int w = layer.w, h = layer.h;
+    const float r = std::min(layer.cornerRadius, 0.5f * (float)std::min(w, h));
+    if (r < 0.5f && layer.mask.path.empty()) return nullptr;
+    auto mask = std::make_shared<std::vector<unsigned char>>((size_t)w * h, 255);
+    if (!layer.mask.path.empty()) {
+        auto src = openScaledAsset(layer.mask, w, h);
+        if (src) {
+            for (int y=0;y<h;++y) {
+                const unsigned char* row = src->row(y);
+                unsigned char* out = mask->data() + (size_t)y * w;
+                for (int x=0;x<w;++x) out[x] = row[x*4+3];
+            }
+            if (src->failed()) decodeFailed = true;
+        }
+    }
+    if (r >= 0.5f) {
+        // Hanya empat kotak sudut r x r yang perlu dihitung; coverage anti-alias dari jarak ke pusat busur
+        const int ri = (int)std::ceil(r);
+        for (int y=0;y<std::min(ri, h);++y) {
+            for (int x=0;x<std::min(ri, w);++x) {
+                float dx = r - (x + 0.5f), dy = r - (y + 0.5f);
+                float cov = r + 0.5f - std::sqrt(dx*dx + dy*dy);
+                if (cov >= 1.0f) continue;
+                float c = cov <= 0.0f ? 0.0f : cov;
+                const int xs[2] = {x, w - 1 - x};
+                const int ys[2] = {y, h - 1 - y};
+                for (int yy : ys) {
+                    for (int xx : xs) {
+                        unsigned char& m = (*mask)[(size_t)yy * w + xx];
+                        m = (unsigned char)std::lround(m * c);
+                    }
+                }
+            }
+        }
+    }
+    return mask;
+}
+
+std::unique_ptr<AffineLayer> TemplateRenderer::openStickerLayer(const CompiledLayer& layer, bool preview, bool& decodeFailed) {
+    // Aset di-resize ke ukuran akhirnya dulu (filter area, bebas aliasing saat mengecil),
+    // sisanya tinggal rotasi + translasi yang di-sample bilinear oleh AffineLayer
+    auto source = preview ? openScaledAsset(layer.asset, layer.w, layer.h) : openRowSource(layer.asset);
+    if (!source) return nullptr;
+    const double c = std::cos(layer.rotation), s = std::sin(layer.rotation);
+    const double hw = 0.5 * layer.w, hh = 0.5 * layer.h;
+    const double forward[6] = {
+        c, -s, layer.centerX - c * hw + s * hh,
+        s,  c, layer.centerY - s * hw - c * hh
+    };
+    std::unique_ptr<AffineLayer> affine(new AffineLayer());
+    if (!affine->begin(layer.w, layer.h, forward)) return nullptr;
+    ScanlineResizer resizer(*source, layer.w, layer.h);
+    std::vector<unsigned char> row((size_t)layer.w * 4);
+    for (int j=0;j<layer.h;++j) {
+        resizer.row(j, row.data());
+        affine->setRow(j, row.data(), layer.opacity);
+    }
+    if (source->failed()) {
+        decodeFailed = true;
+        return nullptr;
+    }
+    return affine;
+}
+
 RgbaImage TemplateRenderer::resizeImage(const RgbaImage& src, int w, int h) {
     RgbaImage out;
     if (src.width<=0 || src.height<=0 || w<=0 || h<=0) return out;
+    if (src.width == w && src.height == h) return src;
     out.width = w; out.height = h; out.data.resize(w*h*4);
-    double sx = (double)src.width / (double)w;
-    double sy = (double)src.height / (double)h;
+    ImageRowSource rows(src);
+    ScanlineResizer resizer(rows, w, h);
     for (int j=0;j<h;++j) {
-        for (int i=0;i<w;++i) {
-            int srcX = std::min((int)std::floor(i*sx), src.width-1);
-            int srcY = std::min((int)std::floor(j*sy), src.height-1);
-            const int sIdx = (srcY*src.width + srcX)*4;
-            const int dIdx = (j*w + i)*4;
-            out.data[dIdx+0] = src.data[sIdx+0];
-            out.data[dIdx+1] = src.data[sIdx+1];
-            out.data[dIdx+2] = src.data[sIdx+2];
-            out.data[dIdx+3] = src.data[sIdx+3];
-        }
+        resizer.row(j, out.data.data() + (size_t)j*w*4);
     }
     return out;
 }
 
 void TemplateRenderer::blitImage(RgbaImage& dest, const RgbaImage& src, int x, int y) {
     if (dest.width<=0 || dest.height<=0 || src.width<=0 || src.height<=0) return;
+    const int dx0 = std::max(x, 0), dx1 = std::min(x + src.width, dest.width);
+    if (dx0 >= dx1) return;
     for (int j=0;j<src.height;++j) {
         int dy = y + j; if (dy<0 || dy>=dest.height) continue;
-        for (int i=0;i<src.width;++i) {
-            int dx = x + i; if (dx<0 || dx>=dest.width) continue;
-            int sIdx = (j*src.width + i)*4;
-            int dIdx = (dy*dest.width + dx)*4;
-            dest.data[dIdx+0] = src.data[sIdx+0];
-            dest.data[dIdx+1] = src.data[sIdx+1];
-            dest.data[dIdx+2] = src.data[sIdx+2];
-            dest.data[dIdx+3] = src.data[sIdx+3];
-        }
+        copyRow(&dest.data[((size_t)dy*dest.width + dx0)*4], &src.data[((size_t)j*src.width + (dx0 - x))*4], dx1 - dx0);
     }
 }
 
 void TemplateRenderer::blendImage(RgbaImage& dest, const RgbaImage& src, int x, int y) {
     if (dest.width<=0 || dest.height<=0 || src.width<=0 || src.height<=0) return;
+    const int dx0 = std::max(x, 0), dx1 = std::min(x + src.width, dest.width);
+    if (dx0 >= dx1) return;
     for (int j=0;j<src.height;++j) {
         int dy = y + j; if (dy<0 || dy>=dest.height) continue;
-        for (int i=0;i<src.width;++i) {
-            int dx = x + i; if (dx<0 || dx>=dest.width) continue;
-            int sIdx = (j*src.width + i)*4;
-            int dIdx = (dy*dest.width + dx)*4;
-            unsigned char sa = src.data[sIdx+3];
-            if (sa == 255) {
-                dest.data[dIdx+0] = src.data[sIdx+0];
-                dest.data[dIdx+1] = src.data[sIdx+1];
-                dest.data[dIdx+2] = src.data[sIdx+2];
-                dest.data[dIdx+3] = 255;
-            } else if (sa != 0) {
-                float a = sa / 255.0f;
-                dest.data[dIdx+0] = clampu8((int)(src.data[sIdx+0]*a + dest.data[dIdx+0]*(1.0f-a)));
-                dest.data[dIdx+1] = clampu8((int)(src.data[sIdx+1]*a + dest.data[dIdx+1]*(1.0f-a)));
-                dest.data[dIdx+2] = clampu8((int)(src.data[sIdx+2]*a + dest.data[dIdx+2]*(1.0f-a)));
-                dest.data[dIdx+3] = 255;
-            }
-        }
+        blendRow(&dest.data[((size_t)dy*dest.width + dx0)*4], &src.data[((size_t)j*src.width + (dx0 - x))*4], dx1 - dx0);
     }
 }
 
@@ -110,84 +597,608 @@ bool TemplateRenderer::parseColorHex(const std::string& hex, unsigned char& r, u
     return false;
 }
 
-void TemplateRenderer::drawText(RgbaImage& dest, const TextSpec& text) {
-    (void)dest; (void)text;
+bool TemplateRenderer::layoutText(const TextSpec& text, TextRun& run) {
+    run.atlas = GlyphAtlasCache::instance().acquire(text.fontPath, text.size, text.fontMtime);
+    if (!run.atlas) return false;
+    run.r = text.r; run.g = text.g; run.b = text.b;
+    return run.atlas->layout(text.content, text.x, text.y, run);
 }
 
-bool TemplateRenderer::writeJpegToFile(const RgbaImage& rgba, const std::string& path) {
-    if (rgba.width<=0 || rgba.height<=0 || rgba.data.empty()) return false;
-    std::vector<unsigned char> rgb(rgba.width*rgba.height*3);
-    for (int i=0;i<rgba.width*rgba.height;++i) {
-        rgb[i*3+0] = rgba.data[i*4+0];
-        rgb[i*3+1] = rgba.data[i*4+1];
-        rgb[i*3+2] = rgba.data[i*4+2];
+void TemplateRenderer::drawText(RgbaImage& dest, const TextRun& run, int originY) {
+    // Strip hanya menyentuh glyph yang memotong baris originY..originY+height
+    if (run.bottom <= originY || run.top >= originY + dest.height) return;
+    for (const auto& pg : run.glyphs) {
+        const GlyphBitmap* gl = pg.glyph;
+        int y0 = std::max(pg.y, originY);
+        int y1 = std::min(pg.y + gl->height, originY + dest.height);
+        int x0 = std::max(pg.x, 0);
+        int x1 = std::min(pg.x + gl->width, dest.width);
+        if (y0 >= y1 || x0 >= x1) continue;
+        for (int y = y0; y < y1; ++y) {
+            const unsigned char* cov = gl->pixels + (size_t)(y - pg.y) * gl->stride + (x0 - pg.x);
+            unsigned char* row = dest.data.data() + ((size_t)(y - originY) * dest.width + x0) * 4;
+            blendCoverageRow(row, cov, x1 - x0, run.r, run.g, run.b);
+        }
     }
-    return stbi_write_jpg(path.c_str(), rgba.width, rgba.height, 3, rgb.data(), 90) != 0;
 }
 
-static void write_to_vector(void* context, void* data, int size) {
-    std::vector<unsigned char>* v = reinterpret_cast<std::vector<unsigned char>*>(context);
-    unsigned char* p = reinterpret_cast<unsigned char*>(data);
-    v->insert(v->end(), p, p+size);
+bool TemplateRenderer::writeJpegToFile(const RgbaImage& rgba, const std::string& path) {
+    std::vector<unsigned char> buf;
+    if (!writeJpegToBuffer(rgba, buf)) return false;
+    std::ofstream ofs(path, std::ios::binary);
+    if (!ofs.is_open()) return false;
+    ofs.write(reinterpret_cast<const char*>(buf.data()), (std::streamsize)buf.size());
+    return true;
 }
 
 bool TemplateRenderer::writeJpegToBuffer(const RgbaImage& rgba, std::vector<unsigned char>& out) {
     if (rgba.width<=0 || rgba.height<=0 || rgba.data.empty()) return false;
-    std::vector<unsigned char> rgb(rgba.width*rgba.height*3);
-    for (int i=0;i<rgba.width*rgba.height;++i) {
-        rgb[i*3+0] = rgba.data[i*4+0];
-        rgb[i*3+1] = rgba.data[i*4+1];
-        rgb[i*3+2] = rgba.data[i*4+2];
+    return jpegEncodeParallel(rgba.data.data(), rgba.width, rgba.height, 4, (size_t)rgba.width*4, 90, out);
+}
+
+namespace {
+
+bool normalizeAssetPath(const std::string& in, std::string& out) {
+    out = in;
+    if (!out.empty() && out[0] == '/') out = out.substr(1);
+    return !out.empty() && out.find("..") == std::string::npos;
+}
+
+bool fileMtime(const std::string& path, time_t& mtime) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) return false;
+    mtime = st.st_mtime;
+    return true;
+}
+
+// Validasi aset dan baca dimensinya dari header saja
+bool probeAsset(const std::string& path, LayoutAsset& asset) {
+    if (!normalizeAssetPath(path, asset.path)) return false;
+    if (!fileMtime(asset.path, asset.mtime)) return false;
+    JpegScanlineReader reader;
+    if (reader.open(asset.path)) {
+        asset.width = reader.imageWidth();
+        asset.height = reader.imageHeight();
+        return asset.width > 0 && asset.height > 0;
     }
-    out.clear();
-    return stbi_write_jpg_to_func(write_to_vector, &out, rgba.width, rgba.height, 3, rgb.data(), 90) != 0;
+    int n = 0;
+    return stbi_info(asset.path.c_str(), &asset.width, &asset.height, &n) != 0 && asset.width > 0 && asset.height > 0;
 }
 
-bool TemplateRenderer::renderToJpegBuffer(const TemplateSpec& spec,
-                                          const std::string& photoPath,
-                                          int outW,
-                                          int outH,
-                                          std::vector<unsigned char>& outJpeg) {
-    RgbaImage canvas; canvas.width = outW; canvas.height = outH; fillBackground(canvas, 255,255,255);
+}
+
+bool CompiledLayout::isStale() const {
+    for (const auto& layer : layers) {
+        if (layer.asset.path.empty()) continue;
+        time_t mtime = 0;
+        if (!fileMtime(layer.asset.path, mtime) || mtime != layer.asset.mtime) return true;
+    }
+    for (const auto& layer : layers) {
+        if (layer.mask.path.empty()) continue;
+        time_t mtime = 0;
+        if (!fileMtime(layer.mask.path, mtime) || mtime != layer.mask.mtime) return true;
+    }
+    for (const auto& t : texts) {
+        // Font yang hilang tidak menggagalkan compile; cukup bandingkan dengan keadaan saat compile
+        time_t mtime = 0;
+        fileMtime(t.fontPath, mtime);
+        if (mtime != t.fontMtime) return true;
+    }
+    return false;
+}
+
+TemplateLayoutCache::TemplateLayoutCache(size_t capacity) : capacity(capacity) {}
+
+std::string TemplateLayoutCache::makeKey(const std::string& templateJson, int outW, int outH) {
+    // FNV-1a 64-bit atas konten template
+    unsigned long long h = 1469598103934665603ULL;
+    for (unsigned char c : templateJson) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%016llx@%dx%d", h, outW, outH);
+    return buf;
+}
+
+std::shared_ptr<const CompiledLayout> TemplateLayoutCache::get(const std::string& key) {
+    std::lock_guard<std::mutex> lock(mu);
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        if ((*it)->key != key) continue;
+        auto layout = *it;
+        entries.erase(it);
+        if (layout->isStale()) {
+            return nullptr;
+        }
+        entries.push_front(layout);
+        return layout;
+    }
+    return nullptr;
+}
 
-    if (!spec.backgroundPath.empty()) {
-        auto bg = loadImageRGBA(spec.backgroundPath);
-        if (bg.width>0) {
-            auto bgR = resizeImage(bg, outW, outH);
-            blitImage(canvas, bgR, 0, 0);
+void TemplateLayoutCache::put(const std::shared_ptr<const CompiledLayout>& layout) {
+    if (!layout) return;
+    std::lock_guard<std::mutex> lock(mu);
+    entries.remove_if([&](const std::shared_ptr<const CompiledLayout>& e) { return e->key == layout->key; });
+    entries.push_front(layout);
+    while (entries.size() > capacity) entries.pop_back();
+}
+
+size_t TemplateLayoutCache::size() const {
+    std::lock_guard<std::mutex> lock(mu);
+    return entries.size();
+}
+
+std::shared_ptr<const CompiledLayout> TemplateRenderer::compile(const TemplateSpec& spec,
+                                                               int outW,
+                                                               int outH,
+                                                               const std::string& key,
+                                                               std::string& error) {
+    if (outW<=0 || outH<=0 || outW>16384 || outH>16384) {
+        error = "invalid_output_size";
+        return nullptr;
+    }
+    auto layout = std::make_shared<CompiledLayout>();
+    layout->key = key;
+    layout->width = outW;
+    layout->height = outH;
+    if (spec.designWidth > 0 && spec.designHeight > 0) {
+        layout->scaleX = (float)outW / (float)spec.designWidth;
+        layout->scaleY = (float)outH / (float)spec.designHeight;
+    }
+
+    auto addAsset = [&](const std::string& path, LayerKind kind, bool blend) {
+        CompiledLayer layer;
+        layer.kind = kind;
+        layer.w = outW; layer.h = outH;
+        layer.mode = FitMode::Stretch;
+        layer.blend = blend;
+        if (!probeAsset(path, layer.asset)) {
+            error = "asset_not_found:" + path;
+            return false;
         }
+        layer.asset.scaleDenom = jpegChooseScaleDenom(layer.asset.width, layer.asset.height, outW, outH);
+        layout->layers.push_back(layer);
+        return true;
+    };
+
+    if (!spec.backgroundPath.empty() && !addAsset(spec.backgroundPath, LayerKind::Background, false)) {
+        return nullptr;
     }
 
-    auto photo = loadImageRGBA(photoPath);
-    if (photo.width>0) {
-        int pw = outW;
-        int ph = (int)((double)photo.height * ((double)pw / (double)photo.width));
-        if (ph > outH) {
-            ph = outH;
-            pw = (int)((double)photo.width * ((double)ph / (double)photo.height));
+    if (spec.slots.empty()) {
+        CompiledLayer photo;
+        photo.kind = LayerKind::Photo;
+        photo.w = outW; photo.h = outH;
+        photo.mode = FitMode::Contain;
+        layout->layers.push_back(photo);
+    }
+    for (size_t i = 0; i < spec.slots.size(); ++i) {
+        const PhotoSlot& slot = spec.slots[i];
+        CompiledLayer photo;
+        photo.kind = LayerKind::Photo;
+        photo.x = (int)std::lround(slot.x * layout->scaleX);
+        photo.y = (int)std::lround(slot.y * layout->scaleY);
+        photo.w = (int)std::lround(slot.width * layout->scaleX);
+        photo.h = (int)std::lround(slot.height * layout->scaleY);
+        if (photo.w <= 0 || photo.h <= 0) {
+            error = "invalid_slot";
+            return nullptr;
         }
-        auto pr = resizeImage(photo, pw, ph);
-        int px = (outW - pw)/2;
-        int py = (outH - ph)/2;
-        blitImage(canvas, pr, px, py);
+        photo.mode = slot.mode;
+        photo.photoIndex = slot.photoIndex >= 0 ? slot.photoIndex : (int)i;
+        photo.cornerRadius = slot.cornerRadius * std::min(layout->scaleX, layout->scaleY);
+        if (!slot.maskPath.empty() && !probeAsset(slot.maskPath, photo.mask)) {
+            error = "asset_not_found:" + slot.maskPath;
+            return nullptr;
+        }
+        layout->layers.push_back(photo);
     }
 
-    for (const auto& ovPath : spec.overlays) {
-        auto ov = loadImageRGBA(ovPath);
-        if (ov.width>0) {
-            auto orz = resizeImage(ov, outW, outH);
-            blendImage(canvas, orz, 0, 0);
+    for (const auto& ov : spec.overlays) {
+        if (!addAsset(ov, LayerKind::Overlay, true)) return nullptr;
+    }
+
+    for (const auto& st : spec.stickers) {
+        CompiledLayer layer;
+        layer.kind = LayerKind::Sticker;
+        layer.blend = true;
+        if (!probeAsset(st.path, layer.asset)) {
+            error = "asset_not_found:" + st.path;
+            return nullptr;
+        }
+        float w = st.width, h = st.height;
+        if (w <= 0.0f && h <= 0.0f) {
+            w = (float)layer.asset.width;
+            h = (float)layer.asset.height;
+        } else if (w <= 0.0f) {
+            w = h * layer.asset.width / layer.asset.height;
+        } else if (h <= 0.0f) {
+            h = w * layer.asset.height / layer.asset.width;
+        }
+        layer.w = (int)std::lround(w * st.scale * layout->scaleX);
+        layer.h = (int)std::lround(h * st.scale * layout->scaleY);
+        if (layer.w <= 0 || layer.h <= 0 || layer.w > 16384 || layer.h > 16384) {
+            error = "invalid_sticker";
+            return nullptr;
         }
+        layer.centerX = st.x * layout->scaleX;
+        layer.centerY = st.y * layout->scaleY;
+        layer.rotation = st.rotation * (float)M_PI / 180.0f;
+        layer.opacity = (unsigned char)std::lround(std::min(1.0f, std::max(0.0f, st.opacity)) * 255.0f);
+        layer.asset.scaleDenom = jpegChooseScaleDenom(layer.asset.width, layer.asset.height, layer.w, layer.h);
+        layout->layers.push_back(layer);
     }
 
     for (auto t : spec.texts) {
+        if (t.content.empty()) continue;
         if (t.fontPath.empty()) {
             t.fontPath = "data/fonts/PlayfairDisplay-Regular.ttf";
+        } else if (!normalizeAssetPath(t.fontPath, t.fontPath)) {
+            error = "invalid_font_path";
+            return nullptr;
         }
-        drawText(canvas, t);
+        fileMtime(t.fontPath, t.fontMtime);
+        t.x *= layout->scaleX;
+        t.y *= layout->scaleY;
+        t.size = std::max(1, (int)std::lround(t.size * layout->scaleY));
+        layout->texts.push_back(t);
+    }
+    return layout;
+}
+
+std::string TemplateRenderer::previewKey(const std::string& key, int maxSide) {
+    return key + "#preview" + std::to_string(maxSide);
+}
+
+std::shared_ptr<const CompiledLayout> TemplateRenderer::previewLayout(const CompiledLayout& full, int maxSide) {
+    const int longest = std::max(full.width, full.height);
+    const float s = longest > maxSide ? (float)maxSide / (float)longest : 1.0f;
+    auto layout = std::make_shared<CompiledLayout>(full);
+    layout->key = full.key.empty() ? "" : previewKey(full.key, maxSide);
+    layout->width = std::max(1, (int)std::lround(full.width * s));
+    layout->height = std::max(1, (int)std::lround(full.height * s));
+    layout->scaleX = full.scaleX * s;
+    layout->scaleY = full.scaleY * s;
+    layout->quality = 80;
+    layout->preview = true;
+    for (auto& l : layout->layers) {
+        l.x = (int)std::lround(l.x * s);
+        l.y = (int)std::lround(l.y * s);
+        l.w = std::max(1, (int)std::lround(l.w * s));
+        l.h = std::max(1, (int)std::lround(l.h * s));
+        l.cornerRadius *= s;
+        l.centerX *= s;
+        l.centerY *= s;
+        if (!l.asset.path.empty()) {
+            l.asset.scaleDenom = jpegChooseScaleDenom(l.asset.width, l.asset.height, l.w, l.h);
+        }
+    }
+    for (auto& t : layout->texts) {
+        t.x *= s;
+        t.y *= s;
+        t.size = std::max(1, (int)std::lround(t.size * s));
+    }
+    return layout;
+}
+
+bool TemplateRenderer::renderLayout(const CompiledLayout& layout,
+                                    const std::string& photoPath,
+                                    std::vector<unsigned char>& outJpeg,
+                                    const std::function<bool(float)>& progress) {
+    return renderLayout(layout, std::vector<std::string>(1, photoPath), outJpeg, progress);
+}
+
+bool TemplateRenderer::renderLayout(const CompiledLayout& layout,
+                                    const std::vector<std::string>& photoPaths,
+                                    std::vector<unsigned char>& outJpeg,
+                                    const std::function<bool(float)>& progress) {
+    if (layout.width<=0 || layout.height<=0) return false;
+    // Strip dikomposit di thread ini sementara segmen-segmen sebelumnya di-encode paralel
+    ParallelJpegWriter writer;
+    if (!writer.begin(outJpeg, layout.width, layout.height, 4, layout.quality)) return false;
+    auto sink = [&](const unsigned char* rows, int y0, int count) {
+        (void)y0;
+        return writer.writeRows(rows, count, (size_t)layout.width*4);
+    };
+    return composeLayout(layout, photoPaths, sink, progress) && writer.finish();
+}
+
+bool TemplateRenderer::renderPyramid(const CompiledLayout& layout,
+                                     const std::vector<std::string>& photoPaths,
+                                     const std::vector<OutputLevel>& levels,
+                                     std::vector<std::vector<unsigned char>>& outJpegs,
+                                     const std::function<bool(float)>& progress) {
+    const int outW = layout.width, outH = layout.height;
+    if (outW<=0 || outH<=0 || levels.empty()) return false;
+    for (const auto& level : levels) {
+        if (level.width<=0 || level.height<=0 || level.width>outW || level.height>outH) return false;
     }
 
-    return writeJpegToBuffer(canvas, outJpeg);
+    // Kanvas penuh sekali saja; level lain diturunkan darinya, bukan dirender ulang
+    RgbaImage canvas;
+    canvas.width = outW; canvas.height = outH;
+    canvas.data.resize((size_t)outW * outH * 4);
+    auto sink = [&](const unsigned char* rows, int y0, int count) {
+        std::copy(rows, rows + (size_t)count*outW*4, canvas.data.begin() + (size_t)y0*outW*4);
+        return true;
+    };
+    if (!composeLayout(layout, photoPaths, sink, progress)) return false;
+    return encodeLevels(std::move(canvas), levels, outJpegs);
+}
+
+bool TemplateRenderer::renderPhotoVariants(const std::string& photoPath,
+                                           const std::vector<OutputLevel>& levels,
+                                           std::vector<std::vector<unsigned char>>& outJpegs,
+                                           std::vector<OutputLevel>* sizes) {
+    if (levels.empty()) return false;
+    int srcW = 0, srcH = 0, n = 0;
+    {
+        JpegScanlineReader header;
+        if (header.open(photoPath)) {
+            srcW = header.imageWidth();
+            srcH = header.imageHeight();
+        } else if (!stbi_info(photoPath.c_str(), &srcW, &srcH, &n)) {
+            return false;
+        }
+    }
+    if (srcW<=0 || srcH<=0) return false;
+
+    // Tiap level = contain ke kotaknya (sisi 0 = bebas), tidak pernah lebih besar dari foto asli
+    std::vector<OutputLevel> fitted(levels);
+    size_t largest = 0;
+    for (size_t i = 0; i < fitted.size(); ++i) {
+        OutputLevel& level = fitted[i];
+        const double sx = level.width > 0 ? (double)level.width / srcW : 1.0;
+        const double sy = level.height > 0 ? (double)level.height / srcH : 1.0;
+        const double scale = std::min(1.0, std::min(sx, sy));
+        level.width = std::max(1, (int)std::lround(srcW * scale));
+        level.height = std::max(1, (int)std::lround(srcH * scale));
+        if ((long long)level.width * level.height > (long long)fitted[largest].width * fitted[largest].height) {
+            largest = i;
+        }
+    }
+    if (sizes) *sizes = fitted;
+
+    // Decode sekali pada skala DCT terkecil yang masih cukup untuk level terbesar
+    const int topW = fitted[largest].width, topH = fitted[largest].height;
+    auto source = openRowSource(photoPath, topW, topH, FitMode::Stretch);
+    if (!source) return false;
+    RgbaImage top;
+    top.width = topW; top.height = topH;
+    top.data.resize((size_t)topW * topH * 4);
+    ScanlineResizer resizer(*source, topW, topH);
+    for (int y=0;y<topH;++y) {
+        resizer.row(y, top.data.data() + (size_t)y*topW*4);
+    }
+    if (source->failed()) {
+        std::cerr << "❌ Photo decode failed mid-image: " << photoPath << std::endl;
+        return false;
+    }
+    return encodeLevels(std::move(top), fitted, outJpegs);
+}
+
+bool TemplateRenderer::encodeLevels(RgbaImage&& canvas,
+                                    const std::vector<OutputLevel>& levels,
+                                    std::vector<std::vector<unsigned char>>& outJpegs) {
+    // Level diurutkan dari yang terbesar; tiap level di-downscale (filter area) dari level
+    // sebelumnya yang paling kecil tapi masih >= ukurannya, jadi filter tidak pernah menyentuh kanvas penuh dua kali
+    std::vector<size_t> order(levels.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return (long long)levels[a].width * levels[a].height > (long long)levels[b].width * levels[b].height;
+    });
+    std::vector<std::shared_ptr<const RgbaImage>> images(levels.size());
+    auto full = std::make_shared<RgbaImage>(std::move(canvas));
+    std::vector<std::shared_ptr<const RgbaImage>> built(1, full);
+    for (size_t i : order) {
+        const OutputLevel& level = levels[i];
+        std::shared_ptr<const RgbaImage> parent = full;
+        for (const auto& b : built) {
+            if (b->width >= level.width && b->height >= level.height &&
+                (long long)b->width * b->height < (long long)parent->width * parent->height) {
+                parent = b;
+            }
+        }
+        if (parent->width == level.width && parent->height == level.height) {
+            images[i] = parent;
+            continue;
+        }
+        auto scaled = std::make_shared<RgbaImage>();
+        scaled->width = level.width; scaled->height = level.height;
+        scaled->data.resize((size_t)level.width * level.height * 4);
+        // Band baris di-resample paralel; ImageRowSource bisa diakses acak jadi tiap band punya resizer sendiri
+        const int bands = std::max(1, std::min((int)parallelThreads(), level.height / 64));
+        parallelFor((size_t)bands, [&](size_t b) {
+            const int y0 = (int)((long long)level.height * b / bands);
+            const int y1 = (int)((long long)level.height * (b + 1) / bands);
+            ImageRowSource rows(*parent);
+            ScanlineResizer resizer(rows, level.width, level.height);
+            for (int y=y0;y<y1;++y) {
+                resizer.row(y, scaled->data.data() + (size_t)y*level.width*4);
+            }
+        });
+        images[i] = scaled;
+        built.push_back(scaled);
+    }
+
+    // Semua level di-encode bersamaan. Level terbesar memakai encoder segmen paralel dengan
+    // sisa thread, level kecil masing-masing satu thread
+    outJpegs.assign(levels.size(), std::vector<unsigned char>());
+    std::vector<char> ok(levels.size(), 0);
+    const unsigned threads = parallelThreads();
+    const unsigned bigThreads = threads > levels.size() ? threads - (unsigned)(levels.size() - 1) : 1;
+    parallelFor(order.size(), [&](size_t k) {
+        const size_t i = order[k];
+        const RgbaImage& img = *images[i];
+        ok[i] = jpegEncodeParallel(img.data.data(), img.width, img.height, 4, (size_t)img.width*4,
+                                   levels[i].quality, outJpegs[i], k == 0 ? bigThreads : 1);
+    });
+    for (char c : ok) {
+        if (!c) return false;
+    }
+    return true;
+}
+
+bool TemplateRenderer::composeLayout(const CompiledLayout& layout,
+                                     const std::vector<std::string>& photoPaths,
+                                     const std::function<bool(const unsigned char*, int, int)>& sink,
+                                     const std::function<bool(float)>& progress) {
+    const int outW = layout.width, outH = layout.height;
+    if (outW<=0 || outH<=0) return false;
+
+    // Sumber foto per slot. Satu slot tetap di-stream baris per baris; beberapa slot
+    // di-decode + resize paralel ke ukuran slotnya dulu, lalu dikomposit dalam satu lintasan
+    struct SlotSource {
+        std::unique_ptr<RowSource> source;
+        int w = 0, h = 0;
+    };
+    std::vector<size_t> photoLayers;
+    for (size_t i = 0; i < layout.layers.size(); ++i) {
+        if (layout.layers[i].kind == LayerKind::Photo && !photoPaths.empty()) photoLayers.push_back(i);
+    }
+    std::vector<SlotSource> slotSources(photoLayers.size());
+    const bool materialize = photoLayers.size() > 1;
+    parallelFor(photoLayers.size(), [&](size_t k) {
+        const CompiledLayer& l = layout.layers[photoLayers[k]];
+        const std::string& path = photoPaths[(size_t)l.photoIndex % photoPaths.size()];
+        SlotSource& out = slotSources[k];
+        LayoutAsset asset;
+        if (layout.preview && probeAsset(path, asset)) {
+            // Foto yang sama sering dipreview dengan beberapa template: simpan versi kecilnya
+            fitSize(asset.width, asset.height, l.w, l.h, l.mode, out.w, out.h);
+            asset.scaleDenom = jpegChooseScaleDenom(asset.width, asset.height, out.w, out.h);
+            out.source = openScaledAsset(asset, out.w, out.h);
+            return;
+        }
+        auto photo = openRowSource(path, l.w, l.h, l.mode);
+        if (!photo) return;
+        fitSize(photo->width(), photo->height(), l.w, l.h, l.mode, out.w, out.h);
+        if (!materialize) {
+            out.source = std::move(photo);
+            return;
+        }
+        RgbaImage img;
+        img.width = out.w; img.height = out.h;
+        img.data.resize((size_t)out.w * out.h * 4);
+        ScanlineResizer resizer(*photo, out.w, out.h);
+        for (int j=0;j<out.h;++j) {
+            resizer.row(j, img.data.data() + (size_t)j*out.w*4);
+        }
+        out.source.reset(new OwnedImageRowSource(std::move(img)));
+        if (photo->failed()) out.source->markFailed();
+    });
+
+    std::vector<size_t> stickerLayers;
+    for (size_t i = 0; i < layout.layers.size(); ++i) {
+        if (layout.layers[i].kind == LayerKind::Sticker) stickerLayers.push_back(i);
+    }
+    std::vector<std::unique_ptr<AffineLayer>> stickers(stickerLayers.size());
+    std::vector<char> stickerFailed(stickerLayers.size(), 0);
+    parallelFor(stickerLayers.size(), [&](size_t k) {
+        bool failed = false;
+        stickers[k] = openStickerLayer(layout.layers[stickerLayers[k]], layout.preview, failed);
+        stickerFailed[k] = failed;
+    });
+    for (char failed : stickerFailed) {
+        if (failed) {
+            std::cerr << "❌ Sticker decode failed mid-image, render aborted" << std::endl;
+            return false;
+        }
+    }
+
+    // Setiap layer menghasilkan baris sesuai permintaan; kanvas hanya ada sebagai
+    // strip kStripRows baris yang langsung dikonsumsi encoder JPEG
+    std::vector<RenderLayer> layers;
+    layers.reserve(layout.layers.size());
+    size_t nextSlot = 0, nextSticker = 0;
+    for (size_t i = 0; i < layout.layers.size(); ++i) {
+        const CompiledLayer& l = layout.layers[i];
+        if (l.kind == LayerKind::Sticker) {
+            std::unique_ptr<AffineLayer>& affine = stickers[nextSticker++];
+            if (!affine) continue;
+            RenderLayer layer;
+            layer.affine = std::move(affine);
+            layers.push_back(std::move(layer));
+        } else if (l.kind == LayerKind::Photo) {
+            if (nextSlot >= photoLayers.size() || photoLayers[nextSlot] != i) continue;
+            SlotSource& src = slotSources[nextSlot++];
+            RenderLayer* layer = addLayer(layers, std::move(src.source), l.x + (l.w - src.w)/2, l.y + (l.h - src.h)/2,
+                                          src.w, src.h, l.blend);
+            if (!layer) continue;
+            layer->clipX0 = std::max(layer->clipX0, l.x);
+            layer->clipY0 = std::max(layer->clipY0, l.y);
+            layer->clipX1 = std::min(layer->clipX1, l.x + l.w);
+            layer->clipY1 = std::min(layer->clipY1, l.y + l.h);
+            if (l.cornerRadius > 0.0f || !l.mask.path.empty()) {
+                // Mask dibuat seukuran slot; untuk contain, rect clip = rect foto yang lebih kecil
+                CompiledLayer maskLayer = l;
+                maskLayer.w = layer->clipX1 - layer->clipX0;
+                maskLayer.h = layer->clipY1 - layer->clipY0;
+                bool maskFailed = false;
+                layer->mask = buildSlotMask(maskLayer, maskFailed);
+                if (maskFailed) {
+                    std::cerr << "❌ Mask decode failed mid-image, render aborted: " << l.mask.path << std::endl;
+                    return false;
+                }
+            }
+        } else {
+            addLayer(layers, layout.preview ? openScaledAsset(l.asset, l.w, l.h) : openRowSource(l.asset), l.x, l.y, l.w, l.h, l.blend);
+        }
+    }
+
+    // Glyph di-layout sekali per render; rasterisasi hanya terjadi saat glyph belum ada di atlas
+    std::vector<TextRun> textRuns;
+    for (const auto& t : layout.texts) {
+        TextRun run;
+        if (layoutText(t, run)) textRuns.push_back(std::move(run));
+    }
+
+    RgbaImage strip; strip.width = outW;
+    for (int y0=0; y0<outH; y0+=kStripRows) {
+        strip.height = std::min(kStripRows, outH - y0);
+        fillBackground(strip, 255,255,255);
+        if (!composeStrip(layers, strip, y0)) {
+            std::cerr << "❌ Decode failed mid-image, render aborted" << std::endl;
+            return false;
+        }
+        for (const auto& run : textRuns) {
+            drawText(strip, run, y0);
+        }
+        if (!sink(strip.data.data(), y0, strip.height)) return false;
+        if (progress && (y0 / kStripRows) % 16 == 15 && !progress((float)(y0 + strip.height) / (float)outH)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool TemplateRenderer::renderToJpegBuffer(const TemplateSpec& spec,
+                                          const std::string& photoPath,
+                                          int outW,
+                                          int outH,
+                                          std::vector<unsigned char>& outJpeg) {
+    std::string error;
+    auto layout = compile(spec, outW, outH, "", error);
+    if (!layout) {
+        std::cerr << "❌ Template compile failed: " << error << std::endl;
+        return false;
+    }
+    return renderLayout(*layout, photoPath, outJpeg);
+}
+
+bool TemplateRenderer::renderToJpegBuffer(const TemplateSpec& spec,
+                                          const std::vector<std::string>& photoPaths,
+                                          int outW,
+                                          int outH,
+                                          std::vector<unsigned char>& outJpeg) {
+    std::string error;
+    auto layout = compile(spec, outW, outH, "", error);
+    if (!layout) {
+        std::cerr << "❌ Template compile failed: " << error << std::endl;
+        return false;
+    }
+    return renderLayout(*layout, photoPaths, outJpeg);
 }
 
 bool TemplateRenderer::renderToFile(const TemplateSpec& spec,
@@ -1,17 +1,74 @@
 #include "../include/server.h"
 #include "../include/booth_identity.h"
+#include "../include/photo_catalog.h"
 #include "../include/template_renderer.h"
+#include "../include/render_jobs.h"
+#include "../include/render_cache.h"
+#include "../include/static_file_cache.h"
+#include "../include/image_variants.h"
+#include "../include/color_lut.h"
+#include "../include/effect_variants.h"
+#include <cctype>
 #include <cerrno>
 #include <sys/time.h>
 #include <cstring>
 #include <sstream>
 #include <regex>
 
+// Satu entri katalog dalam bentuk JSON listing /api/photos
+static std::string photoRecordJson(const PhotoRecord& record) {
+    return "{\"filename\":\"" + record.filename + "\",\"path\":\"/uploads/" + record.filename +
+           "\",\"timestamp\":" + std::to_string(record.timestamp) + ",\"version\":" + std::to_string(record.version) +
+           ",\"simulated\":false}";
+}
+
+static std::string photoRecordsJson(const std::vector<PhotoRecord>& records) {
+    std::string json = "[";
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (i > 0) json += ",";
+        json += photoRecordJson(records[i]);
+    }
+    return json + "]";
+}
+
+static std::string photoDeltaJson(const PhotoDelta& delta) {
+    std::string json = "{\"version\":" + std::to_string(delta.version) + ",\"reset\":" +
+                       (delta.reset ? "true" : "false") + ",\"photos\":" + photoRecordsJson(delta.upserts) + ",\"deleted\":[";
+    for (size_t i = 0; i < delta.deleted.size(); ++i) {
+        if (i > 0) json += ",";
+        json += "\"" + delta.deleted[i] + "\"";
+    }
+    return json + "]}";
+}
+
+static bool parseUnsigned(const std::string& text, uint64_t& out) {
+    if (text.empty() || text.size() > 19) return false;
+    out = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        out = out * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return true;
+}
+
 WebSocketServer::WebSocketServer(int port, PhotoBoothServer* photoBoothServer)
     : port(port), running(false), photoBoothServer(photoBoothServer) {
     std::cout << "🔍 DEBUG: WebSocketServer constructor - IMPLEMENTING PROPER WEBSOCKET++ SERVER!" << std::endl;
     std::cout << "🔍 DEBUG: Using websocketpp::server as server - THIS IS THE CORRECT APPROACH!" << std::endl;
     wsServer = std::make_unique<websocket_server>();
+    templateCache = std::make_unique<TemplateLayoutCache>();
+    staticFiles = std::make_unique<StaticFileCache>(64);
+    // Tile grid galeri + tampilan lightbox dibuat langsung setelah capture
+    variants = std::make_unique<ImageVariantStore>("variants", std::vector<int>{320, 1280}, 75);
+    renderCache = std::make_unique<RenderCache>("outputs/cache", 64u * 1024 * 1024, 2ull * 1024 * 1024 * 1024);
+
+    // Render template berjalan di luar thread HTTP; satu core disisakan untuk live view & capture
+    unsigned int cores = std::thread::hardware_concurrency();
+    int workers = cores > 2 ? 2 : 1;
+    renderJobs = std::make_unique<RenderJobManager>("outputs", workers, 8,
+        [this](const std::string& event, const std::map<std::string, std::string>& data) {
+            this->broadcast(event, data);
+        }, renderCache.get());
 }
 
 WebSocketServer::~WebSocketServer() {
@@ -89,6 +146,14 @@ bool WebSocketServer::stop() {
     running = false;
     
     try {
+        // Hentikan render yang masih berjalan sebelum koneksi ditutup
+        if (renderJobs) {
+            renderJobs->shutdown();
+        }
+        if (variants) {
+            variants->shutdown();
+        }
+
         // Stop the server
         wsServer->stop();
         
@@ -184,6 +249,7 @@ void WebSocketServer::onOpen(connection_hdl hdl) {
 void WebSocketServer::onClose(connection_hdl hdl) {
     std::lock_guard<std::mutex> lock(clientsMutex);
     
+    photoSubscribers.erase(hdl);
     auto it = clients.find(hdl);
     if (it != clients.end()) {
         std::string sessionId = it->second;
@@ -262,6 +328,17 @@ void WebSocketServer::handleEvent(connection_hdl hdl, const std::string& event,
             this->photoBoothServer->handleGetEffectEvent(hdl);
         } else if (event == "apply-effect") {
             this->photoBoothServer->handleApplyEffectEvent(hdl, data);
+        } else if (event == "get-luts") {
+            this->photoBoothServer->handleGetLutsEvent(hdl);
+        } else if (event == "set-mirror") {
+            this->photoBoothServer->handleSetMirrorEvent(hdl, data);
+        } else if (event == "render-photo-effect") {
+            this->photoBoothServer->handleRenderPhotoEffectEvent(hdl, data);
+        } else if (event == "subscribe-photos") {
+            subscribePhotos(hdl, data);
+        } else if (event == "unsubscribe-photos") {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            photoSubscribers.erase(hdl);
         } else if (event == "api-request") {
             // Handle API requests through WebSocket
             std::string method = data.count("method") ? data.at("method") : "GET";
@@ -281,6 +358,41 @@ void WebSocketServer::handleEvent(connection_hdl hdl, const std::string& event,
     }
 }
 
+// Subscriber galeri menerima "photos-delta": pertama delta sejak versi yang dikirim klien
+// (reset=true bila klien harus mengambil ulang daftar penuh), lalu satu event per perubahan katalog
+void WebSocketServer::subscribePhotos(connection_hdl hdl, const std::map<std::string, std::string>& data) {
+    uint64_t since = 0;
+    auto it = data.find("since");
+    if (it != data.end() && !parseUnsigned(it->second, since)) since = 0;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        photoSubscribers.insert(hdl);
+    }
+    PhotoCatalog* catalog = photoBoothServer->getPhotoCatalog();
+    const std::string json = photoDeltaJson(catalog ? catalog->changesSince(since) : PhotoDelta());
+    try {
+        wsServer->send(hdl, "{\"event\":\"photos-delta\",\"data\":" + json + "}", websocketpp::frame::opcode::text);
+    } catch (const std::exception& e) {
+        std::cerr << "Error sending photos delta: " << e.what() << std::endl;
+    }
+}
+
+void WebSocketServer::publishPhotoDelta(const PhotoDelta& delta) {
+    if (!isRunning()) {
+        return;
+    }
+    const std::string message = "{\"event\":\"photos-delta\",\"data\":" + photoDeltaJson(delta) + "}";
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    for (const auto& subscriber : photoSubscribers) {
+        try {
+            wsServer->send(subscriber, message, websocketpp::frame::opcode::text);
+        } catch (const std::exception& e) {
+            std::cerr << "Error sending photos delta: " << e.what() << std::endl;
+        }
+    }
+    std::cout << "📡 Photos delta v" << delta.version << " to " << photoSubscribers.size() << " subscribers" << std::endl;
+}
+
 std::string WebSocketServer::mapToJsonObject(const std::map<std::string, std::string>& data) {
     std::ostringstream oss;
     oss << "{";
@@ -442,9 +554,27 @@ void WebSocketServer::handleImageRequest(connection_hdl hdl, const std::string&
         return;
     }
     
+    // Rantai efek: effects=sepia:0.8,vignette,lut:warm:0.6 atau array JSON; point op dilebur jadi satu pass
+    auto effectsIt = queryParams.find("effects");
+    if (effectsIt != queryParams.end() && !effectsIt->second.empty()) {
+        std::vector<EffectStep> steps;
+        std::string error;
+        if (!EffectPipeline::parseSteps(effectsIt->second, steps, error) ||
+            !EffectPipeline::resolveLuts(steps, *photoBoothServer->getLutLibrary(), error)) {
+            std::map<std::string, std::string> response;
+            response["success"] = "false";
+            response["error"] = error;
+            broadcast("api-response", response);
+            return;
+        }
+        ImageEffects effects;
+        effects.setEffects(steps);
+        imageData = effects.applyEffect(imageData);
+    }
+
     // Apply effects if requested
     auto effectIt = queryParams.find("effect");
-    if (effectIt != queryParams.end() && effectIt->second != "" && effectIt->second != "none") {
+    if (effectsIt == queryParams.end() && effectIt != queryParams.end() && effectIt->second != "" && effectIt->second != "none") {
         EffectParams params;
         params.intensity = 0.5;
         params.radius = 1.0;
@@ -466,14 +596,22 @@ void WebSocketServer::handleImageRequest(connection_hdl hdl, const std::string&
         ImageEffects effects;
         EffectType effect = EffectType::NONE;
         std::string effectName = effectIt->second;
-        if (effectName == "fisheye") effect = EffectType::FISHEYE;
-        else if (effectName == "grayscale") effect = EffectType::GRAYSCALE;
-        else if (effectName == "sepia") effect = EffectType::SEPIA;
-        else if (effectName == "vignette") effect = EffectType::VIGNETTE;
-        else if (effectName == "blur") effect = EffectType::BLUR;
-        else if (effectName == "sharpen") effect = EffectType::SHARPEN;
-        else if (effectName == "invert") effect = EffectType::INVERT;
-        else if (effectName == "pixelate") effect = EffectType::PIXELATE;
+        EffectPipeline::parseEffectName(effectName, effect);
+        if (effect == EffectType::LUT) {
+            auto lutIt = queryParams.find("lut");
+            std::string lutError = "lut_required";
+            if (lutIt != queryParams.end()) {
+                params.lut = lutIt->second;
+                params.lutTable = photoBoothServer->getLutLibrary()->get(params.lut, lutError);
+            }
+            if (!params.lutTable) {
+                std::map<std::string, std::string> response;
+                response["success"] = "false";
+                response["error"] = lutError;
+                broadcast("api-response", response);
+                return;
+            }
+        }
         
         effects.setEffect(effect, params);
         imageData = effects.applyEffect(imageData);
@@ -572,7 +710,7 @@ void WebSocketServer::onHttpRequest(connection_hdl hdl) {
         if (path == "/api/status" && method == "GET") {
             handleHttpApiStatusRequest(hdl);
         } else if (path == "/api/photos" && method == "GET") {
-            handleHttpApiPhotosRequest(hdl);
+            handleHttpApiPhotosRequest(hdl, queryParams);
         } else if (path == "/api/identity" && method == "GET") {
             handleHttpApiIdentityGetRequest(hdl);
         } else if (path == "/api/identity" && method == "POST") {
@@ -580,14 +718,16 @@ void WebSocketServer::onHttpRequest(connection_hdl hdl) {
         } else if (path.find("/api/photos/") == 0 && method == "DELETE") {
             std::string filename = path.substr(12);
             handleHttpApiPhotoDeleteRequest(hdl, filename);
-        } else if (path.substr(0, 9) == "/uploads/" && method == "GET") {
+        } else if ((path.substr(0, 9) == "/uploads/" || path.substr(0, 9) == "/outputs/") && method == "GET") {
             // Handle static file requests for uploads directory
             std::cout << "🔍 DEBUG: Routing to handleStaticFileRequest with path: " << path << std::endl;
-            handleStaticFileRequest(hdl, path);
+            handleStaticFileRequest(hdl, path, queryParams);
         } else if (path == "/api/upload-image" && method == "POST") {
             handleHttpUploadImagePostRequest(hdl, con);
         } else if (path == "/api/render-template" && method == "POST") {
             handleHttpRenderTemplatePostRequest(hdl, con);
+        } else if (path.find("/api/render-jobs/") == 0 && (method == "GET" || method == "DELETE")) {
+            handleHttpRenderJobRequest(hdl, method, path.substr(17));
         } else {
             std::cout << "🔍 DEBUG: No route found for path: " << path << std::endl;
             sendHttpResponse(hdl, 404, "{\"error\":\"Not Found\"}", "application/json", true);
@@ -599,6 +739,21 @@ void WebSocketServer::onHttpRequest(connection_hdl hdl) {
     }
 }
 
+// Kirim body biner (gambar) apa adanya; body dipindahkan, bukan disalin
+void WebSocketServer::sendHttpBinaryResponse(connection_hdl hdl, std::string&& body, const std::string& contentType,
+                                           const std::string& cacheControl) {
+    auto con = wsServer->get_con_from_hdl(hdl);
+    const size_t size = body.size();
+    con->set_status(websocketpp::http::status_code::value(200));
+    con->replace_header("Content-Type", contentType);
+    con->replace_header("Content-Length", std::to_string(size));
+    con->replace_header("Cache-Control", cacheControl);
+    con->replace_header("Access-Control-Allow-Origin", "*");
+    con->replace_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
+    con->replace_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
+    con->set_body(std::move(body));
+}
+
 // Send HTTP response with CORS headers
 void WebSocketServer::sendHttpResponse(connection_hdl hdl, int statusCode, const std::string& body,
                                      const std::string& contentType, bool includeCors) {
@@ -610,8 +765,12 @@ void WebSocketServer::sendHttpResponse(connection_hdl hdl, int statusCode, const
         std::string statusText;
         switch (statusCode) {
             case 200: statusText = "OK"; break;
+            case 202: statusText = "Accepted"; break;
+            case 400: statusText = "Bad Request"; break;
+            case 403: statusText = "Forbidden"; break;
             case 404: statusText = "Not Found"; break;
             case 500: statusText = "Internal Server Error"; break;
+            case 503: statusText = "Service Unavailable"; break;
             default: statusText = "Unknown"; break;
         }
         
@@ -654,17 +813,56 @@ void WebSocketServer::handleHttpApiStatusRequest(connection_hdl hdl) {
     sendHttpResponse(hdl, 200, oss.str(), "application/json", true);
 }
 
-void WebSocketServer::handleHttpApiPhotosRequest(connection_hdl hdl) {
-    std::vector<Photo> photos = photoBoothServer->getPhotosList();
-    std::string json = "{\"photos\":[";
-    for (size_t i = 0; i < photos.size(); ++i) {
-        if (i > 0) json += ",";
-        json += "{\"filename\":\"" + photos[i].filename + "\",";
-        json += "\"path\":\"" + photos[i].path + "\",";
-        json += "\"timestamp\":" + std::to_string(photos[i].timestamp) + ",";
-        json += "\"simulated\":" + std::string(photos[i].simulated ? "true" : "false") + "}";
+void WebSocketServer::handleHttpApiPhotosRequest(connection_hdl hdl, const std::map<std::string, std::string>& queryParams) {
+    PhotoCatalog* catalog = photoBoothServer->getPhotoCatalog();
+    auto param = [&](const char* key) {
+        auto it = queryParams.find(key);
+        return it == queryParams.end() ? std::string() : it->second;
+    };
+    const std::string since = param("since");
+    const std::string sinceTimestamp = param("sinceTimestamp");
+    const std::string limitParam = param("limit");
+    const std::string cursor = param("cursor");
+    
+    // Delta sejak versi katalog yang terakhir dilihat klien
+    if (!since.empty()) {
+        uint64_t version = 0;
+        if (!parseUnsigned(since, version)) {
+            sendHttpResponse(hdl, 400, "{\"error\":\"invalid_since\"}", "application/json", true);
+            return;
+        }
+        sendHttpResponse(hdl, 200, photoDeltaJson(catalog->changesSince(version)), "application/json", true);
+        return;
     }
-    json += "]}";
+    
+    uint64_t limit = 0;
+    if (!limitParam.empty() && !parseUnsigned(limitParam, limit)) {
+        sendHttpResponse(hdl, 400, "{\"error\":\"invalid_limit\"}", "application/json", true);
+        return;
+    }
+    limit = std::min<uint64_t>(limit, 500);
+    
+    if (!sinceTimestamp.empty()) {
+        uint64_t ts = 0;
+        if (!parseUnsigned(sinceTimestamp, ts)) {
+            sendHttpResponse(hdl, 400, "{\"error\":\"invalid_since\"}", "application/json", true);
+            return;
+        }
+        const uint64_t version = catalog->version();
+        sendHttpResponse(hdl, 200, "{\"photos\":" + photoRecordsJson(catalog->newerThan((int64_t)ts, (size_t)limit)) +
+                         ",\"version\":" + std::to_string(version) + "}", "application/json", true);
+        return;
+    }
+    
+    // Tanpa limit/cursor: daftar penuh seperti sebelumnya (+ versi)
+    PhotoPage page;
+    if (!catalog->page(cursor, (size_t)limit, page)) {
+        sendHttpResponse(hdl, 400, "{\"error\":\"invalid_cursor\"}", "application/json", true);
+        return;
+    }
+    std::string json = "{\"photos\":" + photoRecordsJson(page.photos) + ",\"version\":" + std::to_string(page.version);
+    if (!page.nextCursor.empty()) json += ",\"nextCursor\":\"" + page.nextCursor + "\"";
+    json += "}";
     sendHttpResponse(hdl, 200, json, "application/json", true);
 }
 
@@ -781,8 +979,8 @@ bool WebSocketServer::isPathSafe(const std::string& path) {
         return false;
     }
     
-    // Ensure path starts with uploads/
-    if (path.substr(0, 9) != "/uploads/") {
+    // Ensure path starts with uploads/ or outputs/
+    if (path.substr(0, 9) != "/uploads/" && path.substr(0, 9) != "/outputs/") {
         return false;
     }
     
@@ -834,7 +1032,8 @@ std::vector<uint8_t> WebSocketServer::readBinaryFile(const std::string& filepath
     return buffer;
 }
 
-void WebSocketServer::handleStaticFileRequest(connection_hdl hdl, const std::string& path) {
+void WebSocketServer::handleStaticFileRequest(connection_hdl hdl, const std::string& path,
+                                              const std::map<std::string, std::string>& queryParams) {
     std::cout << "🔍 DEBUG: handleStaticFileRequest called with path: " << path << std::endl;
     
     // Check if path is safe
@@ -848,62 +1047,156 @@ void WebSocketServer::handleStaticFileRequest(connection_hdl hdl, const std::str
     // But we need to check if it exists relative to the current working directory
     std::string fullPath = path;
     
-    // If the path starts with "/uploads/", remove the leading slash
-    if (fullPath.find("/uploads/") == 0) {
+    // If the path starts with "/uploads/" or "/outputs/", remove the leading slash
+    if (fullPath.find("/uploads/") == 0 || fullPath.find("/outputs/") == 0) {
         fullPath = fullPath.substr(1);
     }
     
     std::cout << "🔍 DEBUG: Full path to check: " << fullPath << std::endl;
     
-    // Check if file exists
-    if (!fileExists(fullPath)) {
-        std::cout << "🔍 DEBUG: File does not exist: " << fullPath << std::endl;
-        sendHttpResponse(hdl, 404, "{\"error\":\"File Not Found\"}", "application/json", true);
+    // Varian galeri: /uploads/<nama>?w=320&q=70
+    auto wIt = queryParams.find("w");
+    auto qIt = queryParams.find("q");
+    if (fullPath.find("uploads/") == 0 && (wIt != queryParams.end() || qIt != queryParams.end())) {
+        int width = 0, quality = 0;
+        if (!ImageVariantStore::normalize(wIt != queryParams.end() ? wIt->second : "",
+                                          qIt != queryParams.end() ? qIt->second : "", width, quality)) {
+            sendHttpResponse(hdl, 400, "{\"error\":\"invalid_variant\"}", "application/json", true);
+            return;
+        }
+        std::string variantPath;
+        if (variants->lookup(fullPath, width, quality, variantPath)) {
+            serveStaticFile(hdl, variantPath, "max-age=3600");
+            return;
+        }
+        if (variantPath.empty()) {
+            sendHttpResponse(hdl, 404, "{\"error\":\"File Not Found\"}", "application/json", true);
+            return;
+        }
+        // Belum ada: respons ditahan sampai worker selesai membuat varian
+        auto con = wsServer->get_con_from_hdl(hdl);
+        con->defer_http_response();
+        variants->generate(fullPath, width, quality, [this, hdl](const std::string& ready) {
+            try {
+                auto deferred = wsServer->get_con_from_hdl(hdl);
+                if (ready.empty()) {
+                    if (variants->isStopping()) {
+                        sendHttpResponse(hdl, 503, "{\"error\":\"shutting_down\"}", "application/json", true);
+                    } else {
+                        sendHttpResponse(hdl, 500, "{\"error\":\"variant_failed\"}", "application/json", true);
+                    }
+                } else {
+                    serveStaticFile(hdl, ready, "max-age=3600");
+                }
+                deferred->send_http_response();
+            } catch (const std::exception& e) {
+                std::cerr << "Error sending deferred variant response: " << e.what() << std::endl;
+            }
+        });
         return;
     }
     
-    // Read file content
-    std::vector<uint8_t> fileContent = readBinaryFile(fullPath);
-    if (fileContent.empty()) {
-        std::cout << "🔍 DEBUG: Failed to read file: " << fullPath << std::endl;
-        sendHttpResponse(hdl, 500, "{\"error\":\"Internal Server Error\"}", "application/json", true);
-        return;
+    // Foto dengan efek: /uploads/<nama>?effect=sepia&intensity=0.8 dilayani dari varian efek
+    // (uploads/effects/), dirender sekali dari foto asli bila belum ada
+    const std::string photoName = fullPath.find("uploads/") == 0 ? fullPath.substr(8) : "";
+    if (PhotoCatalog::isPhotoName(photoName) && (queryParams.count("effect") || queryParams.count("effects"))) {
+        auto pipeline = photoBoothServer->effectPipelineFor(queryParams);
+        if (pipeline) {
+            auto con = wsServer->get_con_from_hdl(hdl);
+            con->defer_http_response();
+            photoBoothServer->getEffectVariants()->render(fullPath, pipeline, [this, hdl](const std::string& ready) {
+                try {
+                    auto deferred = wsServer->get_con_from_hdl(hdl);
+                    if (ready.empty() && photoBoothServer->getEffectVariants()->isStopping()) {
+                        sendHttpResponse(hdl, 503, "{\"error\":\"shutting_down\"}", "application/json", true);
+                    } else if (ready.empty()) {
+                        sendHttpResponse(hdl, 404, "{\"error\":\"File Not Found\"}", "application/json", true);
+                    } else {
+                        serveStaticFile(hdl, ready, "max-age=3600");
+                    }
+                    deferred->send_http_response();
+                } catch (const std::exception& e) {
+                    std::cerr << "Error sending deferred effect variant: " << e.what() << std::endl;
+                }
+            });
+            return;
+        }
     }
     
-    // Get MIME type
-    std::string mimeType = getMimeTypeFromExtension(path);
+    // Nama file render unik per job dan tidak pernah ditimpa, jadi aman di-cache selamanya
+    serveStaticFile(hdl, fullPath, fullPath.find("outputs/") == 0 ? "public, max-age=31536000, immutable" : "max-age=3600");
+}
+
+void WebSocketServer::serveStaticFile(connection_hdl hdl, const std::string& fullPath, const std::string& cacheControl) {
+    // Metadata + fd di-cache; satu stat() per request untuk validasi
+    std::shared_ptr<const StaticFileCache::File> file = staticFiles->open(fullPath);
+    if (!file) {
+        std::cout << "🔍 DEBUG: File does not exist: " << fullPath << std::endl;
+        sendHttpResponse(hdl, 404, "{\"error\":\"File Not Found\"}", "application/json", true);
+        return;
+    }
     
     try {
         auto con = wsServer->get_con_from_hdl(hdl);
-        auto response = std::make_shared<websocketpp::http::parser::response>();
-        
-        // Set status
-        response->set_status(websocketpp::http::status_code::value(200), "OK");
-        
-        // Set body as binary data
-        std::string bodyStr(fileContent.begin(), fileContent.end());
-        response->set_body(bodyStr);
-        
-        // Set headers
-        response->append_header("Content-Type", mimeType);
-        response->append_header("Content-Length", std::to_string(fileContent.size()));
-        response->append_header("Cache-Control", "max-age=3600");
-        
-        // Add CORS headers
-        response->append_header("Access-Control-Allow-Origin", "*");
-        response->append_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
-        response->append_header("Access-Control-Allow-Headers", "Content-Type, Authorization");
+        std::string mimeType = getMimeTypeFromExtension(fullPath);
+        con->replace_header("ETag", file->etag);
+        con->replace_header("Last-Modified", file->lastModified);
+        con->replace_header("Cache-Control", cacheControl);
+        con->replace_header("Accept-Ranges", "bytes");
+        con->replace_header("Access-Control-Allow-Origin", "*");
+        con->replace_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
+        con->replace_header("Access-Control-Allow-Headers", "Content-Type, Authorization, Range, If-None-Match");
+        con->replace_header("Access-Control-Expose-Headers", "ETag, Content-Range, Accept-Ranges");
         
-        con->set_body(response->get_body());
-        con->set_status(response->get_status_code());
+        // Validasi: If-None-Match menang atas If-Modified-Since (RFC 7232 6)
+        const std::string& ifNoneMatch = con->get_request_header("If-None-Match");
+        bool notModified = !ifNoneMatch.empty() ? etagMatches(ifNoneMatch, file->etag)
+                                                : con->get_request_header("If-Modified-Since") == file->lastModified;
+        if (notModified) {
+            con->set_status(websocketpp::http::status_code::not_modified);
+            std::cout << "📤 Static file not modified: " << fullPath << std::endl;
+            return;
+        }
         
-        // Copy headers
-        auto headers = response->get_headers();
-        for (const auto& header : headers) {
-            con->replace_header(header.first, header.second);
+        // Range hanya dihormati bila If-Range (jika ada) masih cocok dengan versi file ini
+        ByteRange range;
+        const std::string& rangeHeader = con->get_request_header("Range");
+        const std::string& ifRange = con->get_request_header("If-Range");
+        if (!rangeHeader.empty() && (ifRange.empty() || ifRange == file->etag || ifRange == file->lastModified)) {
+            range = parseByteRange(rangeHeader, file->size);
+        }
+        if (range.kind == ByteRange::Unsatisfiable) {
+            con->set_status(websocketpp::http::status_code::request_range_not_satisfiable);
+            con->replace_header("Content-Range", "bytes */" + std::to_string(file->size));
+            con->set_body(std::string());
+            return;
         }
         
-        std::cout << "📤 Static file served: " << path << " (" << fileContent.size() << " bytes, " << mimeType << ")" << std::endl;
+        uint64_t first = 0, length = file->size;
+        if (range.kind == ByteRange::Satisfiable) {
+            first = range.first;
+            length = range.length;
+        }
+        // Satu salinan saja: page cache -> body respons
+        std::string body;
+        if (!file->read(first, length, body)) {
+            staticFiles->invalidate(fullPath);
+            std::cout << "🔍 DEBUG: Failed to read file: " << fullPath << std::endl;
+            sendHttpResponse(hdl, 500, "{\"error\":\"Internal Server Error\"}", "application/json", true);
+            return;
+        }
+        if (range.kind == ByteRange::Satisfiable) {
+            con->set_status(websocketpp::http::status_code::partial_content);
+            con->replace_header("Content-Range", "bytes " + std::to_string(first) + "-" +
+                                std::to_string(first + length - 1) + "/" + std::to_string(file->size));
+        } else {
+            con->set_status(websocketpp::http::status_code::ok);
+        }
+        con->replace_header("Content-Type", mimeType);
+        con->replace_header("Content-Length", std::to_string(length));
+        con->set_body(std::move(body));
+        std::cout << "📤 Static file served: " << fullPath << " (" << length << " of " << file->size
+                  << " bytes, " << mimeType << ")" << std::endl;
         
     } catch (const std::exception& e) {
         std::cerr << "Error serving static file: " << e.what() << std::endl;
@@ -962,85 +1255,366 @@ void WebSocketServer::handleHttpUploadImagePostRequest(connection_hdl hdl, webso
     }
     ofs.write(reinterpret_cast<const char*>(data.data()), (std::streamsize)data.size());
     ofs.close();
+    variants->warm(path);
+    if (auto* catalog = photoBoothServer->getPhotoCatalog()) catalog->add(filename);
     sendHttpResponse(hdl, 200, "{\"success\":true,\"path\":\"/uploads/" + filename + "\"}", "application/json", true);
 }
 
+// Parse JSON template ke TemplateSpec. Hanya dipanggil saat layout belum ada di cache
+// Potong array JSON (mentah dari parseEventJson) menjadi objek-objek level pertama
+static bool splitJsonObjects(const std::string& arr, std::vector<std::string>& out) {
+    size_t pos = 0;
+    while ((pos = arr.find('{', pos)) != std::string::npos) {
+        int depth = 0;
+        size_t end = pos;
+        for (; end < arr.size(); ++end) {
+            if (arr[end] == '{') depth++;
+            else if (arr[end] == '}' && --depth == 0) break;
+        }
+        if (end >= arr.size()) return false;
+        out.push_back(arr.substr(pos, end - pos + 1));
+        pos = end + 1;
+    }
+    return true;
+}
+
+static bool parseJsonStringArray(const std::string& arr, std::vector<std::string>& out) {
+    size_t pos = 0;
+    while ((pos = arr.find('"', pos)) != std::string::npos) {
+        size_t end = arr.find('"', pos + 1);
+        if (end == std::string::npos) return false;
+        out.push_back(arr.substr(pos + 1, end - pos - 1));
+        pos = end + 1;
+    }
+    return true;
+}
+
+static bool parseTemplateJson(const std::string& tmplStr, TemplateSpec& spec) {
+    std::map<std::string, std::string> top;
+    parseEventJson(tmplStr, top);
+    if (top.count("background")) spec.backgroundPath = top["background"];
+    try {
+        if (top.count("width")) spec.designWidth = std::stoi(top["width"]);
+        if (top.count("height")) spec.designHeight = std::stoi(top["height"]);
+    } catch (...) {
+        return false;
+    }
+    if (top.count("overlays") && !parseJsonStringArray(top["overlays"], spec.overlays)) {
+        return false;
+    }
+    std::vector<std::string> objects;
+    if (top.count("text") && !splitJsonObjects(top["text"], objects)) {
+        return false;
+    }
+    for (const auto& objStr : objects) {
+        std::map<std::string, std::string> obj;
+        parseJsonObject(objStr, obj, "");
+        TextSpec ts;
+        try {
+            if (obj.count("content")) ts.content = obj["content"];
+            if (obj.count("fontPath")) ts.fontPath = obj["fontPath"];
+            if (obj.count("size")) ts.size = std::stoi(obj["size"]);
+            if (obj.count("color")) {
+                unsigned char r=255,g=255,b=255; TemplateRenderer::parseColorHex(obj["color"], r,g,b); ts.r=r; ts.g=g; ts.b=b;
+            }
+            if (obj.count("position.x")) ts.x = std::stof(obj["position.x"]);
+            if (obj.count("position.y")) ts.y = std::stof(obj["position.y"]);
+        } catch (...) {
+            return false;
+        }
+        spec.texts.push_back(ts);
+    }
+    // slots: [{"x","y","width","height","fit":"cover|contain|stretch","radius","mask","photo"}]
+    objects.clear();
+    if (top.count("slots") && !splitJsonObjects(top["slots"], objects)) {
+        return false;
+    }
+    for (const auto& objStr : objects) {
+        std::map<std::string, std::string> obj;
+        parseJsonObject(objStr, obj, "");
+        PhotoSlot slot;
+        try {
+            if (obj.count("x")) slot.x = std::stof(obj["x"]);
+            if (obj.count("y")) slot.y = std::stof(obj["y"]);
+            if (obj.count("width")) slot.width = std::stof(obj["width"]);
+            if (obj.count("height")) slot.height = std::stof(obj["height"]);
+            if (obj.count("radius")) slot.cornerRadius = std::stof(obj["radius"]);
+            if (obj.count("photo")) slot.photoIndex = std::stoi(obj["photo"]);
+        } catch (...) {
+            return false;
+        }
+        if (obj.count("fit")) {
+            if (obj["fit"] == "contain") slot.mode = FitMode::Contain;
+            else if (obj["fit"] == "stretch") slot.mode = FitMode::Stretch;
+        }
+        if (obj.count("mask")) slot.maskPath = obj["mask"];
+        spec.slots.push_back(slot);
+    }
+    // stickers: [{"path","x","y","width","height","scale","rotation","opacity"}], x/y = pusat sticker
+    objects.clear();
+    if (top.count("stickers") && !splitJsonObjects(top["stickers"], objects)) {
+        return false;
+    }
+    for (const auto& objStr : objects) {
+        std::map<std::string, std::string> obj;
+        parseJsonObject(objStr, obj, "");
+        StickerSpec sticker;
+        try {
+            if (obj.count("path")) sticker.path = obj["path"];
+            if (obj.count("x")) sticker.x = std::stof(obj["x"]);
+            if (obj.count("y")) sticker.y = std::stof(obj["y"]);
+            if (obj.count("width")) sticker.width = std::stof(obj["width"]);
+            if (obj.count("height")) sticker.height = std::stof(obj["height"]);
+            if (obj.count("scale")) sticker.scale = std::stof(obj["scale"]);
+            if (obj.count("rotation")) sticker.rotation = std::stof(obj["rotation"]);
+            if (obj.count("opacity")) sticker.opacity = std::stof(obj["opacity"]);
+        } catch (...) {
+            return false;
+        }
+        if (sticker.path.empty()) return false;
+        spec.stickers.push_back(sticker);
+    }
+    return true;
+}
+
+// outputs: [{"name":"web","width":1200,"height":0,"quality":80}, ...] -> ukuran tambahan dari render yang sama
+static bool parseRenderOutputs(const std::string& arr, std::vector<RenderOutput>& outputs) {
+    std::vector<std::string> objects;
+    if (!splitJsonObjects(arr, objects) || objects.size() > 8) return false;
+    for (const auto& objStr : objects) {
+        std::map<std::string, std::string> obj;
+        parseJsonObject(objStr, obj, "");
+        RenderOutput out;
+        out.name = obj.count("name") ? obj["name"] : "";
+        if (out.name.empty() || out.name.size() > 32) return false;
+        for (char c : out.name) {
+            if (!std::isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') return false;
+        }
+        for (const auto& other : outputs) {
+            if (other.name == out.name) return false;
+        }
+        try {
+            if (obj.count("width")) out.width = std::stoi(obj["width"]);
+            if (obj.count("height")) out.height = std::stoi(obj["height"]);
+            if (obj.count("quality")) out.quality = std::stoi(obj["quality"]);
+        } catch (...) {
+            return false;
+        }
+        if (out.width <= 0 && out.height <= 0) return false;
+        outputs.push_back(out);
+    }
+    return true;
+}
+
+static std::string renderOutputsJson(const std::vector<RenderOutput>& outputs) {
+    std::string json = "{";
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        if (i) json += ",";
+        json += "\"" + outputs[i].name + "\":\"" + RenderJobManager::outputUrl(outputs[i].path) + "\"";
+    }
+    return json + "}";
+}
+
 void WebSocketServer::handleHttpRenderTemplatePostRequest(connection_hdl hdl, websocket_server::connection_ptr con) {
     std::string body = con->get_request().get_body();
-    std::regex photoPathRegex(R"RGX("photoPath"\s*:\s*"([^"]+)")RGX");
-    std::regex outWRegex(R"RGX("outputWidth"\s*:\s*(\d+))RGX");
-    std::regex outHRegex(R"RGX("outputHeight"\s*:\s*(\d+))RGX");
-    std::regex tmplRegex(R"("template"\s*:\s*(\{[\n\r\t ,:"\[\]A-Za-z0-9._#-]*\}))");
-    std::smatch m;
-    std::string photoPath;
+    std::map<std::string, std::string> req;
+    parseEventJson(body, req);
+    // photoPaths (array) untuk template multi-slot; photoPath tunggal tetap didukung
+    std::vector<std::string> photoPaths;
+    if (req.count("photoPaths")) {
+        parseJsonStringArray(req["photoPaths"], photoPaths);
+    } else if (req.count("photoPath") && !req["photoPath"].empty()) {
+        photoPaths.push_back(req["photoPath"]);
+    }
+    std::string tmplStr = req.count("template") ? req["template"] : "";
     int outW = 3000, outH = 4500;
-    std::string tmplStr;
-    if (std::regex_search(body, m, photoPathRegex)) photoPath = m[1].str();
-    if (std::regex_search(body, m, outWRegex)) outW = std::stoi(m[1].str());
-    if (std::regex_search(body, m, outHRegex)) outH = std::stoi(m[1].str());
-    if (std::regex_search(body, m, tmplRegex)) tmplStr = m[1].str();
-    if (photoPath.empty() || tmplStr.empty()) {
+    try {
+        if (req.count("outputWidth")) outW = std::stoi(req["outputWidth"]);
+        if (req.count("outputHeight")) outH = std::stoi(req["outputHeight"]);
+    } catch (...) {
+        photoPaths.clear();
+    }
+    std::vector<RenderOutput> outputs;
+    if (req.count("outputs") && !parseRenderOutputs(req["outputs"], outputs)) {
+        photoPaths.clear();
+    }
+    if (photoPaths.empty() || tmplStr.empty() || tmplStr[0] != '{') {
         sendHttpResponse(hdl, 400, "{\"success\":false,\"error\":\"invalid_request\"}", "application/json", true);
         return;
     }
 
-    TemplateSpec spec;
-    std::regex bgRegex(R"RGX("background"\s*:\s*"([^"]+)")RGX");
-    if (std::regex_search(tmplStr, m, bgRegex)) spec.backgroundPath = m[1].str();
-    if (!spec.backgroundPath.empty() && spec.backgroundPath[0] == '/') spec.backgroundPath = spec.backgroundPath.substr(1);
-    std::regex overlaysRegex("\"overlays\"\\s*:\\s*\\[(.*?)\\]");
-    if (std::regex_search(tmplStr, m, overlaysRegex)) {
-        std::string arr = m[1].str();
-        std::regex itemRegex("\"([^\"]+)\"");
-        auto it = std::sregex_iterator(arr.begin(), arr.end(), itemRegex);
-        auto end = std::sregex_iterator();
-        for (; it != end; ++it) {
-            std::string p = (*it)[1].str();
-            if (!p.empty() && p[0] == '/') p = p.substr(1);
-            spec.overlays.push_back(p);
+    std::string key = TemplateLayoutCache::makeKey(tmplStr, outW, outH);
+    auto layout = templateCache->get(key);
+    if (!layout) {
+        TemplateSpec spec;
+        std::string error = "invalid_template";
+        if (parseTemplateJson(tmplStr, spec)) {
+            layout = TemplateRenderer::compile(spec, outW, outH, key, error);
+        }
+        if (!layout) {
+            sendHttpResponse(hdl, 400, "{\"success\":false,\"error\":\"" + error + "\"}", "application/json", true);
+            return;
         }
+        templateCache->put(layout);
+        std::cout << "🧩 Template compiled and cached: " << key << std::endl;
     }
-    std::regex textsRegex(R"RGX("text"\s*:\s*\[(.*?)\])RGX");
-    if (std::regex_search(tmplStr, m, textsRegex)) {
-        std::string tarr = m[1].str();
-        std::regex objRegex(R"RGX(\{([^\}]*)\})RGX");
-        auto it = std::sregex_iterator(tarr.begin(), tarr.end(), objRegex);
-        auto end = std::sregex_iterator();
-        for (; it != end; ++it) {
-            std::string obj = (*it)[1].str();
-            TextSpec ts;
-            std::smatch mm;
-            std::regex cRegex("\"content\"\\s*:\\s*\"([^\"]+)\"");
-            std::regex fRegex("\"fontPath\"\\s*:\\s*\"([^\"]+)\"");
-            std::regex sizeRegex("\"size\"\\s*:\\s*(\\d+)");
-            std::regex colorRegex("\"color\"\\s*:\\s*\"([^\"]+)\"");
-            std::regex xRegex("\"position\"\\s*:\\s*\{[^\}]*\"x\"\\s*:\\s*(\\d+(?:\\.\\d+)?)");
-            std::regex yRegex("\"position\"\\s*:\\s*\{[^\}]*\"y\"\\s*:\\s*(\\d+(?:\\.\\d+)?)");
-            if (std::regex_search(obj, mm, cRegex)) ts.content = mm[1].str();
-            if (std::regex_search(obj, mm, fRegex)) ts.fontPath = mm[1].str();
-            if (std::regex_search(obj, mm, sizeRegex)) ts.size = std::stoi(mm[1].str());
-            if (std::regex_search(obj, mm, colorRegex)) {
-                unsigned char r=255,g=255,b=255; TemplateRenderer::parseColorHex(mm[1].str(), r,g,b); ts.r=r; ts.g=g; ts.b=b;
+
+    for (auto& photoPath : photoPaths) {
+        if (photoPath.size() && photoPath[0] == '/') photoPath = photoPath.substr(1);
+    }
+
+    // Default: balas segera dengan jobId + URL output. Klien yang minta image/jpeg atau
+    // klien lama (legacy:true, base64 di JSON) ditahan sampai job selesai lewat deferred response.
+    const std::string accept = con->get_request_header("Accept");
+    const bool wantJpeg = accept.find("image/jpeg") != std::string::npos;
+    const bool wantLegacy = req.count("legacy") && req["legacy"] == "true";
+    // Render identik (template, foto, ukuran, kualitas) dilayani dari cache tanpa menyentuh renderer
+    std::string renderKey = RenderCache::makeKey(*layout, photoPaths);
+    std::shared_ptr<const std::vector<unsigned char>> cached;
+    // Output tambahan ikut dicek: hit hanya bila semua ukuran yang diminta sudah ada
+    std::vector<RenderOutput> cachedOutputs = RenderJobManager::resolveOutputs(*layout, renderKey, outputs);
+    bool outputsCached = true;
+    for (auto& out : cachedOutputs) {
+        out.path = renderCache->pathFor(out.cacheKey);
+        outputsCached = outputsCached && renderCache->lookup(out.cacheKey);
+    }
+    if (outputsCached && renderCache->lookup(renderKey, (wantJpeg || wantLegacy) ? &cached : nullptr)) {
+        std::string url = RenderCache::urlFor(renderCache->pathFor(renderKey));
+        const std::string outputsJson = cachedOutputs.empty() ? "" : ",\"outputs\":" + renderOutputsJson(cachedOutputs);
+        std::cout << "♻️ Render cache hit: " << renderKey << std::endl;
+        if (wantJpeg) {
+            sendHttpBinaryResponse(hdl, std::string(cached->begin(), cached->end()), "image/jpeg", "no-store");
+        } else if (wantLegacy) {
+            std::string b64 = photoBoothServer->getGPhotoWrapper()->base64Encode(*cached);
+            sendHttpResponse(hdl, 200, "{\"success\":true,\"output\":\"" + b64 + "\",\"path\":\"" + url +
+                             "\",\"url\":\"" + url + "\",\"cached\":true" + outputsJson + "}", "application/json", true);
+        } else {
+            sendHttpResponse(hdl, 200, "{\"success\":true,\"status\":\"done\",\"cached\":true,\"url\":\"" + url + "\"" +
+                             outputsJson + "}", "application/json", true);
+        }
+        return;
+    }
+
+    if (req.count("preview") && req["preview"] == "true") {
+        handleHttpRenderPreview(hdl, layout, photoPaths, wantJpeg);
+        return;
+    }
+
+    RenderJobManager::Completion onFinished;
+    if (wantJpeg || wantLegacy) {
+        con->defer_http_response();
+        onFinished = [this, hdl, wantJpeg](const RenderJobInfo& info, const std::vector<unsigned char>& jpeg) {
+            try {
+                auto deferred = wsServer->get_con_from_hdl(hdl);
+                if (info.state != RenderJobState::Done) {
+                    std::string error = info.error.empty() ? RenderJobManager::stateName(info.state) : info.error;
+                    sendHttpResponse(hdl, 500, "{\"success\":false,\"error\":\"" + error + "\"}", "application/json", true);
+                } else if (wantJpeg) {
+                    sendHttpBinaryResponse(hdl, std::string(jpeg.begin(), jpeg.end()), "image/jpeg", "no-store");
+                } else {
+                    std::string b64 = photoBoothServer->getGPhotoWrapper()->base64Encode(jpeg);
+                    std::string url = RenderJobManager::outputUrl(info.outputPath);
+                    const std::string outputsJson = info.outputs.empty() ? "" : ",\"outputs\":" + renderOutputsJson(info.outputs);
+                    sendHttpResponse(hdl, 200, "{\"success\":true,\"output\":\"" + b64 + "\",\"path\":\"" + url +
+                                     "\",\"url\":\"" + url + "\"" + outputsJson + "}", "application/json", true);
+                }
+                deferred->send_http_response();
+            } catch (const std::exception& e) {
+                std::cerr << "Error sending deferred render response: " << e.what() << std::endl;
             }
-            if (std::regex_search(obj, mm, xRegex)) ts.x = (float)std::stof(mm[1].str());
-            if (std::regex_search(obj, mm, yRegex)) ts.y = (float)std::stof(mm[1].str());
-            spec.texts.push_back(ts);
+        };
+    }
+
+    std::string jobId;
+    if (!renderJobs->submit(layout, photoPaths, jobId, onFinished, outputs)) {
+        sendHttpResponse(hdl, 503, "{\"success\":false,\"error\":\"queue_full\"}", "application/json", true);
+        if (onFinished) con->send_http_response();
+        return;
+    }
+    std::cout << "🧾 Render job queued: " << jobId << std::endl;
+    if (onFinished) return;
+
+    RenderJobInfo info;
+    renderJobs->get(jobId, info);
+    const std::string outputsJson = info.outputs.empty() ? "" : ",\"outputs\":" + renderOutputsJson(info.outputs);
+    sendHttpResponse(hdl, 202, "{\"success\":true,\"jobId\":\"" + jobId + "\",\"status\":\"queued\",\"url\":\"" +
+                     RenderJobManager::outputUrl(info.outputPath) + "\"" + outputsJson + "}", "application/json", true);
+}
+
+// Mode preview: layout yang sama dirender ~800px sebagai job preview (jalur cepat di pool render)
+// dan dikembalikan lewat deferred response, sementara render resolusi penuh berjalan sebagai job
+// biasa (render-done saat siap). Thread I/O tidak pernah ikut merender
+void WebSocketServer::handleHttpRenderPreview(connection_hdl hdl, const std::shared_ptr<const CompiledLayout>& layout,
+                                              const std::vector<std::string>& photoPaths, bool wantJpeg) {
+    std::string jobId;
+    if (!renderJobs->submit(layout, photoPaths, jobId)) {
+        sendHttpResponse(hdl, 503, "{\"success\":false,\"error\":\"queue_full\"}", "application/json", true);
+        return;
+    }
+    RenderJobInfo info;
+    renderJobs->get(jobId, info);
+    const std::string fullUrl = RenderJobManager::outputUrl(info.outputPath);
+
+    auto preview = templateCache->get(TemplateRenderer::previewKey(layout->key));
+    if (!preview) {
+        preview = TemplateRenderer::previewLayout(*layout);
+        templateCache->put(preview);
+    }
+
+    // Preview gagal bukan alasan membatalkan render penuh yang sudah antri
+    auto respond = [this, hdl, jobId, fullUrl, wantJpeg](const std::vector<unsigned char>* jpeg, const std::string& previewPath) {
+        if (!jpeg) {
+            sendHttpResponse(hdl, 202, "{\"success\":true,\"jobId\":\"" + jobId + "\",\"status\":\"queued\",\"url\":\"" +
+                             fullUrl + "\"}", "application/json", true);
+        } else if (wantJpeg) {
+            auto con = wsServer->get_con_from_hdl(hdl);
+            con->replace_header("X-Render-Job", jobId);
+            con->replace_header("Access-Control-Expose-Headers", "X-Render-Job");
+            sendHttpBinaryResponse(hdl, std::string(jpeg->begin(), jpeg->end()), "image/jpeg", "no-store");
+        } else {
+            sendHttpResponse(hdl, 202, "{\"success\":true,\"jobId\":\"" + jobId + "\",\"status\":\"queued\",\"url\":\"" + fullUrl +
+                             "\",\"preview\":\"" + RenderJobManager::outputUrl(previewPath) + "\"}", "application/json", true);
         }
+    };
+
+    const std::string renderKey = RenderCache::makeKey(*preview, photoPaths);
+    std::shared_ptr<const std::vector<unsigned char>> cached;
+    if (renderCache->lookup(renderKey, &cached)) {
+        respond(cached.get(), renderCache->pathFor(renderKey));
+        return;
     }
 
-    if (photoPath.size() && photoPath[0] == '/') photoPath = photoPath.substr(1);
-    std::string outFile = "outputs/render_" + std::to_string(std::time(nullptr)) + ".jpg";
+    auto con = wsServer->get_con_from_hdl(hdl);
+    con->defer_http_response();
+    RenderJobManager::Completion onFinished = [this, hdl, respond](const RenderJobInfo& done, const std::vector<unsigned char>& jpeg) {
+        try {
+            auto deferred = wsServer->get_con_from_hdl(hdl);
+            respond(done.state == RenderJobState::Done ? &jpeg : nullptr, done.outputPath);
+            deferred->send_http_response();
+        } catch (const std::exception& e) {
+            std::cerr << "Error sending deferred preview response: " << e.what() << std::endl;
+        }
+    };
+    std::string previewJobId;
+    if (!renderJobs->submit(preview, photoPaths, previewJobId, onFinished, std::vector<RenderOutput>(), true)) {
+        respond(nullptr, "");
+        con->send_http_response();
+    }
+}
 
-    TemplateRenderer renderer;
-    std::vector<unsigned char> jpeg;
-    bool ok = renderer.renderToJpegBuffer(spec, photoPath, outW, outH, jpeg);
-    if (!ok) {
-        sendHttpResponse(hdl, 500, "{\"success\":false,\"error\":\"render_failed\"}", "application/json", true);
+void WebSocketServer::handleHttpRenderJobRequest(connection_hdl hdl, const std::string& method, const std::string& jobId) {
+    if (method == "DELETE") {
+        if (!renderJobs->cancel(jobId)) {
+            sendHttpResponse(hdl, 404, "{\"success\":false,\"error\":\"job_not_found\"}", "application/json", true);
+            return;
+        }
+        sendHttpResponse(hdl, 200, "{\"success\":true,\"jobId\":\"" + jobId + "\"}", "application/json", true);
         return;
     }
-    std::ofstream ofs(outFile, std::ios::binary);
-    if (ofs.is_open()) { ofs.write(reinterpret_cast<const char*>(jpeg.data()), (std::streamsize)jpeg.size()); ofs.close(); }
-    std::string b64 = this->photoBoothServer->getGPhotoWrapper()->base64Encode(jpeg);
-    std::string resp = std::string("{\"success\":true,\"output\":\"") + b64 + "\",\"path\":\"/" + outFile + "\"}";
-    sendHttpResponse(hdl, 200, resp, "application/json", true);
-}
\ No newline at end of file
+    RenderJobInfo info;
+    if (!renderJobs->get(jobId, info)) {
+        sendHttpResponse(hdl, 404, "{\"success\":false,\"error\":\"job_not_found\"}", "application/json", true);
+        return;
+    }
+    sendHttpResponse(hdl, 200, RenderJobManager::toJson(info), "application/json", true);
+}